@@ -0,0 +1,186 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "./BenchSession.hpp"
+
+#include "oatpp/network/tcp/client/ConnectionProvider.hpp"
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/data/stream/BufferStream.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+  /**
+   * Read `VmRSS` and `VmHWM` of the process in kB.
+   */
+  bool readProcessMemory(v_int64 pid, v_int64& rssKb, v_int64& peakKb) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/status");
+    if(!file.is_open()) {
+      return false;
+    }
+    rssKb = -1;
+    peakKb = -1;
+    std::string line;
+    while(std::getline(file, line)) {
+      if(line.compare(0, 6, "VmRSS:") == 0) {
+        rssKb = std::stoll(line.substr(6));
+      } else if(line.compare(0, 6, "VmHWM:") == 0) {
+        peakKb = std::stoll(line.substr(6));
+      }
+    }
+    return rssKb >= 0;
+  }
+
+  void sleepSeconds(v_int32 seconds) {
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+  }
+
+}
+
+void run(const BenchConfig& config) {
+
+  auto executor = std::make_shared<oatpp::async::Executor>(config.threads, 1, 1);
+
+  auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+  objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+
+  auto hostConnector = oatpp::websocket::Connector::createShared(
+    oatpp::network::tcp::client::ConnectionProvider::createShared({config.host, config.hostPort, oatpp::network::Address::IP_4}));
+  auto clientConnector = oatpp::websocket::Connector::createShared(
+    oatpp::network::tcp::client::ConnectionProvider::createShared({config.host, config.clientPort, oatpp::network::Address::IP_4}));
+
+  auto stats = std::make_shared<BenchStats>();
+
+  /* sessions */
+
+  std::vector<std::shared_ptr<BenchSession>> sessions;
+  auto runId = std::to_string(getpid());
+
+  for(auto& gameId : config.gameIds) {
+    for(v_int32 i = 0; i < config.sessions; i ++) {
+      auto sessionId = oatpp::String("bench-" + runId + "-" + std::to_string(sessions.size()));
+      auto session = std::make_shared<BenchSession>(&config, gameId, sessionId, executor, objectMapper, clientConnector, stats);
+      sessions.push_back(session);
+      session->connect(hostConnector);
+    }
+  }
+
+  v_int64 totalPeers = (v_int64) sessions.size() * config.peers;
+
+  auto connectDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(config.connectTimeoutSeconds);
+  while(stats->getConnectedPeers() + stats->getFailedPeers() < totalPeers && std::chrono::steady_clock::now() < connectDeadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  OATPP_LOGI("Bench", "%lld/%lld peers connected, %lld failed", stats->getConnectedPeers(), totalPeers, stats->getFailedPeers())
+
+  if(stats->getConnectedPeers() == 0) {
+    OATPP_LOGE("Bench", "No peers connected. Is the server running at %s:%d/%d?",
+               config.host->c_str(), config.hostPort, config.clientPort)
+  } else {
+
+    /* traffic */
+
+    for(auto& session : sessions) {
+      session->startTraffic();
+    }
+
+    OATPP_LOGI("Bench", "Warmup %ds", config.warmupSeconds)
+    sleepSeconds(config.warmupSeconds);
+
+    OATPP_LOGI("Bench", "Measuring %ds", config.durationSeconds)
+    stats->startWindow();
+    sleepSeconds(config.durationSeconds);
+    stats->endWindow();
+
+    for(auto& session : sessions) {
+      session->stopTraffic();
+    }
+
+    sleepSeconds(config.drainSeconds);
+
+    /* report */
+
+    oatpp::data::stream::BufferOutputStream report;
+    report << "\nhelicopter-bench: " << (v_int64) config.gameIds.size() << " games x " << config.sessions << " sessions x "
+           << config.peers << " peers, " << config.rate << " msgs/s per peer, " << config.payloadBytes << " bytes, mix";
+    for(v_int32 i = 0; i < BenchConfig::KINDS_COUNT; i ++) {
+      report << " " << BenchConfig::getKindName(i) << ":" << config.mix[i];
+    }
+    report << "\n\n";
+    stats->writeReport(&report);
+
+    if(config.serverPid > 0) {
+      v_int64 rssKb, peakKb;
+      if(readProcessMemory(config.serverPid, rssKb, peakKb)) {
+        report << "server RSS:      " << rssKb << " kB, peak " << peakKb << " kB\n";
+      } else {
+        report << "server RSS:      n/a - can't read /proc/" << config.serverPid << "/status\n";
+      }
+    }
+
+    std::cout << report.toString()->c_str() << std::endl;
+
+  }
+
+  for(auto& session : sessions) {
+    session->close();
+  }
+
+  executor->waitTasksFinished(std::chrono::seconds(5));
+  executor->stop();
+  executor->join();
+
+}
+
+int main(int argc, const char * argv[]) {
+
+  oatpp::base::Environment::init();
+
+  oatpp::base::CommandLineArguments args(argc, argv);
+
+  if(args.hasArgument("--help")) {
+    std::cout << BenchConfig::USAGE;
+  } else {
+    try {
+      auto config = BenchConfig::parse(args);
+      run(config);
+    } catch (const std::runtime_error& e) {
+      std::cerr << e.what() << "\n\n" << BenchConfig::USAGE;
+      oatpp::base::Environment::destroy();
+      return 1;
+    }
+  }
+
+  oatpp::base::Environment::destroy();
+
+  return 0;
+}
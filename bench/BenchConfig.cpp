@@ -0,0 +1,155 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "BenchConfig.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+  const char* const KIND_NAMES[BenchConfig::KINDS_COUNT] = {"broadcast", "direct", "host", "sync"};
+
+  std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> result;
+    std::string::size_type start = 0;
+    while(start <= text.size()) {
+      auto end = text.find(separator, start);
+      if(end == std::string::npos) {
+        end = text.size();
+      }
+      if(end > start) {
+        result.push_back(text.substr(start, end - start));
+      }
+      start = end + 1;
+    }
+    return result;
+  }
+
+  v_int64 getInt(const oatpp::base::CommandLineArguments& args, const char* name, v_int64 defaultValue, v_int64 minValue) {
+    if(!args.hasArgument(name)) {
+      return defaultValue;
+    }
+    bool success;
+    v_int64 value = oatpp::utils::conversion::strToInt64(args.getNamedArgumentValue(name, ""), success);
+    if(!success || value < minValue) {
+      throw std::runtime_error(std::string("[BenchConfig]: Invalid value of '") + name + "'");
+    }
+    return value;
+  }
+
+}
+
+const char* const BenchConfig::USAGE =
+  "Usage: helicopter-bench [options]\n"
+  "  --host <host>                 server host (127.0.0.1)\n"
+  "  --host-port <port>            host API port (8000)\n"
+  "  --client-port <port>          client API port (8001)\n"
+  "  --games <id,id,...>           game IDs from the server's games config (snake)\n"
+  "  --sessions <M>                sessions per game (10)\n"
+  "  --peers <K>                   peers per session including host (4)\n"
+  "  --rate <R>                    messages per second per peer (10)\n"
+  "  --payload <bytes>             size of message data (64)\n"
+  "  --mix <kind:weight,...>       traffic mix - kinds: broadcast, direct, host, sync (broadcast:40,direct:30,host:20,sync:10)\n"
+  "  --warmup <seconds>            not measured run before the measurement (5)\n"
+  "  --duration <seconds>          measurement duration (30)\n"
+  "  --drain <seconds>             wait for in-flight messages after traffic stopped (2)\n"
+  "  --connect-timeout <seconds>   time to connect all peers (30)\n"
+  "  --threads <N>                 load generator threads (4)\n"
+  "  --max-queued <N>              max messages queued per peer on the client side (1024)\n"
+  "  --server-pid <pid>            report RSS of the local server process\n";
+
+BenchConfig BenchConfig::parse(const oatpp::base::CommandLineArguments& args) {
+
+  BenchConfig config;
+
+  config.host = args.getNamedArgumentValue("--host", "127.0.0.1");
+  config.hostPort = (v_uint16) getInt(args, "--host-port", config.hostPort, 1);
+  config.clientPort = (v_uint16) getInt(args, "--client-port", config.clientPort, 1);
+
+  for(auto& gameId : split(args.getNamedArgumentValue("--games", "snake"), ',')) {
+    config.gameIds.push_back(gameId.c_str());
+  }
+  if(config.gameIds.empty()) {
+    throw std::runtime_error("[BenchConfig]: Invalid value of '--games'");
+  }
+
+  config.sessions = (v_int32) getInt(args, "--sessions", config.sessions, 1);
+  config.peers = (v_int32) getInt(args, "--peers", config.peers, 1);
+
+  if(args.hasArgument("--rate")) {
+    bool success;
+    config.rate = oatpp::utils::conversion::strToFloat64(args.getNamedArgumentValue("--rate", ""), success);
+    if(!success || config.rate < 0) {
+      throw std::runtime_error("[BenchConfig]: Invalid value of '--rate'");
+    }
+  }
+
+  /* data carries the send timestamp - at least 24 bytes */
+  config.payloadBytes = (v_int32) getInt(args, "--payload", config.payloadBytes, 24);
+
+  if(args.hasArgument("--mix")) {
+    for(v_int32 i = 0; i < KINDS_COUNT; i ++) {
+      config.mix[i] = 0;
+    }
+    for(auto& entry : split(args.getNamedArgumentValue("--mix", ""), ',')) {
+      auto pair = split(entry, ':');
+      v_int32 kind = -1;
+      for(v_int32 i = 0; i < KINDS_COUNT; i ++) {
+        if(pair.size() == 2 && pair[0] == KIND_NAMES[i]) {
+          kind = i;
+        }
+      }
+      bool success = false;
+      v_int32 weight = kind >= 0 ? oatpp::utils::conversion::strToInt32(pair[1].c_str(), success) : 0;
+      if(!success || weight < 0) {
+        throw std::runtime_error("[BenchConfig]: Invalid value of '--mix' - '" + entry + "'");
+      }
+      config.mix[kind] = weight;
+    }
+  }
+
+  config.warmupSeconds = (v_int32) getInt(args, "--warmup", config.warmupSeconds, 0);
+  config.durationSeconds = (v_int32) getInt(args, "--duration", config.durationSeconds, 1);
+  config.drainSeconds = (v_int32) getInt(args, "--drain", config.drainSeconds, 0);
+  config.connectTimeoutSeconds = (v_int32) getInt(args, "--connect-timeout", config.connectTimeoutSeconds, 1);
+  config.threads = (v_int32) getInt(args, "--threads", config.threads, 1);
+  config.maxQueuedMessages = (v_int32) getInt(args, "--max-queued", config.maxQueuedMessages, 1);
+  config.serverPid = getInt(args, "--server-pid", config.serverPid, 1);
+
+  return config;
+
+}
+
+const char* BenchConfig::getKindName(v_int32 kind) {
+  if(kind >= 0 && kind < KINDS_COUNT) {
+    return KIND_NAMES[kind];
+  }
+  return "unknown";
+}
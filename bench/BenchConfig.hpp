@@ -0,0 +1,131 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_bench_BenchConfig_hpp
+#define Helicopter_bench_BenchConfig_hpp
+
+#include "oatpp/core/base/CommandLineArguments.hpp"
+#include "oatpp/core/Types.hpp"
+
+#include <vector>
+
+/**
+ * Load generator config. Parsed from command line.
+ */
+struct BenchConfig {
+
+  /**
+   * Kinds of generated messages.
+   */
+  enum Kind : v_int32 {
+    KIND_BROADCAST = 0,
+    KIND_DIRECT = 1,
+    KIND_TO_HOST = 2,
+    KIND_SYNCHRONIZED = 3,
+    KINDS_COUNT = 4
+  };
+
+  oatpp::String host = "127.0.0.1";
+  v_uint16 hostPort = 8000;
+  v_uint16 clientPort = 8001;
+
+  /**
+   * Games to create sessions in. Must be present in the server's games config.
+   */
+  std::vector<oatpp::String> gameIds;
+
+  /**
+   * Sessions per game.
+   */
+  v_int32 sessions = 10;
+
+  /**
+   * Peers per session including host.
+   */
+  v_int32 peers = 4;
+
+  /**
+   * Messages per second sent by each peer.
+   */
+  v_float64 rate = 10;
+
+  /**
+   * Size of message data.
+   */
+  v_int32 payloadBytes = 64;
+
+  /**
+   * Weights of message kinds in the generated traffic. Indexed by `Kind`.
+   */
+  v_int32 mix[KINDS_COUNT] = {40, 30, 20, 10};
+
+  v_int32 warmupSeconds = 5;
+  v_int32 durationSeconds = 30;
+
+  /**
+   * Time to wait for in-flight messages after traffic stopped.
+   */
+  v_int32 drainSeconds = 2;
+  v_int32 connectTimeoutSeconds = 30;
+
+  /**
+   * Processor threads of the load generator's executor.
+   */
+  v_int32 threads = 4;
+
+  /**
+   * Max messages waiting to be written per peer. Messages over the limit are dropped on the client side.
+   */
+  v_int32 maxQueuedMessages = 1024;
+
+  /**
+   * PID of the local helicopter server to report RSS of. `-1` - don't report.
+   */
+  v_int64 serverPid = -1;
+
+  /**
+   * Parse config from command line.
+   * Throws `std::runtime_error` on invalid arguments.
+   * @param args
+   * @return
+   */
+  static BenchConfig parse(const oatpp::base::CommandLineArguments& args);
+
+  /**
+   * Get name of the message kind.
+   * @param kind
+   * @return
+   */
+  static const char* getKindName(v_int32 kind);
+
+  /**
+   * Usage text.
+   */
+  static const char* const USAGE;
+
+};
+
+#endif //Helicopter_bench_BenchConfig_hpp
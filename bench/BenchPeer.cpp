@@ -0,0 +1,333 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "BenchPeer.hpp"
+
+#include <cstdlib>
+
+BenchPeer::BenchPeer(const std::shared_ptr<oatpp::async::Executor>& executor,
+                     const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                     const std::shared_ptr<BenchStats>& stats,
+                     const std::shared_ptr<Handler>& handler,
+                     bool isHost,
+                     v_int64 maxQueuedMessages)
+  : m_executor(executor)
+  , m_objectMapper(objectMapper)
+  , m_stats(stats)
+  , m_handler(handler)
+  , m_maxQueuedMessages(maxQueuedMessages)
+  , m_isHost(isHost)
+  , m_outbox(std::make_shared<Outbox>())
+  , m_peerId(-1)
+  , m_answerPings(true)
+  , m_closed(false)
+{}
+
+void BenchPeer::connect(const std::shared_ptr<oatpp::websocket::Connector>& connector, const oatpp::String& path) {
+
+  class ConnectCoroutine : public oatpp::async::Coroutine<ConnectCoroutine> {
+  private:
+    std::shared_ptr<oatpp::websocket::Connector> m_connector;
+    oatpp::String m_path;
+    std::shared_ptr<BenchPeer> m_peer;
+  public:
+
+    ConnectCoroutine(const std::shared_ptr<oatpp::websocket::Connector>& connector,
+                     const oatpp::String& path,
+                     const std::shared_ptr<BenchPeer>& peer)
+      : m_connector(connector)
+      , m_path(path)
+      , m_peer(peer)
+    {}
+
+    Action act() override {
+      return m_connector->connectAsync(m_path).callbackTo(&ConnectCoroutine::onConnected);
+    }
+
+    Action onConnected(const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& connection) {
+      auto socket = oatpp::websocket::AsyncWebSocket::createShared(connection, true /* maskOutgoingMessages for clients always true */);
+      socket->setListener(m_peer);
+      m_peer->setSocket(socket);
+      return socket->listenAsync().next(yieldTo(&ConnectCoroutine::onFinished));
+    }
+
+    Action onFinished() {
+      m_peer->close();
+      return finish();
+    }
+
+    Action handleError(oatpp::async::Error* error) override {
+      m_peer->close();
+      return finish();
+    }
+
+  };
+
+  m_executor->execute<ConnectCoroutine>(connector, path, shared_from_this());
+
+}
+
+void BenchPeer::setSocket(const std::shared_ptr<AsyncWebSocket>& socket) {
+  {
+    std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    if(m_closed) {
+      socket->getConnection().invalidate();
+      return;
+    }
+    m_socket = socket;
+  }
+  std::lock_guard<std::mutex> lock(m_outbox->mutex);
+  startSending();
+}
+
+void BenchPeer::startSending() {
+
+  class SendMessagesCoroutine : public oatpp::async::Coroutine<SendMessagesCoroutine> {
+  private:
+    oatpp::async::Lock* m_lock;
+    std::shared_ptr<AsyncWebSocket> m_websocket;
+    std::shared_ptr<Outbox> m_outbox;
+  public:
+
+    SendMessagesCoroutine(oatpp::async::Lock* lock,
+                          const std::shared_ptr<AsyncWebSocket>& websocket,
+                          const std::shared_ptr<Outbox>& outbox)
+      : m_lock(lock)
+      , m_websocket(websocket)
+      , m_outbox(outbox)
+    {}
+
+    Action act() override {
+
+      std::unique_lock<std::mutex> lock(m_outbox->mutex);
+      if(m_outbox->queue.empty()) {
+        m_outbox->active = false;
+        return finish();
+      }
+      auto message = m_outbox->queue.back();
+      m_outbox->queue.pop_back();
+      lock.unlock();
+
+      return oatpp::async::synchronize(m_lock, m_websocket->sendOneFrameTextAsync(message)).next(repeat());
+
+    }
+
+    Action handleError(oatpp::async::Error* error) override {
+      std::lock_guard<std::mutex> lock(m_outbox->mutex);
+      m_outbox->queue.clear();
+      m_outbox->active = false;
+      return finish();
+    }
+
+  };
+
+  /* m_outbox->mutex is locked by caller */
+  if(!m_outbox->active && !m_outbox->queue.empty()) {
+    std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    if(m_socket) {
+      m_outbox->active = true;
+      m_executor->execute<SendMessagesCoroutine>(&m_writeLock, m_socket, m_outbox);
+    }
+  }
+
+}
+
+bool BenchPeer::send(const oatpp::String& message) {
+
+  if(m_closed) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_outbox->mutex);
+  if((v_int64) m_outbox->queue.size() >= m_maxQueuedMessages) {
+    return false;
+  }
+  m_outbox->queue.push_front(message);
+  startSending();
+  return true;
+
+}
+
+void BenchPeer::close() {
+
+  if(m_closed.exchange(true)) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    if(m_socket) {
+      m_socket->getConnection().invalidate();
+      m_socket.reset();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_outbox->mutex);
+    m_outbox->queue.clear();
+  }
+
+  m_stats->onPeerClosed(m_peerId >= 0);
+
+  auto handler = m_handler.lock();
+  if(handler) {
+    handler->onClosed(shared_from_this());
+  }
+
+}
+
+void BenchPeer::setAnswerPings(bool answerPings) {
+  m_answerPings = answerPings;
+}
+
+v_int64 BenchPeer::getPeerId() const {
+  return m_peerId;
+}
+
+bool BenchPeer::isHost() const {
+  return m_isHost;
+}
+
+bool BenchPeer::isClosed() const {
+  return m_closed;
+}
+
+void BenchPeer::onMessage(const oatpp::Object<MessageDto>& message, v_int64 bytes, v_int64 receivedTimestamp) {
+
+  oatpp::String data;
+
+  switch(*message->code) {
+
+    case MessageCodes::OUTGOING_HELLO: {
+      auto hello = message->payload.retrieve<oatpp::Object<HelloMessageDto>>();
+      if(hello && hello->peerId) {
+        m_peerId = *hello->peerId;
+        m_stats->onPeerConnected();
+        auto handler = m_handler.lock();
+        if(handler) {
+          handler->onHello(shared_from_this());
+        }
+      }
+      return;
+    }
+
+    case MessageCodes::OUTGOING_NEW_HOST: {
+      auto hostPeerId = message->payload.retrieve<oatpp::Int64>();
+      auto handler = m_handler.lock();
+      if(hostPeerId && handler) {
+        handler->onNewHost(shared_from_this(), *hostPeerId);
+      }
+      return;
+    }
+
+    case MessageCodes::OUTGOING_ERROR:
+      m_stats->onServerError();
+      return;
+
+    case MessageCodes::OUTGOING_MESSAGE: {
+      auto payload = message->payload.retrieve<oatpp::Object<OutgoingMessageDto>>();
+      if(payload) {
+        data = payload->data;
+      }
+      m_stats->onReceived(bytes, false);
+      break;
+    }
+
+    case MessageCodes::OUTGOING_SYNCHRONIZED_EVENT: {
+      auto payload = message->payload.retrieve<oatpp::Object<OutgoingSynchronizedMessageDto>>();
+      if(payload) {
+        data = payload->data;
+      }
+      m_stats->onReceived(bytes, true);
+      break;
+    }
+
+    default:
+      return;
+
+  }
+
+  /* generated data starts with the send timestamp */
+  if(data) {
+    v_int64 sentTimestamp = std::strtoll(data->c_str(), nullptr, 10);
+    if(sentTimestamp > 0) {
+      m_stats->onDelivered(sentTimestamp, receivedTimestamp, bytes);
+    }
+  }
+
+}
+
+oatpp::async::CoroutineStarter BenchPeer::onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) {
+  return oatpp::async::synchronize(&m_writeLock, socket->sendPongAsync(message));
+}
+
+oatpp::async::CoroutineStarter BenchPeer::onPong(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) {
+  return nullptr; // do nothing
+}
+
+oatpp::async::CoroutineStarter BenchPeer::onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) {
+  return nullptr; // do nothing
+}
+
+oatpp::async::CoroutineStarter BenchPeer::readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) {
+
+  if(size == 0) { // message transfer finished
+
+    v_int64 receivedTimestamp = oatpp::base::Environment::getMicroTickCount();
+    auto wholeMessage = m_messageBuffer.toString();
+    m_messageBuffer.setCurrentPosition(0);
+
+    oatpp::Object<MessageDto> message;
+
+    try {
+      message = m_objectMapper->readFromString<oatpp::Object<MessageDto>>(wholeMessage);
+    } catch (const std::runtime_error& e) {
+      m_stats->onServerError();
+      return nullptr;
+    }
+
+    if(!message || !message->code) {
+      return nullptr;
+    }
+
+    /* application-level ping - respond with the same payload */
+    if(*message->code == MessageCodes::OUTGOING_PING) {
+      if(!m_answerPings) {
+        return nullptr;
+      }
+      auto pong = MessageDto::createShared(MessageCodes::INCOMING_PONG, message->payload);
+      return oatpp::async::synchronize(&m_writeLock, socket->sendOneFrameTextAsync(m_objectMapper->writeToString(pong)));
+    }
+
+    onMessage(message, wholeMessage->size(), receivedTimestamp);
+
+  } else if(size > 0) { // message frame received
+    m_messageBuffer.writeSimple(data, size);
+  }
+
+  return nullptr;
+
+}
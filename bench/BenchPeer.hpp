@@ -0,0 +1,184 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_bench_BenchPeer_hpp
+#define Helicopter_bench_BenchPeer_hpp
+
+#include "./BenchStats.hpp"
+
+#include "dto/DTOs.hpp"
+
+#include "oatpp-websocket/AsyncWebSocket.hpp"
+#include "oatpp-websocket/Connector.hpp"
+
+#include "oatpp/core/async/Lock.hpp"
+#include "oatpp/core/async/Executor.hpp"
+#include "oatpp/core/data/mapping/ObjectMapper.hpp"
+#include "oatpp/core/data/stream/BufferStream.hpp"
+
+#include <list>
+#include <mutex>
+
+/**
+ * Simulated peer of the load generator.
+ * Connects to the server, answers pings and measures delivery latency of received messages.
+ * Messages are sent from the outbox by a single coroutine - `send()` never blocks.
+ */
+class BenchPeer : public oatpp::websocket::AsyncWebSocket::Listener, public std::enable_shared_from_this<BenchPeer> {
+public:
+
+  /**
+   * Receiver of peer events.
+   */
+  class Handler {
+  public:
+
+    /**
+     * Default virtual destructor.
+     */
+    virtual ~Handler() = default;
+
+    /**
+     * Called when peer received hello from server.
+     * @param peer
+     */
+    virtual void onHello(const std::shared_ptr<BenchPeer>& peer) = 0;
+
+    /**
+     * Called when server promoted a new host.
+     * @param peer
+     * @param hostPeerId
+     */
+    virtual void onNewHost(const std::shared_ptr<BenchPeer>& peer, v_int64 hostPeerId) = 0;
+
+    /**
+     * Called once when peer failed to connect or was disconnected.
+     * @param peer
+     */
+    virtual void onClosed(const std::shared_ptr<BenchPeer>& peer) = 0;
+
+  };
+
+private:
+
+  struct Outbox {
+    std::list<oatpp::String> queue;
+    std::mutex mutex;
+    bool active = false;
+  };
+
+private:
+  std::shared_ptr<oatpp::async::Executor> m_executor;
+  std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper;
+  std::shared_ptr<BenchStats> m_stats;
+  std::weak_ptr<Handler> m_handler;
+  v_int64 m_maxQueuedMessages;
+  bool m_isHost;
+private:
+  oatpp::data::stream::BufferOutputStream m_messageBuffer;
+  oatpp::async::Lock m_writeLock;
+  std::shared_ptr<AsyncWebSocket> m_socket;
+  std::shared_ptr<Outbox> m_outbox;
+  std::atomic<v_int64> m_peerId;
+  std::atomic<bool> m_answerPings;
+  std::atomic<bool> m_closed;
+  std::mutex m_socketMutex;
+private:
+  void setSocket(const std::shared_ptr<AsyncWebSocket>& socket);
+  void startSending();
+  void onMessage(const oatpp::Object<MessageDto>& message, v_int64 bytes, v_int64 receivedTimestamp);
+public:
+
+  /**
+   * Constructor.
+   * @param executor - executor to run peer coroutines on.
+   * @param objectMapper - object mapper to encode/decode messages.
+   * @param stats - counters.
+   * @param handler - receiver of peer events.
+   * @param isHost - peer creates the game session.
+   * @param maxQueuedMessages - max messages waiting to be sent. Messages over the limit are dropped.
+   */
+  BenchPeer(const std::shared_ptr<oatpp::async::Executor>& executor,
+            const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+            const std::shared_ptr<BenchStats>& stats,
+            const std::shared_ptr<Handler>& handler,
+            bool isHost,
+            v_int64 maxQueuedMessages);
+
+  /**
+   * Connect to the server.
+   * @param connector
+   * @param path - `api/create-game/?...` or `api/join-game/?...`.
+   */
+  void connect(const std::shared_ptr<oatpp::websocket::Connector>& connector, const oatpp::String& path);
+
+  /**
+   * Queue encoded message.
+   * @param message
+   * @return - `false` if message was dropped.
+   */
+  bool send(const oatpp::String& message);
+
+  /**
+   * Close connection.
+   */
+  void close();
+
+  /**
+   * Enable/disable answering server pings. Enabled by default.
+   * Peer which doesn't answer pings is dropped by server after `maxFailedPings`.
+   * @param answerPings
+   */
+  void setAnswerPings(bool answerPings);
+
+  /**
+   * Get peer ID assigned by server.
+   * @return - `-1` if hello is not received yet.
+   */
+  v_int64 getPeerId() const;
+
+  /**
+   * Check if peer connected as host.
+   * @return
+   */
+  bool isHost() const;
+
+  /**
+   * Check if peer is closed.
+   * @return
+   */
+  bool isClosed() const;
+
+public: // WebSocket Listener
+
+  CoroutineStarter onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
+  CoroutineStarter onPong(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
+  CoroutineStarter onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) override;
+  CoroutineStarter readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) override;
+
+};
+
+#endif //Helicopter_bench_BenchPeer_hpp
@@ -0,0 +1,291 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "BenchSession.hpp"
+
+#include "Constants.hpp"
+
+#include <algorithm>
+
+BenchSession::BenchSession(const BenchConfig* config,
+                           const oatpp::String& gameId,
+                           const oatpp::String& sessionId,
+                           const std::shared_ptr<oatpp::async::Executor>& executor,
+                           const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                           const std::shared_ptr<oatpp::websocket::Connector>& clientConnector,
+                           const std::shared_ptr<BenchStats>& stats)
+  : m_config(config)
+  , m_gameId(gameId)
+  , m_sessionId(sessionId)
+  , m_executor(executor)
+  , m_objectMapper(objectMapper)
+  , m_clientConnector(clientConnector)
+  , m_stats(stats)
+  , m_hostPeerId(-1)
+  , m_running(std::make_shared<std::atomic<bool>>(false))
+{}
+
+oatpp::String BenchSession::createData(v_int64 timestamp) {
+  std::string data = std::to_string(timestamp);
+  data.push_back('|');
+  if((v_int32) data.size() < m_config->payloadBytes) {
+    data.resize(m_config->payloadBytes, 'x');
+  }
+  return oatpp::String(std::move(data));
+}
+
+v_int32 BenchSession::pickKind(std::minstd_rand& random) {
+
+  v_int32 total = 0;
+  for(v_int32 i = 0; i < BenchConfig::KINDS_COUNT; i ++) {
+    total += m_config->mix[i];
+  }
+  if(total <= 0) {
+    return BenchConfig::KIND_BROADCAST;
+  }
+
+  v_int32 value = (v_int32) (random() % total);
+  for(v_int32 i = 0; i < BenchConfig::KINDS_COUNT; i ++) {
+    if(value < m_config->mix[i]) {
+      return i;
+    }
+    value -= m_config->mix[i];
+  }
+  return BenchConfig::KIND_BROADCAST;
+
+}
+
+void BenchSession::connect(const std::shared_ptr<oatpp::websocket::Connector>& hostConnector) {
+
+  auto host = std::make_shared<BenchPeer>(m_executor, m_objectMapper, m_stats, shared_from_this(), true,
+                                          m_config->maxQueuedMessages);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_peers.push_back(host);
+  }
+
+  host->connect(hostConnector, oatpp::String("api/create-game/?") +
+                               Constants::PARAM_GAME_ID + "=" + m_gameId + "&" +
+                               Constants::PARAM_GAME_SESSION_ID + "=" + m_sessionId);
+
+}
+
+std::vector<std::shared_ptr<BenchPeer>> BenchSession::getPeers() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_peers;
+}
+
+void BenchSession::startTraffic() {
+
+  class TrafficCoroutine : public oatpp::async::Coroutine<TrafficCoroutine> {
+  private:
+    std::shared_ptr<BenchSession> m_session;
+    std::shared_ptr<BenchPeer> m_peer;
+    std::shared_ptr<std::atomic<bool>> m_running;
+    v_int64 m_intervalMicros;
+    std::minstd_rand m_random;
+    bool m_started;
+  public:
+
+    TrafficCoroutine(const std::shared_ptr<BenchSession>& session,
+                     const std::shared_ptr<BenchPeer>& peer,
+                     const std::shared_ptr<std::atomic<bool>>& running,
+                     v_int64 intervalMicros)
+      : m_session(session)
+      , m_peer(peer)
+      , m_running(running)
+      , m_intervalMicros(intervalMicros)
+      , m_random((std::minstd_rand::result_type) (peer->getPeerId() + 1))
+      , m_started(false)
+    {}
+
+    Action act() override {
+
+      if(!m_running->load(std::memory_order_relaxed) || m_peer->isClosed()) {
+        return finish();
+      }
+
+      if(!m_started) {
+        /* spread peers over the interval */
+        m_started = true;
+        return waitRepeat(std::chrono::microseconds(m_random() % m_intervalMicros));
+      }
+
+      m_session->sendNext(m_peer, m_random);
+      return waitRepeat(std::chrono::microseconds(m_intervalMicros));
+
+    }
+
+  };
+
+  if(m_config->rate <= 0 || m_running->exchange(true)) {
+    return;
+  }
+
+  v_int64 intervalMicros = std::max<v_int64>(1, (v_int64) (1000000 / m_config->rate));
+
+  std::vector<std::shared_ptr<BenchPeer>> peers;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    peers = m_peers;
+  }
+
+  for(auto& peer : peers) {
+    if(peer->getPeerId() >= 0 && !peer->isClosed()) {
+      m_executor->execute<TrafficCoroutine>(shared_from_this(), peer, m_running, intervalMicros);
+    }
+  }
+
+}
+
+void BenchSession::stopTraffic() {
+  m_running->store(false);
+}
+
+void BenchSession::close() {
+
+  stopTraffic();
+
+  std::vector<std::shared_ptr<BenchPeer>> peers;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    peers = m_peers;
+  }
+
+  for(auto& peer : peers) {
+    peer->close();
+  }
+
+}
+
+void BenchSession::sendNext(const std::shared_ptr<BenchPeer>& peer, std::minstd_rand& random) {
+
+  v_int64 timestamp = oatpp::base::Environment::getMicroTickCount();
+  v_int64 peerId = peer->getPeerId();
+  v_int32 kind = pickKind(random);
+
+  v_int64 peersCount;
+  v_int64 hostPeerId;
+  v_int64 target = -1;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    peersCount = m_peerIds.size();
+    hostPeerId = m_hostPeerId;
+    if(kind == BenchConfig::KIND_DIRECT && peersCount > 1) {
+      do {
+        target = m_peerIds[random() % peersCount];
+      } while(target == peerId);
+    }
+  }
+
+  if((kind == BenchConfig::KIND_TO_HOST && (peerId == hostPeerId || hostPeerId < 0)) ||
+     (kind == BenchConfig::KIND_DIRECT && target < 0))
+  {
+    kind = BenchConfig::KIND_BROADCAST;
+  }
+
+  oatpp::Object<MessageDto> message;
+  v_int64 expectedDeliveries;
+
+  switch(kind) {
+
+    case BenchConfig::KIND_DIRECT: {
+      auto payload = DirectMessageDto::createShared();
+      payload->peerIds = oatpp::Vector<oatpp::Int64>({target});
+      payload->data = createData(timestamp);
+      message = MessageDto::createShared(MessageCodes::INCOMING_DIRECT_MESSAGE, payload);
+      expectedDeliveries = 1;
+      break;
+    }
+
+    case BenchConfig::KIND_TO_HOST:
+      message = MessageDto::createShared(MessageCodes::INCOMING_CLIENT_MESSAGE, createData(timestamp));
+      expectedDeliveries = 1;
+      break;
+
+    case BenchConfig::KIND_SYNCHRONIZED:
+      message = MessageDto::createShared(MessageCodes::INCOMING_SYNCHRONIZED_EVENT, createData(timestamp));
+      expectedDeliveries = peersCount;
+      break;
+
+    default:
+      message = MessageDto::createShared(MessageCodes::INCOMING_BROADCAST, createData(timestamp));
+      expectedDeliveries = peersCount - 1;
+
+  }
+
+  auto encoded = m_objectMapper->writeToString(message);
+
+  if(peer->send(encoded)) {
+    m_stats->onSent(timestamp, encoded->size(), expectedDeliveries);
+  } else {
+    m_stats->onClientDrop();
+  }
+
+}
+
+void BenchSession::onHello(const std::shared_ptr<BenchPeer>& peer) {
+
+  std::vector<std::shared_ptr<BenchPeer>> clients;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_peerIds.push_back(peer->getPeerId());
+    if(peer->isHost()) {
+      m_hostPeerId = peer->getPeerId();
+      for(v_int32 i = 1; i < m_config->peers; i ++) {
+        auto client = std::make_shared<BenchPeer>(m_executor, m_objectMapper, m_stats, shared_from_this(), false,
+                                                  m_config->maxQueuedMessages);
+        m_peers.push_back(client);
+        clients.push_back(client);
+      }
+    }
+  }
+
+  auto path = oatpp::String("api/join-game/?") +
+              Constants::PARAM_GAME_ID + "=" + m_gameId + "&" +
+              Constants::PARAM_GAME_SESSION_ID + "=" + m_sessionId;
+
+  for(auto& client : clients) {
+    client->connect(m_clientConnector, path);
+  }
+
+}
+
+void BenchSession::onNewHost(const std::shared_ptr<BenchPeer>& peer, v_int64 hostPeerId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_hostPeerId = hostPeerId;
+}
+
+void BenchSession::onClosed(const std::shared_ptr<BenchPeer>& peer) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = std::find(m_peerIds.begin(), m_peerIds.end(), peer->getPeerId());
+  if(it != m_peerIds.end()) {
+    m_peerIds.erase(it);
+  }
+}
@@ -0,0 +1,121 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_bench_BenchSession_hpp
+#define Helicopter_bench_BenchSession_hpp
+
+#include "./BenchConfig.hpp"
+#include "./BenchPeer.hpp"
+
+#include <random>
+
+/**
+ * Game session driven by the load generator - host and `peers - 1` clients.
+ * Clients join once the host received hello (session is created).
+ */
+class BenchSession : public BenchPeer::Handler, public std::enable_shared_from_this<BenchSession> {
+private:
+  const BenchConfig* m_config;
+  oatpp::String m_gameId;
+  oatpp::String m_sessionId;
+  std::shared_ptr<oatpp::async::Executor> m_executor;
+  std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper;
+  std::shared_ptr<oatpp::websocket::Connector> m_clientConnector;
+  std::shared_ptr<BenchStats> m_stats;
+  oatpp::String m_padding;
+private:
+  std::vector<std::shared_ptr<BenchPeer>> m_peers;
+  std::vector<v_int64> m_peerIds;
+  v_int64 m_hostPeerId;
+  std::mutex m_mutex;
+private:
+  std::shared_ptr<std::atomic<bool>> m_running;
+private:
+  oatpp::String createData(v_int64 timestamp);
+  v_int32 pickKind(std::minstd_rand& random);
+public:
+
+  /**
+   * Constructor.
+   * @param config
+   * @param gameId
+   * @param sessionId
+   * @param executor
+   * @param objectMapper
+   * @param clientConnector - connector to the client API server.
+   * @param stats
+   */
+  BenchSession(const BenchConfig* config,
+               const oatpp::String& gameId,
+               const oatpp::String& sessionId,
+               const std::shared_ptr<oatpp::async::Executor>& executor,
+               const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+               const std::shared_ptr<oatpp::websocket::Connector>& clientConnector,
+               const std::shared_ptr<BenchStats>& stats);
+
+  /**
+   * Connect host. Clients are connected when host receives hello.
+   * @param hostConnector - connector to the host API server.
+   */
+  void connect(const std::shared_ptr<oatpp::websocket::Connector>& hostConnector);
+
+  /**
+   * Get all peers of the session - host first.
+   * @return
+   */
+  std::vector<std::shared_ptr<BenchPeer>> getPeers();
+
+  /**
+   * Start traffic coroutine of each connected peer.
+   */
+  void startTraffic();
+
+  /**
+   * Stop traffic coroutines.
+   */
+  void stopTraffic();
+
+  /**
+   * Close all peers.
+   */
+  void close();
+
+  /**
+   * Generate and send next message of peer.
+   * @param peer
+   * @param random
+   */
+  void sendNext(const std::shared_ptr<BenchPeer>& peer, std::minstd_rand& random);
+
+public: // BenchPeer::Handler
+
+  void onHello(const std::shared_ptr<BenchPeer>& peer) override;
+  void onNewHost(const std::shared_ptr<BenchPeer>& peer, v_int64 hostPeerId) override;
+  void onClosed(const std::shared_ptr<BenchPeer>& peer) override;
+
+};
+
+#endif //Helicopter_bench_BenchSession_hpp
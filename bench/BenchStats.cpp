@@ -0,0 +1,180 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "BenchStats.hpp"
+
+#include <limits>
+
+BenchStats::BenchStats()
+  : m_windowStart(std::numeric_limits<v_int64>::max())
+  , m_windowEnd(std::numeric_limits<v_int64>::max())
+  , m_sentMessages(0)
+  , m_sentBytes(0)
+  , m_expectedDeliveries(0)
+  , m_deliveredMessages(0)
+  , m_deliveredBytes(0)
+  , m_clientDrops(0)
+  , m_serverErrors(0)
+  , m_receivedMessages(0)
+  , m_receivedBytes(0)
+  , m_receivedSynchronizedEvents(0)
+  , m_connectedPeers(0)
+  , m_failedPeers(0)
+{}
+
+bool BenchStats::isInWindow(v_int64 timestamp) const {
+  return timestamp >= m_windowStart.load(std::memory_order_relaxed) &&
+         timestamp < m_windowEnd.load(std::memory_order_relaxed);
+}
+
+void BenchStats::startWindow() {
+  m_windowStart = oatpp::base::Environment::getMicroTickCount();
+}
+
+void BenchStats::endWindow() {
+  m_windowEnd = oatpp::base::Environment::getMicroTickCount();
+}
+
+void BenchStats::onSent(v_int64 timestamp, v_int64 bytes, v_int64 expectedDeliveries) {
+  if(isInWindow(timestamp)) {
+    m_sentMessages.fetch_add(1, std::memory_order_relaxed);
+    m_sentBytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_expectedDeliveries.fetch_add(expectedDeliveries, std::memory_order_relaxed);
+  }
+}
+
+void BenchStats::onDelivered(v_int64 sentTimestamp, v_int64 receivedTimestamp, v_int64 bytes) {
+  if(isInWindow(sentTimestamp)) {
+    m_deliveredMessages.fetch_add(1, std::memory_order_relaxed);
+    m_deliveredBytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_latency.record(receivedTimestamp - sentTimestamp);
+  }
+}
+
+void BenchStats::onReceived(v_int64 bytes, bool synchronizedEvent) {
+  if(isInWindow(oatpp::base::Environment::getMicroTickCount())) {
+    m_receivedMessages.fetch_add(1, std::memory_order_relaxed);
+    m_receivedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    if(synchronizedEvent) {
+      m_receivedSynchronizedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void BenchStats::onClientDrop() {
+  if(isInWindow(oatpp::base::Environment::getMicroTickCount())) {
+    m_clientDrops.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void BenchStats::onServerError() {
+  m_serverErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BenchStats::onPeerConnected() {
+  m_connectedPeers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BenchStats::onPeerClosed(bool wasConnected) {
+  if(wasConnected) {
+    m_connectedPeers.fetch_sub(1, std::memory_order_relaxed);
+  }
+  m_failedPeers.fetch_add(1, std::memory_order_relaxed);
+}
+
+v_int64 BenchStats::getConnectedPeers() const {
+  return m_connectedPeers.load(std::memory_order_relaxed);
+}
+
+v_int64 BenchStats::getFailedPeers() const {
+  return m_failedPeers.load(std::memory_order_relaxed);
+}
+
+v_int64 BenchStats::getSentMessages() const {
+  return m_sentMessages.load();
+}
+
+v_int64 BenchStats::getExpectedDeliveries() const {
+  return m_expectedDeliveries.load();
+}
+
+v_int64 BenchStats::getDeliveredMessages() const {
+  return m_deliveredMessages.load();
+}
+
+v_int64 BenchStats::getReceivedMessages() const {
+  return m_receivedMessages.load();
+}
+
+v_int64 BenchStats::getReceivedBytes() const {
+  return m_receivedBytes.load();
+}
+
+v_int64 BenchStats::getReceivedSynchronizedEvents() const {
+  return m_receivedSynchronizedEvents.load();
+}
+
+v_int64 BenchStats::getClientDrops() const {
+  return m_clientDrops.load();
+}
+
+v_int64 BenchStats::getServerErrors() const {
+  return m_serverErrors.load();
+}
+
+LatencyHistogram::Percentiles BenchStats::getLatency() const {
+  return m_latency.getPercentiles();
+}
+
+void BenchStats::writeReport(oatpp::data::stream::ConsistentOutputStream* stream) const {
+
+  v_int64 start = m_windowStart.load();
+  v_int64 end = m_windowEnd.load();
+  v_float64 seconds = end > start ? (end - start) / 1000000.0 : 0;
+
+  v_int64 sent = m_sentMessages.load();
+  v_int64 expected = m_expectedDeliveries.load();
+  v_int64 delivered = m_deliveredMessages.load();
+  auto latency = m_latency.getPercentiles();
+
+  auto perSecond = [seconds](v_int64 value) -> v_int64 {
+    return seconds > 0 ? (v_int64) (value / seconds) : 0;
+  };
+
+  *stream << "window:          " << seconds << " s\n";
+  *stream << "sent:            " << sent << " msgs, " << perSecond(sent) << " msgs/s, "
+          << perSecond(m_sentBytes.load()) << " bytes/s\n";
+  *stream << "delivered:       " << delivered << " msgs, " << perSecond(delivered) << " msgs/s, "
+          << perSecond(m_deliveredBytes.load()) << " bytes/s\n";
+  *stream << "expected:        " << expected << " deliveries\n";
+  *stream << "dropped:         " << (expected > delivered ? expected - delivered : 0) << " (server), "
+          << m_clientDrops.load() << " (client queue)\n";
+  *stream << "latency (us):    p50=" << latency.p50 << ", p99=" << latency.p99 << ", p999=" << latency.p999
+          << ", max=" << latency.max << "\n";
+  *stream << "server errors:   " << m_serverErrors.load() << "\n";
+  *stream << "peers:           " << m_connectedPeers.load() << " connected, " << m_failedPeers.load() << " failed\n";
+
+}
@@ -0,0 +1,197 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_bench_BenchStats_hpp
+#define Helicopter_bench_BenchStats_hpp
+
+#include "utils/LatencyHistogram.hpp"
+
+#include "oatpp/core/data/stream/Stream.hpp"
+
+#include <atomic>
+
+/**
+ * Load generator counters.
+ * Only messages sent within the measurement window are counted - deliveries are matched by the send timestamp
+ * carried in message data, so messages delivered after the window closed still count.
+ */
+class BenchStats {
+private:
+  std::atomic<v_int64> m_windowStart;
+  std::atomic<v_int64> m_windowEnd;
+private:
+  std::atomic<v_int64> m_sentMessages;
+  std::atomic<v_int64> m_sentBytes;
+  std::atomic<v_int64> m_expectedDeliveries;
+  std::atomic<v_int64> m_deliveredMessages;
+  std::atomic<v_int64> m_deliveredBytes;
+  std::atomic<v_int64> m_clientDrops;
+  std::atomic<v_int64> m_serverErrors;
+  std::atomic<v_int64> m_receivedMessages;
+  std::atomic<v_int64> m_receivedBytes;
+  std::atomic<v_int64> m_receivedSynchronizedEvents;
+  LatencyHistogram m_latency;
+private:
+  std::atomic<v_int64> m_connectedPeers;
+  std::atomic<v_int64> m_failedPeers;
+private:
+  bool isInWindow(v_int64 timestamp) const;
+public:
+
+  /**
+   * Constructor.
+   */
+  BenchStats();
+
+  /**
+   * Start measurement window.
+   */
+  void startWindow();
+
+  /**
+   * Close measurement window.
+   */
+  void endWindow();
+
+  /**
+   * Message sent by peer.
+   * @param timestamp - send timestamp (carried in message data).
+   * @param bytes - size of the encoded message.
+   * @param expectedDeliveries - number of peers which should receive the message.
+   */
+  void onSent(v_int64 timestamp, v_int64 bytes, v_int64 expectedDeliveries);
+
+  /**
+   * Message received by peer.
+   * @param sentTimestamp - send timestamp carried in message data.
+   * @param receivedTimestamp
+   * @param bytes - size of the encoded message.
+   */
+  void onDelivered(v_int64 sentTimestamp, v_int64 receivedTimestamp, v_int64 bytes);
+
+  /**
+   * Data message or synchronized event received by peer - whether or not it carries the send timestamp.
+   * @param bytes - size of the encoded message.
+   * @param synchronizedEvent
+   */
+  void onReceived(v_int64 bytes, bool synchronizedEvent);
+
+  /**
+   * Message dropped because peer's outgoing queue of the load generator is full.
+   */
+  void onClientDrop();
+
+  /**
+   * Error message received from server.
+   */
+  void onServerError();
+
+  /**
+   * Peer received hello from server.
+   */
+  void onPeerConnected();
+
+  /**
+   * Peer failed to connect or was disconnected.
+   * @param wasConnected - peer received hello before it was disconnected.
+   */
+  void onPeerClosed(bool wasConnected);
+
+  /**
+   * Get number of connected peers.
+   * @return
+   */
+  v_int64 getConnectedPeers() const;
+
+  /**
+   * Get number of peers failed to connect or disconnected.
+   * @return
+   */
+  v_int64 getFailedPeers() const;
+
+  /**
+   * Get number of messages sent within the window.
+   * @return
+   */
+  v_int64 getSentMessages() const;
+
+  /**
+   * Get number of deliveries expected for messages sent within the window.
+   * @return
+   */
+  v_int64 getExpectedDeliveries() const;
+
+  /**
+   * Get number of delivered messages sent within the window.
+   * @return
+   */
+  v_int64 getDeliveredMessages() const;
+
+  /**
+   * Get number of data messages and synchronized events received within the window.
+   * @return
+   */
+  v_int64 getReceivedMessages() const;
+
+  /**
+   * Get bytes of data messages and synchronized events received within the window.
+   * @return
+   */
+  v_int64 getReceivedBytes() const;
+
+  /**
+   * Get number of synchronized events received within the window.
+   * @return
+   */
+  v_int64 getReceivedSynchronizedEvents() const;
+
+  /**
+   * Get number of messages dropped by the load generator's queues within the window.
+   * @return
+   */
+  v_int64 getClientDrops() const;
+
+  /**
+   * Get number of error messages received from server.
+   * @return
+   */
+  v_int64 getServerErrors() const;
+
+  /**
+   * Get delivery latency percentiles (microseconds).
+   * @return
+   */
+  LatencyHistogram::Percentiles getLatency() const;
+
+  /**
+   * Write report.
+   * @param stream
+   */
+  void writeReport(oatpp::data::stream::ConsistentOutputStream* stream) const;
+
+};
+
+#endif //Helicopter_bench_BenchStats_hpp
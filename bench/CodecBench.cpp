@@ -0,0 +1,318 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "dto/DTOs.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/base/CommandLineArguments.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Allocation counters.
+ * Global operator new is replaced for this executable only - every allocation made by the codec is counted.
+ */
+
+namespace {
+
+  std::atomic<v_uint64> s_allocations(0);
+  std::atomic<v_uint64> s_allocatedBytes(0);
+
+  void* allocate(std::size_t size) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if(ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+}
+
+void* operator new(std::size_t size) {
+  return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+  return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+
+  const char* const USAGE =
+    "Usage: helicopter-codec-bench [options]\n"
+    "  --min-millis <N>      minimum run time of each operation (200)\n"
+    "  --filter <text>       run only cases which name contains text\n";
+
+  const v_int32 PAYLOAD_SIZES[] = {16, 64, 256, 1024, 4 * 1024, 16 * 1024, 64 * 1024};
+
+  enum Style : v_int32 {
+    STYLE_PLAIN = 0,
+    STYLE_ESCAPED = 1
+  };
+
+  struct Result {
+    v_float64 nanosPerOp;
+    v_float64 allocationsPerOp;
+    v_float64 allocatedBytesPerOp;
+  };
+
+  /**
+   * Build string of exactly `size` bytes.
+   * Escaped style is a mix of quotes, backslashes, control characters and multibyte UTF-8 - all escaped by JSON serializer.
+   */
+  oatpp::String createData(v_int32 size, Style style) {
+    static const char* const ESCAPED_CHUNKS[] = {"\"", "\\", "\n", "\t", "\x01", "/", "\xC3\xA9", "\xE2\x82\xAC", "a"};
+    std::string result;
+    result.reserve(size);
+    if(style == STYLE_PLAIN) {
+      for(v_int32 i = 0; i < size; i ++) {
+        result.push_back((char) ('a' + i % 26));
+      }
+    } else {
+      v_int32 chunk = 0;
+      while((v_int32) result.size() < size) {
+        std::string next = ESCAPED_CHUNKS[chunk ++ % 9];
+        if((v_int32) (result.size() + next.size()) > size) {
+          next = "a";
+        }
+        result += next;
+      }
+    }
+    return result;
+  }
+
+  oatpp::Object<MessageDto> createMessage(MessageCodes code, const oatpp::Any& payload) {
+    auto message = MessageDto::createShared();
+    message->code = code;
+    message->ocid = "0123456789abcdef0123456789abcdef";
+    message->payload = payload;
+    return message;
+  }
+
+  oatpp::Object<MessageDto> createHello() {
+    auto payload = HelloMessageDto::createShared();
+    payload->peerId = 1234567;
+    payload->isHost = false;
+    return createMessage(MessageCodes::OUTGOING_HELLO, payload);
+  }
+
+  oatpp::Object<MessageDto> createError(const oatpp::String& data) {
+    return createMessage(MessageCodes::OUTGOING_ERROR, ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, data));
+  }
+
+  oatpp::Object<MessageDto> createOutgoing(const oatpp::String& data) {
+    auto payload = OutgoingMessageDto::createShared();
+    payload->peerId = 1234567;
+    payload->data = data;
+    return createMessage(MessageCodes::OUTGOING_MESSAGE, payload);
+  }
+
+  oatpp::Object<MessageDto> createSynchronized(const oatpp::String& data) {
+    auto payload = OutgoingSynchronizedMessageDto::createShared();
+    payload->eventId = 7654321;
+    payload->peerId = 1234567;
+    payload->data = data;
+    return createMessage(MessageCodes::OUTGOING_SYNCHRONIZED_EVENT, payload);
+  }
+
+  oatpp::Object<MessageDto> createDirect(const oatpp::String& data) {
+    auto payload = DirectMessageDto::createShared();
+    for(v_int64 i = 0; i < 8; i ++) {
+      payload->peerIds->push_back(1000 + i);
+    }
+    payload->data = data;
+    return createMessage(MessageCodes::INCOMING_DIRECT_MESSAGE, payload);
+  }
+
+  /**
+   * Run `operation` in batches until `minMillis` elapsed.
+   */
+  template<class F>
+  Result measure(v_int64 minMillis, const F& operation) {
+
+    operation(); // warm up
+
+    v_int64 ops = 0;
+    v_int64 batch = 1;
+    v_int64 elapsedNanos = 0;
+    v_uint64 allocations = s_allocations.load(std::memory_order_relaxed);
+    v_uint64 allocatedBytes = s_allocatedBytes.load(std::memory_order_relaxed);
+
+    auto start = std::chrono::steady_clock::now();
+    while(elapsedNanos < minMillis * 1000000) {
+      for(v_int64 i = 0; i < batch; i ++) {
+        operation();
+      }
+      ops += batch;
+      batch *= 2;
+      elapsedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    Result result;
+    result.nanosPerOp = (v_float64) elapsedNanos / ops;
+    result.allocationsPerOp = (v_float64) (s_allocations.load(std::memory_order_relaxed) - allocations) / ops;
+    result.allocatedBytesPerOp = (v_float64) (s_allocatedBytes.load(std::memory_order_relaxed) - allocatedBytes) / ops;
+    return result;
+
+  }
+
+  class CodecBench {
+  private:
+    std::shared_ptr<oatpp::parser::json::mapping::ObjectMapper> m_objectMapper;
+    v_int64 m_minMillis;
+    std::string m_filter;
+    v_uint64 m_sink;
+  public:
+
+    CodecBench(v_int64 minMillis, const std::string& filter)
+      : m_objectMapper(oatpp::parser::json::mapping::ObjectMapper::createShared())
+      , m_minMillis(minMillis)
+      , m_filter(filter)
+      , m_sink(0)
+    {
+      /* same config as the WS API object mapper */
+      m_objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+    }
+
+    void printHeader() {
+      std::printf("%-32s %10s %12s %10s %12s %12s %10s %12s\n",
+                  "case", "wire B", "enc ns/op", "enc al/op", "enc B/op", "dec ns/op", "dec al/op", "dec B/op");
+    }
+
+    void run(const std::string& name, const oatpp::Object<MessageDto>& message) {
+
+      if(!m_filter.empty() && name.find(m_filter) == std::string::npos) {
+        return;
+      }
+
+      oatpp::String wire = m_objectMapper->writeToString(message);
+
+      /* round trip must preserve the message - otherwise numbers are meaningless */
+      auto decoded = m_objectMapper->readFromString<oatpp::Object<MessageDto>>(wire);
+      if(m_objectMapper->writeToString(decoded) != wire) {
+        throw std::runtime_error("[CodecBench::run()]: Error. Round trip mismatch for case '" + name + "'.");
+      }
+
+      auto encode = measure(m_minMillis, [this, &message]{
+        m_sink += m_objectMapper->writeToString(message)->size();
+      });
+
+      auto decode = measure(m_minMillis, [this, &wire]{
+        auto result = m_objectMapper->readFromString<oatpp::Object<MessageDto>>(wire);
+        m_sink += result != nullptr ? 1 : 0;
+      });
+
+      std::printf("%-32s %10lld %12.1f %10.1f %12.1f %12.1f %10.1f %12.1f\n",
+                  name.c_str(), (long long) wire->size(),
+                  encode.nanosPerOp, encode.allocationsPerOp, encode.allocatedBytesPerOp,
+                  decode.nanosPerOp, decode.allocationsPerOp, decode.allocatedBytesPerOp);
+      std::fflush(stdout);
+
+    }
+
+    void runAll() {
+
+      printHeader();
+
+      run("hello", createHello());
+
+      const char* const STYLE_NAMES[] = {"plain", "escaped"};
+
+      for(v_int32 s = STYLE_PLAIN; s <= STYLE_ESCAPED; s ++) {
+        for(v_int32 size : PAYLOAD_SIZES) {
+          auto data = createData(size, (Style) s);
+          auto suffix = std::string("/") + STYLE_NAMES[s] + "/" + std::to_string(size);
+          run("error" + suffix, createError(data));
+          run("message" + suffix, createOutgoing(data));
+          run("synchronized" + suffix, createSynchronized(data));
+          run("direct" + suffix, createDirect(data));
+        }
+      }
+
+      std::printf("\n(sink %llu)\n", (unsigned long long) m_sink);
+
+    }
+
+  };
+
+}
+
+int main(int argc, const char * argv[]) {
+
+  oatpp::base::Environment::init();
+
+  oatpp::base::CommandLineArguments args(argc, argv);
+
+  if(args.hasArgument("--help")) {
+    std::cout << USAGE;
+  } else {
+    bool success;
+    v_int64 minMillis = oatpp::utils::conversion::strToInt64(args.getNamedArgumentValue("--min-millis", "200"), success);
+    if(!success || minMillis <= 0) {
+      std::cerr << "Invalid value of '--min-millis'.\n\n" << USAGE;
+      oatpp::base::Environment::destroy();
+      return 1;
+    }
+    try {
+      CodecBench bench(minMillis, args.getNamedArgumentValue("--filter", ""));
+      bench.runAll();
+    } catch (const std::runtime_error& e) {
+      std::cerr << e.what() << "\n";
+      oatpp::base::Environment::destroy();
+      return 1;
+    }
+  }
+
+  oatpp::base::Environment::destroy();
+
+  return 0;
+}
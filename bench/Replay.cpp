@@ -0,0 +1,550 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "./BenchSession.hpp"
+
+#include "utils/RecordingReader.hpp"
+
+#include "oatpp/network/tcp/client/ConnectionProvider.hpp"
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+#include "oatpp/core/data/stream/BufferStream.hpp"
+#include "oatpp/core/base/CommandLineArguments.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+  const char* const USAGE =
+    "Usage: helicopter-replay --recordings <file.hrec,...> [options]\n"
+    "  --recordings <files>          comma-separated session recordings (.hrec)\n"
+    "  --host <host>                 server host (127.0.0.1)\n"
+    "  --host-port <port>            host API port (8000)\n"
+    "  --client-port <port>          client API port (8001)\n"
+    "  --game <id>                   replay into this game (game ID of each recording)\n"
+    "  --speed <N|max>               N - N times faster than recorded, max - as fast as possible (1)\n"
+    "  --from-millis <ms>            skip the first ms of the recorded traffic (0)\n"
+    "  --connect-timeout <seconds>   time to connect all peers (30)\n"
+    "  --drain <seconds>             wait for in-flight messages after replay (2)\n"
+    "  --threads <N>                 replay threads (4)\n";
+
+  struct ReplayConfig {
+
+    std::vector<std::string> recordings;
+    oatpp::String host = "127.0.0.1";
+    v_uint16 hostPort = 8000;
+    v_uint16 clientPort = 8001;
+    oatpp::String gameId;
+    v_float64 speed = 1; // 0 - as fast as possible
+    v_int64 fromMillis = 0;
+    v_int32 connectTimeoutSeconds = 30;
+    v_int32 drainSeconds = 2;
+    v_int32 threads = 4;
+
+    static v_int64 getInt(const oatpp::base::CommandLineArguments& args, const char* name, v_int64 defaultValue, v_int64 minValue) {
+      if(!args.hasArgument(name)) {
+        return defaultValue;
+      }
+      bool success;
+      v_int64 value = oatpp::utils::conversion::strToInt64(args.getNamedArgumentValue(name, ""), success);
+      if(!success || value < minValue) {
+        throw std::runtime_error(std::string("[ReplayConfig]: Invalid value of '") + name + "'");
+      }
+      return value;
+    }
+
+    static ReplayConfig parse(const oatpp::base::CommandLineArguments& args) {
+
+      ReplayConfig config;
+
+      std::string files = args.getNamedArgumentValue("--recordings", "");
+      std::string::size_type start = 0;
+      while(start < files.size()) {
+        auto end = files.find(',', start);
+        if(end == std::string::npos) {
+          end = files.size();
+        }
+        if(end > start) {
+          config.recordings.push_back(files.substr(start, end - start));
+        }
+        start = end + 1;
+      }
+      if(config.recordings.empty()) {
+        throw std::runtime_error("[ReplayConfig]: '--recordings' is required");
+      }
+
+      config.host = args.getNamedArgumentValue("--host", "127.0.0.1");
+      config.hostPort = (v_uint16) getInt(args, "--host-port", config.hostPort, 1);
+      config.clientPort = (v_uint16) getInt(args, "--client-port", config.clientPort, 1);
+
+      if(args.hasArgument("--game")) {
+        config.gameId = args.getNamedArgumentValue("--game", "");
+      }
+
+      std::string speed = args.getNamedArgumentValue("--speed", "1");
+      if(speed == "max") {
+        config.speed = 0;
+      } else {
+        bool success;
+        config.speed = oatpp::utils::conversion::strToFloat64(speed.c_str(), success);
+        if(!success || config.speed <= 0) {
+          throw std::runtime_error("[ReplayConfig]: Invalid value of '--speed'");
+        }
+      }
+
+      config.fromMillis = getInt(args, "--from-millis", config.fromMillis, 0);
+      config.connectTimeoutSeconds = (v_int32) getInt(args, "--connect-timeout", config.connectTimeoutSeconds, 1);
+      config.drainSeconds = (v_int32) getInt(args, "--drain", config.drainSeconds, 0);
+      config.threads = (v_int32) getInt(args, "--threads", config.threads, 1);
+
+      return config;
+
+    }
+
+  };
+
+  /**
+   * Recorded session replayed by simulated peers.
+   * Recorded peers are the senders of inbound messages - pongs included, so every peer which stayed for a ping
+   * interval is known. The lowest recorded peerId is the host - it joins first.
+   */
+  struct ReplaySession {
+
+    std::shared_ptr<RecordingReader> reader;
+    BenchConfig config;
+    std::shared_ptr<BenchSession> session;
+
+    std::vector<v_int64> recordedPeerIds; // host first, then in order of the first message
+    std::unordered_map<v_int64, std::shared_ptr<BenchPeer>> peers; // recorded peerId -> simulated peer
+    std::unordered_map<v_int64, v_int64> peerIds; // recorded peerId -> peerId of the replay
+
+    v_buff_size beginOffset = 0;
+    v_buff_size offset = 0;
+    RecordingReader::Record next;
+    bool hasNext = false;
+
+    v_int64 firstTimestamp = 0;
+    v_int64 lastTimestamp = 0;
+    v_int64 recordedInbound = 0;
+    v_int64 recordedSynchronizedEvents = 0;
+
+    void advance() {
+      hasNext = reader->read(offset, next);
+    }
+
+    /* find recorded peers and counts */
+    void scan() {
+
+      std::unordered_map<v_int64, bool> seen;
+      v_int64 hostPeerId = -1;
+      RecordingReader::Record record;
+      v_buff_size position = beginOffset;
+      bool first = true;
+
+      while(reader->read(position, record)) {
+        if(first) {
+          firstTimestamp = record.timestampMicros;
+          first = false;
+        }
+        lastTimestamp = record.timestampMicros;
+        if(record.type == RecordingFormat::TYPE_SYNCHRONIZED_EVENT) {
+          recordedSynchronizedEvents ++;
+          continue;
+        }
+        recordedInbound ++;
+        if(!seen[record.peerId]) {
+          seen[record.peerId] = true;
+          recordedPeerIds.push_back(record.peerId);
+          if(hostPeerId < 0 || record.peerId < hostPeerId) {
+            hostPeerId = record.peerId;
+          }
+        }
+      }
+
+      if(hostPeerId >= 0) {
+        std::stable_partition(recordedPeerIds.begin(), recordedPeerIds.end(), [hostPeerId](v_int64 id) {
+          return id == hostPeerId;
+        });
+      }
+
+    }
+
+    /* pair recorded peers with connected simulated peers - host with host */
+    void mapPeers() {
+      auto simulated = session->getPeers();
+      for(size_t i = 0; i < recordedPeerIds.size() && i < simulated.size(); i ++) {
+        peers[recordedPeerIds[i]] = simulated[i];
+        peerIds[recordedPeerIds[i]] = simulated[i]->getPeerId();
+      }
+    }
+
+  };
+
+  class Replay {
+  private:
+    const ReplayConfig& m_config;
+    std::shared_ptr<oatpp::async::Executor> m_executor;
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper;
+    std::shared_ptr<BenchStats> m_stats;
+    std::vector<std::shared_ptr<ReplaySession>> m_sessions;
+    LatencyHistogram m_lag;
+    v_int64 m_sentMessages;
+    v_int64 m_sentBytes;
+    v_int64 m_skippedMessages;
+    v_int64 m_skippedPongs;
+  private:
+
+    v_int64 mapPeerId(ReplaySession& session, v_int64 recordedPeerId) {
+      auto it = session.peerIds.find(recordedPeerId);
+      return it != session.peerIds.end() ? it->second : -1;
+    }
+
+    /**
+     * Prepare recorded message for sending. Peer IDs in payload are mapped to peers of the replay.
+     * @return - message or `nullptr` if message is not replayed.
+     */
+    oatpp::String prepare(ReplaySession& session, const RecordingReader::Record& record) {
+
+      oatpp::String raw(record.data, record.size);
+
+      oatpp::Object<MessageDto> message;
+      try {
+        message = m_objectMapper->readFromString<oatpp::Object<MessageDto>>(raw);
+      } catch (const std::runtime_error& e) {
+        return raw; // replay as is - server rejects it as it did originally
+      }
+
+      if(!message || !message->code) {
+        return raw;
+      }
+
+      switch(*message->code) {
+
+        case MessageCodes::INCOMING_PONG:
+          m_skippedPongs ++;
+          return nullptr; // simulated peers answer pings of the replay
+
+        case MessageCodes::INCOMING_DIRECT_MESSAGE: {
+          auto payload = message->payload.retrieve<oatpp::Object<DirectMessageDto>>();
+          if(payload && payload->peerIds) {
+            for(auto& id : *payload->peerIds) {
+              if(id) {
+                id = mapPeerId(session, *id);
+              }
+            }
+          }
+          return m_objectMapper->writeToString(message);
+        }
+
+        case MessageCodes::INCOMING_HOST_KICK_CLIENTS: {
+          auto ids = message->payload.retrieve<oatpp::Vector<oatpp::Int64>>();
+          if(ids) {
+            for(auto& id : *ids) {
+              if(id) {
+                id = mapPeerId(session, *id);
+              }
+            }
+          }
+          return m_objectMapper->writeToString(message);
+        }
+
+        default:
+          return raw;
+
+      }
+
+    }
+
+    void send(ReplaySession& session, const RecordingReader::Record& record) {
+
+      auto it = session.peers.find(record.peerId);
+      if(it == session.peers.end() || it->second->isClosed()) {
+        m_skippedMessages ++;
+        return;
+      }
+
+      auto message = prepare(session, record);
+      if(!message) {
+        return;
+      }
+
+      if(it->second->send(message)) {
+        m_sentMessages ++;
+        m_sentBytes += message->size();
+      } else {
+        m_stats->onClientDrop();
+      }
+
+    }
+
+  public:
+
+    Replay(const ReplayConfig& config)
+      : m_config(config)
+      , m_executor(std::make_shared<oatpp::async::Executor>(config.threads, 1, 1))
+      , m_objectMapper(oatpp::parser::json::mapping::ObjectMapper::createShared())
+      , m_stats(std::make_shared<BenchStats>())
+      , m_sentMessages(0)
+      , m_sentBytes(0)
+      , m_skippedMessages(0)
+      , m_skippedPongs(0)
+    {
+      m_objectMapper->getSerializer()->getConfig()->includeNullFields = false;
+    }
+
+    bool open() {
+
+      for(auto& path : m_config.recordings) {
+
+        auto session = std::make_shared<ReplaySession>();
+        session->reader = std::make_shared<RecordingReader>();
+
+        if(!session->reader->open(path)) {
+          OATPP_LOGE("Replay", "Can't open recording '%s'", path.c_str())
+          return false;
+        }
+
+        session->beginOffset = session->reader->getBeginOffset();
+        if(m_config.fromMillis > 0) {
+          RecordingReader::Record first;
+          v_buff_size position = session->beginOffset;
+          if(session->reader->read(position, first)) {
+            session->beginOffset = session->reader->seekTime(first.timestampMicros + m_config.fromMillis * 1000);
+          }
+        }
+
+        session->scan();
+
+        if(session->recordedPeerIds.empty()) {
+          OATPP_LOGW("Replay", "Recording '%s' has no inbound messages - skipped", path.c_str())
+          continue;
+        }
+
+        session->config.peers = (v_int32) session->recordedPeerIds.size();
+        session->config.maxQueuedMessages = 1 << 20;
+        m_sessions.push_back(session);
+
+      }
+
+      return !m_sessions.empty();
+
+    }
+
+    bool connect() {
+
+      auto hostConnector = oatpp::websocket::Connector::createShared(
+        oatpp::network::tcp::client::ConnectionProvider::createShared({m_config.host, m_config.hostPort, oatpp::network::Address::IP_4}));
+      auto clientConnector = oatpp::websocket::Connector::createShared(
+        oatpp::network::tcp::client::ConnectionProvider::createShared({m_config.host, m_config.clientPort, oatpp::network::Address::IP_4}));
+
+      auto runId = std::to_string(getpid());
+      v_int64 totalPeers = 0;
+
+      for(auto& session : m_sessions) {
+        auto gameId = m_config.gameId ? m_config.gameId : oatpp::String(session->reader->getGameId());
+        auto sessionId = oatpp::String("replay-" + runId + "-" + std::to_string(totalPeers) + "-" + session->reader->getSessionId());
+        session->session = std::make_shared<BenchSession>(&session->config, gameId, sessionId, m_executor, m_objectMapper,
+                                                          clientConnector, m_stats);
+        session->session->connect(hostConnector);
+        totalPeers += session->config.peers;
+      }
+
+      auto connectDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(m_config.connectTimeoutSeconds);
+      while(m_stats->getConnectedPeers() + m_stats->getFailedPeers() < totalPeers && std::chrono::steady_clock::now() < connectDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+
+      OATPP_LOGI("Replay", "%lld/%lld peers connected, %lld failed", m_stats->getConnectedPeers(), totalPeers, m_stats->getFailedPeers())
+
+      for(auto& session : m_sessions) {
+        session->mapPeers();
+      }
+
+      return m_stats->getConnectedPeers() > 0;
+
+    }
+
+    /**
+     * Merge records of all sessions by timestamp and send inbound messages on the recorded timeline scaled by speed.
+     */
+    void run() {
+
+      typedef std::pair<v_int64, size_t> Entry; // timestamp, session index
+      std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+      v_int64 origin = -1;
+      for(size_t i = 0; i < m_sessions.size(); i ++) {
+        auto& session = m_sessions[i];
+        session->offset = session->beginOffset;
+        session->advance();
+        if(session->hasNext) {
+          queue.push(Entry(session->next.timestampMicros, i));
+          if(origin < 0 || session->next.timestampMicros < origin) {
+            origin = session->next.timestampMicros;
+          }
+        }
+      }
+
+      m_stats->startWindow();
+      auto start = std::chrono::steady_clock::now();
+
+      while(!queue.empty()) {
+
+        auto entry = queue.top();
+        queue.pop();
+        auto& session = *m_sessions[entry.second];
+
+        if(m_config.speed > 0) {
+          auto target = start + std::chrono::microseconds((v_int64) ((entry.first - origin) / m_config.speed));
+          std::this_thread::sleep_until(target);
+          m_lag.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - target).count());
+        }
+
+        if(session.next.type == RecordingFormat::TYPE_INBOUND) {
+          send(session, session.next);
+        }
+
+        session.advance();
+        if(session.hasNext) {
+          queue.push(Entry(session.next.timestampMicros, entry.second));
+        }
+
+      }
+
+      auto elapsed = std::chrono::steady_clock::now() - start;
+
+      std::this_thread::sleep_for(std::chrono::seconds(m_config.drainSeconds));
+      m_stats->endWindow();
+
+      report(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+    }
+
+    void report(v_int64 elapsedMicros) {
+
+      v_int64 peers = 0;
+      v_int64 inbound = 0;
+      v_int64 synchronizedEvents = 0;
+      v_int64 expectedSynchronizedEvents = 0;
+      v_int64 spanMicros = 0;
+
+      for(auto& session : m_sessions) {
+        peers += session->config.peers;
+        inbound += session->recordedInbound;
+        synchronizedEvents += session->recordedSynchronizedEvents;
+        expectedSynchronizedEvents += session->recordedSynchronizedEvents * session->config.peers;
+        spanMicros = std::max(spanMicros, session->lastTimestamp - session->firstTimestamp);
+      }
+
+      auto lag = m_lag.getPercentiles();
+      v_float64 seconds = elapsedMicros / 1000000.0;
+
+      oatpp::data::stream::BufferOutputStream report;
+      report << "\nhelicopter-replay: " << (v_int64) m_sessions.size() << " sessions, " << peers << " peers, speed ";
+      if(m_config.speed > 0) {
+        report << m_config.speed << "x";
+      } else {
+        report << "max";
+      }
+      report << "\n\n";
+      report << "recorded:        " << inbound << " inbound msgs, "
+             << synchronizedEvents << " synchronized events in " << spanMicros / 1000000.0 << " s\n";
+      report << "replayed:        " << m_sentMessages << " msgs, " << m_sentBytes << " bytes in " << seconds << " s, "
+             << (seconds > 0 ? (v_int64) (m_sentMessages / seconds) : 0) << " msgs/s\n";
+      report << "skipped:         " << m_skippedPongs << " pongs (answered by the replay's peers), "
+             << m_skippedMessages << " (peer not connected), " << m_stats->getClientDrops() << " (client queue)\n";
+      report << "received:        " << m_stats->getReceivedMessages() << " msgs, " << m_stats->getReceivedBytes() << " bytes\n";
+      report << "sync events:     " << m_stats->getReceivedSynchronizedEvents() << " received, "
+             << expectedSynchronizedEvents << " recorded x peers\n";
+      report << "schedule lag:    p50=" << lag.p50 << ", p99=" << lag.p99 << ", max=" << lag.max << " us\n";
+      report << "server errors:   " << m_stats->getServerErrors() << "\n";
+      report << "peers:           " << m_stats->getConnectedPeers() << " connected, " << m_stats->getFailedPeers() << " failed\n";
+
+      std::cout << report.toString()->c_str() << std::endl;
+
+    }
+
+    void close() {
+
+      for(auto& session : m_sessions) {
+        if(session->session) {
+          session->session->close();
+        }
+      }
+
+      m_executor->waitTasksFinished(std::chrono::seconds(5));
+      m_executor->stop();
+      m_executor->join();
+
+    }
+
+  };
+
+}
+
+int main(int argc, const char * argv[]) {
+
+  oatpp::base::Environment::init();
+
+  oatpp::base::CommandLineArguments args(argc, argv);
+
+  v_int32 result = 0;
+
+  if(args.hasArgument("--help")) {
+    std::cout << USAGE;
+  } else {
+    try {
+      auto config = ReplayConfig::parse(args);
+      Replay replay(config);
+      if(!replay.open()) {
+        OATPP_LOGE("Replay", "Nothing to replay")
+        result = 1;
+      } else if(!replay.connect()) {
+        OATPP_LOGE("Replay", "No peers connected. Is the server running at %s:%d/%d?",
+                   config.host->c_str(), config.hostPort, config.clientPort)
+        result = 1;
+      } else {
+        replay.run();
+      }
+      replay.close();
+    } catch (const std::runtime_error& e) {
+      std::cerr << e.what() << "\n\n" << USAGE;
+      result = 1;
+    }
+  }
+
+  oatpp::base::Environment::destroy();
+
+  return result;
+}
@@ -28,22 +28,43 @@
 
 #include "./AppComponent.hpp"
 
+#include "utils/AsyncLogger.hpp"
+
 #include "oatpp/network/Server.hpp"
 
 #include <iostream>
+#include <csignal>
 
 void run(const oatpp::base::CommandLineArguments& args) {
 
   /* Register Components in scope of run() method */
   AppComponent components(args);
 
+  OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+  AsyncLogger::start(config->logBufferSize, config->logRateLimit);
+
   Runner runner(OATPP_GET_COMPONENT(oatpp::Object<ConfigDto>),
                 OATPP_GET_COMPONENT(std::shared_ptr<oatpp::async::Executor>));
 
+  /* SIGTERM / SIGINT - graceful drain */
+  std::signal(SIGTERM, Runner::onDrainSignal);
+  std::signal(SIGINT, Runner::onDrainSignal);
+
   runner.start();
 
   runner.join();
 
+  /* drained - stop executors */
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, controlExecutor, Constants::COMPONENT_CONTROL);
+
+  executor->stop();
+  controlExecutor->stop();
+  executor->join();
+  controlExecutor->join();
+
+  AsyncLogger::stop();
+
 }
 
 int main(int argc, const char * argv[]) {
@@ -30,8 +30,14 @@
 #include "config/Config.hpp"
 #include "config/GamesConfig.hpp"
 
+#include "cluster/Cluster.hpp"
 #include "game/Registry.hpp"
 
+#include "utils/AsyncLogger.hpp"
+#include "utils/ExecutorFactory.hpp"
+#include "utils/Tracer.hpp"
+#include "utils/Recorder.hpp"
+
 #include "oatpp-openssl/server/ConnectionProvider.hpp"
 #include "oatpp-websocket/AsyncConnectionHandler.hpp"
 
@@ -71,26 +77,79 @@ public:
 
     auto hostServer = ServerConfigDto::createShared();
     hostServer->host = "0.0.0.0";
-    hostServer->port = 8000;
+    hostServer->port = oatpp::utils::conversion::strToInt32(m_cmdArgs.getNamedArgumentValue("--host-port", "8000"));
 
     auto clientServer = ServerConfigDto::createShared();
     clientServer->host = "0.0.0.0";
-    clientServer->port = 8001;
+    clientServer->port = oatpp::utils::conversion::strToInt32(m_cmdArgs.getNamedArgumentValue("--client-port", "8001"));
+
+    /* cluster mode - ex.: --cluster-node node-1 --cluster-members members.json [--cluster-relay --cluster-secret <secret>] */
+    if(m_cmdArgs.hasArgument("--cluster-node")) {
+      auto cluster = ClusterConfigDto::createShared();
+      cluster->nodeId = m_cmdArgs.getNamedArgumentValue("--cluster-node");
+      cluster->membersFile = m_cmdArgs.getNamedArgumentValue("--cluster-members", "cluster-members.json");
+      cluster->relay = m_cmdArgs.hasArgument("--cluster-relay");
+      if(m_cmdArgs.hasArgument("--cluster-secret")) {
+        cluster->relaySecret = m_cmdArgs.getNamedArgumentValue("--cluster-secret");
+      }
+      config->cluster = cluster;
+    }
 
     config->hostAPIServer = hostServer;
     config->clientAPIServer = clientServer;
 
+    if(m_cmdArgs.hasArgument("--games-config")) {
+      config->gamesConfigFile = m_cmdArgs.getNamedArgumentValue("--games-config");
+    }
+
+    /* sampled tracing - ex.: --trace-file trace.json [--trace-sample-rate 0.01] */
+    if(m_cmdArgs.hasArgument("--trace-file")) {
+      auto tracing = TracingConfigDto::createShared();
+      tracing->file = m_cmdArgs.getNamedArgumentValue("--trace-file");
+      if(m_cmdArgs.hasArgument("--trace-sample-rate")) {
+        bool success;
+        tracing->sampleRate = oatpp::utils::conversion::strToFloat64(m_cmdArgs.getNamedArgumentValue("--trace-sample-rate"), success);
+        if(!success) {
+          HELI_LOGE("AppComponent", "Invalid value of '--trace-sample-rate'");
+          throw std::runtime_error("[AppComponent]: Invalid value of '--trace-sample-rate'");
+        }
+      }
+      config->tracing = tracing;
+    }
+
+    /* session recording - ex.: --record-dir recordings */
+    if(m_cmdArgs.hasArgument("--record-dir")) {
+      auto recording = RecordingConfigDto::createShared();
+      recording->directory = m_cmdArgs.getNamedArgumentValue("--record-dir");
+      config->recording = recording;
+    }
+
     return config;
   }());
 
+  /**
+   * Cluster membership and session placement
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Cluster>, cluster)([] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return std::make_shared<Cluster>(config->cluster);
+  }());
+
   /**
    * Game configs
    */
   OATPP_CREATE_COMPONENT(std::shared_ptr<GamesConfig>, gameConfig)([] {
-    auto config = std::make_shared<GamesConfig>(nullptr);
-    auto testGame1 = GameConfigDto::createShared();
-    testGame1->gameId = "snake";
-    config->putGameConfig(testGame1);
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, appConfig);
+    auto config = std::make_shared<GamesConfig>(appConfig->gamesConfigFile);
+    if(appConfig->gamesConfigFile) {
+      if(appConfig->gamesConfigWatchMillis > 0) {
+        config->startWatching(appConfig->gamesConfigWatchMillis);
+      }
+    } else {
+      auto testGame1 = GameConfigDto::createShared();
+      testGame1->gameId = "snake";
+      config->putGameConfig(testGame1);
+    }
     return config;
   }());
 
@@ -98,7 +157,31 @@ public:
    * Create Async Executor
    */
   OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor)([] {
-    return std::make_shared<oatpp::async::Executor>();
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return ExecutorFactory::createExecutor(config->executor, "app");
+  }());
+
+  /**
+   * Create control executor - low-latency lane for pings and kicks
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::async::Executor>, controlExecutor)(Constants::COMPONENT_CONTROL, [] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return ExecutorFactory::createExecutor(ExecutorFactory::getConfigOrSingleWorker(config->controlExecutor), "control");
+  }());
+
+  /**
+   * Create executors game sessions are pinned to
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<ExecutorPool>, sessionExecutors)([] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+    std::shared_ptr<ExecutorPool> pool;
+    if(config->sessionExecutors > 0) {
+      pool = std::make_shared<ExecutorPool>(config->sessionExecutors, *config->sessionPlacement);
+    } else {
+      pool = std::make_shared<ExecutorPool>(executor);
+    }
+    return pool;
   }());
 
   /**
@@ -126,11 +209,47 @@ public:
     return mapper;
   }());
 
+  /**
+   *  Create server-wide admission control component.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<AdmissionControl>, admissionControl)([] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return std::make_shared<AdmissionControl>(config);
+  }());
+
+  /**
+   *  Create per-message tracer component.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Tracer>, tracer)([] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return std::make_shared<Tracer>(config->tracing);
+  }());
+
+  /**
+   *  Create session recorder component.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Recorder>, recorder)([] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return std::make_shared<Recorder>(config->recording);
+  }());
+
+  /**
+   *  Create cluster relay component.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Relay>, relay)([] {
+    return Relay::createShared();
+  }());
+
   /**
    *  Create games sessions Registry component.
    */
   OATPP_CREATE_COMPONENT(std::shared_ptr<Registry>, gamesSessionsRegistry)([] {
-    return std::make_shared<Registry>();
+    OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+    OATPP_COMPONENT(std::shared_ptr<ExecutorPool>, sessionExecutors);
+    OATPP_COMPONENT(std::shared_ptr<Relay>, relay);
+    auto registry = std::make_shared<Registry>(executor, sessionExecutors);
+    relay->setRegistry(registry);
+    return registry;
   }());
 
   /**
@@ -32,6 +32,7 @@ public:
 
   static constexpr const char* COMPONENT_REST_API = "REST_API";
   static constexpr const char* COMPONENT_WS_API = "WS_API";
+  static constexpr const char* COMPONENT_CONTROL = "CONTROL";
 
 public:
 
@@ -40,6 +41,26 @@ public:
   static constexpr const char* PARAM_PEER_TYPE = "peerType";
   static constexpr const char* PARAM_PEER_TYPE_HOST = "host";
   static constexpr const char* PARAM_PEER_TYPE_CLIENT = "client";
+  static constexpr const char* PARAM_PEER_ADDRESS = "peerAddress";
+  static constexpr const char* PARAM_NODE_ID = "nodeId";
+  static constexpr const char* PARAM_PEER_ID = "peerId";
+  static constexpr const char* PARAM_RESUME_TOKEN = "resumeToken";
+
+public:
+
+  static constexpr const char* PATH_CREATE_GAME = "/api/create-game/";
+  static constexpr const char* PATH_JOIN_GAME = "/api/join-game/";
+
+public:
+
+  static constexpr const char* HEADER_CLUSTER_SECRET = "X-Cluster-Secret";
+
+public:
+
+  /**
+   * Connection property set by `oatpp::network::tcp::server::ConnectionProvider` for extended connections.
+   */
+  static constexpr const char* CONNECTION_PROPERTY_PEER_ADDRESS = "peer_address";
 
 };
 
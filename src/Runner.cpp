@@ -28,6 +28,16 @@
 
 #include "controller/HostController.hpp"
 #include "controller/ClientController.hpp"
+#include "controller/RelayController.hpp"
+#include "controller/AdminController.hpp"
+#include "controller/MetricsController.hpp"
+
+#include "network/ReusePortConnectionProvider.hpp"
+
+#include "utils/AsyncLogger.hpp"
+#include "utils/ExecutorFactory.hpp"
+
+#include "oatpp-websocket/AsyncConnectionHandler.hpp"
 
 #include "oatpp-openssl/server/ConnectionProvider.hpp"
 
@@ -36,28 +46,77 @@
 
 #include "oatpp/network/Server.hpp"
 
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <csignal>
+
+namespace {
+
+  volatile std::sig_atomic_t DRAIN_SIGNAL = 0;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shard
+
+Shard::Shard(const oatpp::Object<ConfigDto>& config, v_int32 index)
+  : m_executor(ExecutorFactory::createExecutor(ExecutorFactory::getConfigOrSingleWorker(config->shardExecutor),
+                                              "shard-" + oatpp::utils::conversion::int32ToStr(index)))
+  , m_sessionExecutors(std::make_shared<ExecutorPool>(m_executor, true))
+  , m_registry(std::make_shared<Registry>(m_executor, m_sessionExecutors))
+{
+  auto connectionHandler = oatpp::websocket::AsyncConnectionHandler::createShared(m_executor);
+  connectionHandler->setSocketInstanceListener(m_registry);
+  m_websocketConnectionHandler = connectionHandler;
+}
+
+Shard::~Shard() {
+  m_executor->stop();
+  m_executor->join();
+}
+
+std::shared_ptr<oatpp::async::Executor> Shard::getExecutor() {
+  return m_executor;
+}
+
+std::shared_ptr<Registry> Shard::getRegistry() {
+  return m_registry;
+}
+
+std::shared_ptr<oatpp::network::ConnectionHandler> Shard::getWebsocketConnectionHandler() {
+  return m_websocketConnectionHandler;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // APIServer
 
 APIServer::APIServer(const oatpp::Object<ServerConfigDto>& config,
-                     const std::shared_ptr<oatpp::async::Executor>& executor)
+                     const std::shared_ptr<oatpp::async::Executor>& executor,
+                     bool reusePort)
   : m_router(oatpp::web::server::HttpRouter::createShared())
 {
 
-  if(config->tls) {
+  if(reusePort) {
 
-    OATPP_LOGD("APIServer", "key_path='%s'", config->tls->pkFile->c_str());
-    OATPP_LOGD("APIServer", "chn_path='%s'", config->tls->chainFile->c_str());
+    /* TLS config is rejected by Runner in sharded mode */
+    m_connectionProvider = ReusePortConnectionProvider::createShared(
+      {config->host, config->port, oatpp::network::Address::IP_4});
+
+  } else if(config->tls) {
+
+    HELI_LOGD("APIServer", "key_path='%s'", config->tls->pkFile->c_str());
+    HELI_LOGD("APIServer", "chn_path='%s'", config->tls->chainFile->c_str());
 
     auto tlcConfig = oatpp::openssl::Config::createDefaultServerConfigShared(
       config->tls->pkFile->c_str(),config->tls->chainFile->c_str());
 
+    /* extended connections provide peer address for admission control */
     m_connectionProvider = oatpp::openssl::server::ConnectionProvider::createShared(
-      tlcConfig, {config->host, config->port, oatpp::network::Address::IP_4});
+      tlcConfig, {config->host, config->port, oatpp::network::Address::IP_4}, true);
 
   } else {
     m_connectionProvider = oatpp::network::tcp::server::ConnectionProvider::createShared(
-      {config->host, config->port, oatpp::network::Address::IP_4});
+      {config->host, config->port, oatpp::network::Address::IP_4}, true);
   }
 
   m_connectionHandler = oatpp::web::server::AsyncHttpConnectionHandler::createShared(m_router, executor);
@@ -69,12 +128,20 @@ std::shared_ptr<oatpp::web::server::HttpRouter> APIServer::getRouter() {
 }
 
 void APIServer::start() {
+  m_server = oatpp::network::Server::createShared(m_connectionProvider, m_connectionHandler);
   m_serverThread = std::thread([this]{
-    oatpp::network::Server server(m_connectionProvider, m_connectionHandler);
-    server.run();
+    m_server->run();
   });
 }
 
+void APIServer::stop() {
+  if(m_server) {
+    m_server->stop();
+  }
+  m_connectionProvider->stop();
+  m_connectionHandler->stop();
+}
+
 void APIServer::join() {
   m_serverThread.join();
 }
@@ -83,31 +150,123 @@ void APIServer::join() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Runner
 
+void Runner::onDrainSignal(int signal) {
+  (void) signal;
+  DRAIN_SIGNAL = 1;
+  /* second signal terminates the process right away. signal() is async-signal-safe in POSIX */
+  std::signal(SIGTERM, SIG_DFL);
+  std::signal(SIGINT, SIG_DFL);
+}
+
 Runner::Runner(const oatpp::Object<ConfigDto>& config,
                const std::shared_ptr<oatpp::async::Executor>& executor)
+  : m_config(config)
+{
+
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, controlExecutor, Constants::COMPONENT_CONTROL);
+  addProbe("app", executor, config->executor);
+  addProbe("control", controlExecutor, ExecutorFactory::getConfigOrSingleWorker(config->controlExecutor));
+
+  if(config->shards > 0) {
+
+    if((config->hostAPIServer && config->hostAPIServer->tls) || (config->clientAPIServer && config->clientAPIServer->tls)) {
+      HELI_LOGE("Runner", "Error: TLS is not supported with 'shards' > 0");
+      throw std::runtime_error("Error: TLS is not supported with 'shards' > 0");
+    }
+
+    /* sessions of a shard are pinned to the shard's executor - session executors would be silently unused */
+    if(config->sessionExecutors > 0) {
+      HELI_LOGE("Runner", "Error: 'sessionExecutors' is not supported with 'shards' > 0. Sessions are pinned to their shard's executor");
+      throw std::runtime_error("Error: 'sessionExecutors' is not supported with 'shards' > 0");
+    }
+
+    std::vector<std::weak_ptr<Registry>> registries;
+    for(v_uint32 i = 0; i < config->shards; i ++) {
+      auto shard = std::make_shared<Shard>(config, i);
+      registries.push_back(shard->getRegistry());
+      m_registries.push_back(shard->getRegistry());
+      addProbe("shard-" + oatpp::utils::conversion::int32ToStr(i), shard->getExecutor(),
+               ExecutorFactory::getConfigOrSingleWorker(config->shardExecutor));
+      m_shards.push_back(shard);
+    }
+
+    for(auto& shard : m_shards) {
+      shard->getRegistry()->setShards(registries);
+      addServers(config, shard->getExecutor(), shard->getWebsocketConnectionHandler(), true);
+    }
+
+    /* remote peers join via any shard - the session is routed to its owner shard */
+    OATPP_COMPONENT(std::shared_ptr<Relay>, relay);
+    relay->setRegistry(m_shards[0]->getRegistry());
+
+    HELI_LOGI("Runner", "Running %d shards", (v_int32) m_shards.size());
+
+  } else {
+    OATPP_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, websocketConnectionHandler, Constants::COMPONENT_WS_API);
+    OATPP_COMPONENT(std::shared_ptr<Registry>, registry);
+    OATPP_COMPONENT(std::shared_ptr<ExecutorPool>, sessionExecutors);
+    m_registries.push_back(registry);
+    if(config->sessionExecutors > 0) {
+      auto& executors = sessionExecutors->getExecutors();
+      for(v_uint32 i = 0; i < executors.size(); i ++) {
+        addProbe("session-" + oatpp::utils::conversion::int32ToStr(i), executors[i], ExecutorFactory::getConfigOrSingleWorker(nullptr));
+      }
+    }
+    addServers(config, executor, websocketConnectionHandler, false);
+  }
+
+}
+
+void Runner::addProbe(const oatpp::String& name,
+                      const std::shared_ptr<oatpp::async::Executor>& executor,
+                      const oatpp::Object<ExecutorConfigDto>& executorConfig)
+{
+  m_probes.push_back(std::make_shared<ExecutorProbe>(name, executor,
+                                                     ExecutorFactory::getProcessorWorkersCount(executorConfig),
+                                                     m_config->executorProbeMillis));
+}
+
+void Runner::addServers(const oatpp::Object<ConfigDto>& config,
+                        const std::shared_ptr<oatpp::async::Executor>& executor,
+                        const std::shared_ptr<oatpp::network::ConnectionHandler>& websocketConnectionHandler,
+                        bool reusePort)
 {
 
   /* host API server */
   assertServerConfig(config->hostAPIServer, "hostAPIServer", true);
 
-  auto hostServer = std::make_shared<APIServer>(config->hostAPIServer, executor);
-  hostServer->getRouter()->addController(std::make_shared<HostController>());
+  auto hostServer = std::make_shared<APIServer>(config->hostAPIServer, executor, reusePort);
+  hostServer->getRouter()->addController(std::make_shared<HostController>(websocketConnectionHandler));
   m_servers.push_back(hostServer);
 
+  if(config->adminToken) {
+    hostServer->getRouter()->addController(std::make_shared<AdminController>());
+  }
+
+  if(config->metrics) {
+    hostServer->getRouter()->addController(std::make_shared<MetricsController>(m_registries, m_probes));
+  }
+
+  /* inter-node links are accepted by host API server */
+  OATPP_COMPONENT(std::shared_ptr<Relay>, relay);
+  if(relay->isEnabled()) {
+    hostServer->getRouter()->addController(std::make_shared<RelayController>(relay->getConnectionHandler()));
+  }
+
   /* client API server */
   assertServerConfig(config->clientAPIServer, "clientAPIServer", false);
 
   if(config->clientAPIServer->host == config->hostAPIServer->host
   && config->clientAPIServer->port == config->hostAPIServer->port) {
 
-    hostServer->getRouter()->addController(std::make_shared<ClientController>());
+    hostServer->getRouter()->addController(std::make_shared<ClientController>(websocketConnectionHandler));
 
   } else {
 
     assertServerConfig(config->clientAPIServer, "clientAPIServer", true);
 
-    auto clientServer = std::make_shared<APIServer>(config->clientAPIServer, executor);
-    clientServer->getRouter()->addController(std::make_shared<ClientController>());
+    auto clientServer = std::make_shared<APIServer>(config->clientAPIServer, executor, reusePort);
+    clientServer->getRouter()->addController(std::make_shared<ClientController>(websocketConnectionHandler));
     m_servers.push_back(clientServer);
 
   }
@@ -119,29 +278,29 @@ void Runner::assertServerConfig(const oatpp::Object<ServerConfigDto>& config,
                                 bool checkTls) {
 
   if(!config) {
-    OATPP_LOGE("Runner", "Error: Missing config value - '%s'", serverName->c_str())
+    HELI_LOGE("Runner", "Error: Missing config value - '%s'", serverName->c_str());
     throw std::runtime_error("Error: Missing config value - '" + serverName + "'");
   }
 
   if(!config->host) {
-    OATPP_LOGE("Runner", "Error: Missing config value - '%s.host'", serverName->c_str())
+    HELI_LOGE("Runner", "Error: Missing config value - '%s.host'", serverName->c_str());
     throw std::runtime_error("Error: Missing config value - '" + serverName + ".host'");
   }
 
   if(!config->port) {
-    OATPP_LOGE("Runner", "Error: Missing config value - '$s.port'", serverName->c_str())
+    HELI_LOGE("Runner", "Error: Missing config value - '%s.port'", serverName->c_str());
     throw std::runtime_error("Error: Missing config value - '" + serverName + ".port'");
   }
 
   if(config->tls && checkTls) {
 
     if(!config->tls->pkFile) {
-      OATPP_LOGE("Runner", "Error: Missing config value - '$s.tls.pkFile'", serverName->c_str())
+      HELI_LOGE("Runner", "Error: Missing config value - '%s.tls.pkFile'", serverName->c_str());
       throw std::runtime_error("Error: Missing config value - '" + serverName + ".tls.pkFile'");
     }
 
     if(!config->tls->chainFile) {
-      OATPP_LOGE("Runner", "Error: Missing config value - '$s.tls.chainFile'", serverName->c_str())
+      HELI_LOGE("Runner", "Error: Missing config value - '%s.tls.chainFile'", serverName->c_str());
       throw std::runtime_error("Error: Missing config value - '" + serverName + ".tls.chainFile'");
     }
 
@@ -149,14 +308,139 @@ void Runner::assertServerConfig(const oatpp::Object<ServerConfigDto>& config,
 
 }
 
+v_int64 Runner::getSessionsCount() {
+  v_int64 result = 0;
+  for(auto& registry : m_registries) {
+    result += registry->getAllSessions().size();
+  }
+  return result;
+}
+
+bool Runner::handOffSessions() {
+
+  OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper, Constants::COMPONENT_WS_API);
+
+  std::vector<std::shared_ptr<Session>> sessions;
+  for(auto& registry : m_registries) {
+    auto registrySessions = registry->getAllSessions();
+    sessions.insert(sessions.end(), registrySessions.begin(), registrySessions.end());
+  }
+
+  std::vector<oatpp::String> snapshots;
+  snapshots.reserve(sessions.size());
+  for(auto& session : sessions) {
+    snapshots.push_back(objectMapper->writeToString(session->exportSnapshot()));
+  }
+
+  bool success = HandoffChannel::send(m_config->drain->handoffSocket, snapshots, m_config->drain->handoffTimeoutMillis);
+
+  for(auto& session : sessions) {
+    session->finishHandoff(success, m_config->drain->successorHostAPIUrl, m_config->drain->successorClientAPIUrl);
+  }
+
+  if(success) {
+    HELI_LOGI("Runner", "%d sessions handed off to successor", (v_int32) sessions.size());
+  } else {
+    HELI_LOGE("Runner", "Handoff failed. Serving existing sessions until they finish.");
+  }
+
+  return success;
+
+}
+
+void Runner::drain() {
+
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
+
+  HELI_LOGI("Runner", "Draining. New sessions are not accepted.");
+
+  /* draining process can't be a successor anymore */
+  if(m_handoffChannel) {
+    m_handoffChannel->stop();
+  }
+
+  if(m_config->drain->handoffSocket && handOffSessions()) {
+    /* give peers time to receive the reconnect message */
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while(admission->getPeersCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(m_config->drain->timeoutSeconds);
+  while(getSessionsCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  }
+
+  auto sessionsLeft = getSessionsCount();
+  if(sessionsLeft > 0) {
+    HELI_LOGW("Runner", "Drain timeout. %lld sessions are dropped.", (long long) sessionsLeft);
+  }
+
+}
+
 void Runner::start() {
+
+  /* successor - accept sessions handed off by the predecessor */
+  if(m_config->drain->acceptHandoffSocket) {
+
+    OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper, Constants::COMPONENT_WS_API);
+    auto registry = m_registries.front(); // sessions are routed to the owner shard
+    v_int64 resumeTimeout = (v_int64) m_config->drain->resumeTimeoutSeconds * 1000 * 1000;
+
+    m_handoffChannel = std::make_shared<HandoffChannel>(m_config->drain->acceptHandoffSocket,
+      [registry, objectMapper, resumeTimeout](const oatpp::String& data) {
+        try {
+          auto snapshot = objectMapper->readFromString<oatpp::Object<SessionSnapshotDto>>(data);
+          registry->restoreSession(snapshot, oatpp::base::Environment::getMicroTickCount() + resumeTimeout);
+        } catch (std::exception& e) {
+          HELI_LOGE("Runner", "Handoff - can't parse session snapshot: %s", e.what());
+        }
+      },
+      m_config->drain->handoffTimeoutMillis);
+
+  }
+
+  /* scheduling delay probes feed metrics and admission control */
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
+  for(auto& probe : m_probes) {
+    probe->start();
+  }
+  admission->setExecutorProbes(m_probes);
+
   for(auto& server : m_servers) {
     server->start();
   }
+
 }
 
 void Runner::join() {
+
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
+
+  while(!admission->isDraining()) {
+    if(DRAIN_SIGNAL) {
+      admission->setDraining();
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  drain();
+
+  for(auto& server : m_servers) {
+    server->stop();
+  }
+
   for(auto& server : m_servers) {
     server->join();
   }
+
+  for(auto& probe : m_probes) {
+    probe->stop();
+  }
+
+  HELI_LOGI("Runner", "Stopped");
+
 }
\ No newline at end of file
@@ -29,29 +29,81 @@
 
 #include "config/Config.hpp"
 
+#include "game/Registry.hpp"
+
+#include "network/HandoffChannel.hpp"
+
+#include "utils/ExecutorProbe.hpp"
+
 #include "oatpp/web/server/HttpRouter.hpp"
 
+#include "oatpp/network/Server.hpp"
 #include "oatpp/network/ConnectionHandler.hpp"
 #include "oatpp/network/ConnectionProvider.hpp"
 
 #include "oatpp/core/async/Executor.hpp"
 
+/**
+ * Runtime shard - executor, game sessions registry and websocket connection handler.
+ * Connections accepted by shard listeners are served by the shard executor.
+ */
+class Shard {
+private:
+  std::shared_ptr<oatpp::async::Executor> m_executor;
+  std::shared_ptr<ExecutorPool> m_sessionExecutors;
+  std::shared_ptr<Registry> m_registry;
+  std::shared_ptr<oatpp::network::ConnectionHandler> m_websocketConnectionHandler;
+public:
+
+  /**
+   * Constructor.
+   * @param config
+   * @param index - shard index.
+   */
+  Shard(const oatpp::Object<ConfigDto>& config, v_int32 index);
+
+  /**
+   * Stop and join shard executor.
+   */
+  ~Shard();
+
+  std::shared_ptr<oatpp::async::Executor> getExecutor();
+
+  std::shared_ptr<Registry> getRegistry();
+
+  std::shared_ptr<oatpp::network::ConnectionHandler> getWebsocketConnectionHandler();
+
+};
+
 class APIServer {
 private:
   std::shared_ptr<oatpp::web::server::HttpRouter> m_router;
   std::shared_ptr<oatpp::network::ServerConnectionProvider> m_connectionProvider;
   std::shared_ptr<oatpp::network::ConnectionHandler> m_connectionHandler;
+  std::shared_ptr<oatpp::network::Server> m_server;
 private:
   std::thread m_serverThread;
 public:
 
+  /**
+   * Constructor.
+   * @param config
+   * @param executor
+   * @param reusePort - listen with `SO_REUSEPORT` so that several servers may share the same port.
+   */
   APIServer(const oatpp::Object<ServerConfigDto>& config,
-            const std::shared_ptr<oatpp::async::Executor>& executor);
+            const std::shared_ptr<oatpp::async::Executor>& executor,
+            bool reusePort = false);
 
   std::shared_ptr<oatpp::web::server::HttpRouter> getRouter();
 
   void start();
 
+  /**
+   * Stop accepting connections and close open HTTP connections.
+   */
+  void stop();
+
   void join();
 
 };
@@ -59,10 +111,34 @@ public:
 class Runner {
 private:
   std::list<std::shared_ptr<APIServer>> m_servers;
+  std::vector<std::shared_ptr<Shard>> m_shards;
+  std::vector<std::shared_ptr<Registry>> m_registries;
+  std::vector<std::shared_ptr<ExecutorProbe>> m_probes;
+  std::shared_ptr<HandoffChannel> m_handoffChannel;
+  oatpp::Object<ConfigDto> m_config;
 private:
+  void addServers(const oatpp::Object<ConfigDto>& config,
+                  const std::shared_ptr<oatpp::async::Executor>& executor,
+                  const std::shared_ptr<oatpp::network::ConnectionHandler>& websocketConnectionHandler,
+                  bool reusePort);
   void assertServerConfig(const oatpp::Object<ServerConfigDto>& config,
                           const oatpp::String& serverName,
                           bool checkTls);
+private:
+  v_int64 getSessionsCount();
+  bool handOffSessions();
+  void drain();
+  void addProbe(const oatpp::String& name,
+                const std::shared_ptr<oatpp::async::Executor>& executor,
+                const oatpp::Object<ExecutorConfigDto>& executorConfig);
+public:
+
+  /**
+   * Signal handler - request drain. Resets `SIGTERM`/`SIGINT` to default - the second signal terminates the process.
+   * @param signal
+   */
+  static void onDrainSignal(int signal);
+
 public:
 
   Runner(const oatpp::Object<ConfigDto>& config,
@@ -70,6 +146,10 @@ public:
 
   void start();
 
+  /**
+   * Block until drain is requested (signal or admin API), then drain and stop servers.
+   * Existing sessions are either handed off to the successor or served until they finish (or until drain timeout).
+   */
   void join();
 
 };
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Cluster.hpp"
+
+#include "utils/AsyncLogger.hpp"
+#include "utils/Secret.hpp"
+
+Cluster::Cluster(const oatpp::Object<ClusterConfigDto>& config)
+  : m_localNodeIndex(-1)
+  , m_relay(false)
+{
+
+  if(!config) {
+    return;
+  }
+
+  if(!config->nodeId || !config->membersFile) {
+    HELI_LOGE("Cluster", "Error: Missing config value - 'cluster.nodeId' or 'cluster.membersFile'");
+    throw std::runtime_error("Error: Missing config value - 'cluster.nodeId' or 'cluster.membersFile'");
+  }
+
+  auto json = oatpp::String::loadFromFile(config->membersFile->c_str());
+  m_nodes = m_mapper.readFromString<oatpp::Vector<oatpp::Object<ClusterNodeDto>>>(json);
+
+  if(!m_nodes) {
+    m_nodes = oatpp::Vector<oatpp::Object<ClusterNodeDto>>({});
+  }
+
+  std::vector<oatpp::String> nodeIds;
+  for(v_int32 i = 0; i < (v_int32) m_nodes->size(); i ++) {
+    auto& node = m_nodes[i];
+    if(!node || !node->id || !node->hostAPIUrl || !node->clientAPIUrl) {
+      HELI_LOGE("Cluster", "Error: Members file - node #%d must have 'id', 'hostAPIUrl' and 'clientAPIUrl'", i);
+      throw std::runtime_error("Error: Members file - node must have 'id', 'hostAPIUrl' and 'clientAPIUrl'");
+    }
+    if(node->id == config->nodeId) {
+      m_localNodeIndex = i;
+    }
+    nodeIds.push_back(node->id);
+  }
+
+  if(m_localNodeIndex < 0) {
+    HELI_LOGE("Cluster", "Error: Node '%s' is not listed in members file '%s'", config->nodeId->c_str(), config->membersFile->c_str());
+    throw std::runtime_error("Error: Node '" + config->nodeId + "' is not listed in members file");
+  }
+
+  if(config->relay && (!config->relaySecret || config->relaySecret->empty())) {
+    HELI_LOGE("Cluster", "Error: Missing config value - 'cluster.relaySecret'. Relay mode requires a shared secret");
+    throw std::runtime_error("Error: Missing config value - 'cluster.relaySecret'");
+  }
+
+  m_ring = std::make_shared<HashRing>(nodeIds, config->virtualNodes);
+  m_relay = config->relay;
+  m_relaySecret = config->relaySecret;
+
+  HELI_LOGI("Cluster", "Node '%s' joined cluster of %d nodes", config->nodeId->c_str(), (v_int32) m_nodes->size());
+
+}
+
+bool Cluster::isEnabled() {
+  return m_ring != nullptr;
+}
+
+bool Cluster::isRelayEnabled() {
+  return m_ring != nullptr && m_relay;
+}
+
+bool Cluster::checkRelaySecret(const oatpp::String& secret) {
+  return isRelayEnabled() && Secret::equals(secret, m_relaySecret);
+}
+
+oatpp::String Cluster::getRelaySecret() {
+  return m_relaySecret;
+}
+
+oatpp::Object<ClusterNodeDto> Cluster::getRemoteSessionOwner(const oatpp::String& gameId, const oatpp::String& sessionId) {
+
+  if(!m_ring || !gameId || !sessionId) {
+    return nullptr;
+  }
+
+  auto index = m_ring->getNode(gameId + "/" + sessionId);
+  if(index < 0 || index == m_localNodeIndex) {
+    return nullptr;
+  }
+
+  return m_nodes[index];
+
+}
+
+oatpp::Object<ClusterNodeDto> Cluster::getLocalNode() {
+  if(m_localNodeIndex < 0) {
+    return nullptr;
+  }
+  return m_nodes[m_localNodeIndex];
+}
+
+oatpp::Vector<oatpp::Object<ClusterNodeDto>> Cluster::getNodes() {
+  return m_nodes;
+}
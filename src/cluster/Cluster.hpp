@@ -0,0 +1,132 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_cluster_Cluster_hpp
+#define Helicopter_cluster_Cluster_hpp
+
+#include "./HashRing.hpp"
+
+#include "config/Config.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+/**
+ * Cluster node as listed in the members file.
+ */
+class ClusterNodeDto : public oatpp::DTO {
+
+  DTO_INIT(ClusterNodeDto, DTO)
+
+  /**
+   * Unique node ID.
+   */
+  DTO_FIELD(String, id);
+
+  /**
+   * Base URL of the node's Host API Server - ex.: `http://10.0.0.1:8000`.
+   */
+  DTO_FIELD(String, hostAPIUrl);
+
+  /**
+   * Base URL of the node's Client API Server - ex.: `http://10.0.0.1:8001`.
+   */
+  DTO_FIELD(String, clientAPIUrl);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+/**
+ * Cluster membership and session placement.
+ * Each `(gameId, sessionId)` is owned by a node chosen by consistent hashing over the members list.
+ */
+class Cluster {
+private:
+  oatpp::parser::json::mapping::ObjectMapper m_mapper;
+  oatpp::Vector<oatpp::Object<ClusterNodeDto>> m_nodes;
+  v_int32 m_localNodeIndex;
+  std::shared_ptr<HashRing> m_ring;
+  bool m_relay;
+  oatpp::String m_relaySecret;
+public:
+
+  /**
+   * Constructor.
+   * Throws `std::runtime_error` if members file can't be loaded or local node is not in the members list.
+   * @param config - cluster config. null - cluster mode is disabled, all sessions are local.
+   */
+  Cluster(const oatpp::Object<ClusterConfigDto>& config);
+
+  /**
+   * Check if cluster mode is enabled.
+   * @return
+   */
+  bool isEnabled();
+
+  /**
+   * Check if peers of remote sessions should be relayed to the owner node instead of being redirected.
+   * @return
+   */
+  bool isRelayEnabled();
+
+  /**
+   * Check secret presented by the node opening relay link.
+   * @param secret
+   * @return - `true` if relay is enabled and secret matches the cluster secret.
+   */
+  bool checkRelaySecret(const oatpp::String& secret);
+
+  /**
+   * Get cluster secret sent when opening relay link.
+   * @return
+   */
+  oatpp::String getRelaySecret();
+
+  /**
+   * Get node owning the session.
+   * @param gameId
+   * @param sessionId
+   * @return - owner node or `nullptr` if session is owned by this node (or cluster mode is disabled).
+   */
+  oatpp::Object<ClusterNodeDto> getRemoteSessionOwner(const oatpp::String& gameId, const oatpp::String& sessionId);
+
+  /**
+   * Get this node.
+   * @return - local node or `nullptr` if cluster mode is disabled.
+   */
+  oatpp::Object<ClusterNodeDto> getLocalNode();
+
+  /**
+   * Get all cluster members.
+   * @return
+   */
+  oatpp::Vector<oatpp::Object<ClusterNodeDto>> getNodes();
+
+};
+
+#endif //Helicopter_cluster_Cluster_hpp
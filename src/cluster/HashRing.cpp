@@ -0,0 +1,72 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "HashRing.hpp"
+
+v_uint64 HashRing::hash(const void* data, v_buff_size size) {
+
+  /* FNV-1a */
+  auto bytes = (const v_uint8*) data;
+  v_uint64 h = 14695981039346656037ULL;
+  for(v_buff_size i = 0; i < size; i ++) {
+    h ^= bytes[i];
+    h *= 1099511628211ULL;
+  }
+
+  /* murmur3 finalizer - spread similar keys over the whole ring */
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+
+}
+
+HashRing::HashRing(const std::vector<oatpp::String>& nodeIds, v_int32 virtualNodes) {
+  for(v_int32 node = 0; node < (v_int32) nodeIds.size(); node ++) {
+    for(v_int32 i = 0; i < virtualNodes; i ++) {
+      std::string point = *nodeIds[node] + "#" + std::to_string(i);
+      m_ring.insert({hash(point.data(), point.size()), node});
+    }
+  }
+}
+
+v_int32 HashRing::getNode(const oatpp::String& key) const {
+
+  if(m_ring.empty()) {
+    return -1;
+  }
+
+  auto it = m_ring.lower_bound(hash(key->data(), key->size()));
+  if(it == m_ring.end()) {
+    it = m_ring.begin();
+  }
+
+  return it->second;
+
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_cluster_HashRing_hpp
+#define Helicopter_cluster_HashRing_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <map>
+#include <vector>
+
+/**
+ * Consistent hash ring.
+ * Each node is placed on the ring multiple times (virtual nodes) for even distribution of keys.
+ * When a node is added or removed only keys of that node move.
+ */
+class HashRing {
+private:
+  std::map<v_uint64, v_int32> m_ring;
+public:
+
+  /**
+   * Stable 64-bit hash - the same on every node regardless of platform and build.
+   * @param data
+   * @param size
+   * @return
+   */
+  static v_uint64 hash(const void* data, v_buff_size size);
+
+  /**
+   * Constructor.
+   * @param nodeIds - IDs of nodes. Index in this vector is the node index returned by `getNode`.
+   * @param virtualNodes - number of points on the ring per node.
+   */
+  HashRing(const std::vector<oatpp::String>& nodeIds, v_int32 virtualNodes);
+
+  /**
+   * Get node owning the key.
+   * @param key
+   * @return - node index or `-1` if ring is empty.
+   */
+  v_int32 getNode(const oatpp::String& key) const;
+
+};
+
+#endif //Helicopter_cluster_HashRing_hpp
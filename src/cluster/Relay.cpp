@@ -0,0 +1,393 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Relay.hpp"
+
+#include "utils/AsyncLogger.hpp"
+
+#include "game/Registry.hpp"
+
+#include "oatpp-websocket/Connector.hpp"
+
+#include "oatpp/network/tcp/client/ConnectionProvider.hpp"
+#include "oatpp/network/Url.hpp"
+
+Relay::Relay()
+  : m_refCounter(0)
+{}
+
+std::shared_ptr<Relay> Relay::createShared() {
+  auto relay = std::shared_ptr<Relay>(new Relay());
+  relay->m_connectionHandler = oatpp::websocket::AsyncConnectionHandler::createShared(relay->m_asyncExecutor);
+  relay->m_connectionHandler->setSocketInstanceListener(relay);
+  return relay;
+}
+
+bool Relay::isEnabled() {
+  return m_cluster->isRelayEnabled();
+}
+
+void Relay::setRegistry(const std::shared_ptr<Registry>& registry) {
+  m_registry = registry;
+}
+
+std::shared_ptr<oatpp::network::ConnectionHandler> Relay::getConnectionHandler() {
+  return m_connectionHandler;
+}
+
+std::shared_ptr<RelayLink> Relay::createLink(const oatpp::String& nodeId) {
+  return std::make_shared<RelayLink>(nodeId, m_asyncExecutor, m_objectMapper, shared_from_this(),
+                                     m_config->cluster->relayMaxQueuedFrames);
+}
+
+std::shared_ptr<RelayLink> Relay::getOutboundLink(const oatpp::Object<ClusterNodeDto>& node) {
+
+  std::shared_ptr<RelayLink> link;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_outboundLinks.find(node->id);
+    if(it != m_outboundLinks.end() && !it->second->isClosed()) {
+      return it->second;
+    }
+    link = createLink(node->id);
+    m_outboundLinks[node->id] = link;
+  }
+
+  connect(link, node);
+  return link;
+
+}
+
+void Relay::connect(const std::shared_ptr<RelayLink>& link, const oatpp::Object<ClusterNodeDto>& node) {
+
+  class ConnectCoroutine : public oatpp::async::Coroutine<ConnectCoroutine> {
+  private:
+    std::shared_ptr<oatpp::websocket::Connector> m_connector;
+    oatpp::String m_path;
+    oatpp::websocket::Connector::Headers m_headers;
+    std::shared_ptr<RelayLink> m_link;
+  public:
+
+    ConnectCoroutine(const std::shared_ptr<oatpp::websocket::Connector>& connector,
+                     const oatpp::String& path,
+                     const oatpp::websocket::Connector::Headers& headers,
+                     const std::shared_ptr<RelayLink>& link)
+      : m_connector(connector)
+      , m_path(path)
+      , m_headers(headers)
+      , m_link(link)
+    {}
+
+    Action act() override {
+      return m_connector->connectAsync(m_path, m_headers).callbackTo(&ConnectCoroutine::onConnected);
+    }
+
+    Action onConnected(const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>& connection) {
+      auto socket = oatpp::websocket::AsyncWebSocket::createShared(connection, true /* maskOutgoingMessages for clients always true */);
+      socket->setListener(m_link);
+      m_link->setSocket(socket);
+      HELI_LOGD("Relay", "Link to node '%s' connected", m_link->getNodeId()->c_str());
+      return socket->listenAsync().next(yieldTo(&ConnectCoroutine::onFinished));
+    }
+
+    Action onFinished() {
+      m_link->close();
+      return finish();
+    }
+
+    Action handleError(oatpp::async::Error* error) override {
+      HELI_LOGE("Relay", "Link to node '%s' failed - %s", m_link->getNodeId()->c_str(), error->what());
+      m_link->close();
+      return finish();
+    }
+
+  };
+
+  auto url = oatpp::network::Url::Parser::parseUrl(node->hostAPIUrl);
+  auto connectionProvider = oatpp::network::tcp::client::ConnectionProvider::createShared(
+    {url.authority.host, (v_uint16) (url.authority.port > 0 ? url.authority.port : 80), oatpp::network::Address::IP_4});
+  auto connector = oatpp::websocket::Connector::createShared(connectionProvider);
+
+  auto path = oatpp::String("api/relay?") + Constants::PARAM_NODE_ID + "=" + m_cluster->getLocalNode()->id;
+
+  oatpp::websocket::Connector::Headers headers;
+  headers.put(Constants::HEADER_CLUSTER_SECRET, m_cluster->getRelaySecret());
+
+  m_asyncExecutor->execute<ConnectCoroutine>(connector, path, headers, link);
+
+}
+
+void Relay::attachPeer(const std::shared_ptr<AsyncWebSocket>& socket,
+                       const oatpp::Object<ClusterNodeDto>& owner,
+                       const oatpp::String& gameId,
+                       const oatpp::String& sessionId,
+                       bool isHost,
+                       const oatpp::String& address,
+                       v_int64 maxMessageSize)
+{
+
+  auto link = getOutboundLink(owner);
+  auto ref = m_refCounter ++;
+  auto peer = std::make_shared<RelayedPeer>(socket, link, m_asyncExecutor, ref, maxMessageSize);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_relayedPeers[ref] = peer;
+  }
+
+  socket->setListener(peer);
+
+  auto frame = RelayFrameDto::createShared();
+  frame->type = RelayFrameType::JOIN;
+  frame->refs = oatpp::Vector<oatpp::Int64>({ref});
+  frame->gameId = gameId;
+  frame->sessionId = sessionId;
+  frame->isHost = isHost;
+  frame->address = address;
+  link->send(frame);
+
+  HELI_LOGD("Relay", "peer ref=%lld relayed to node '%s'", (long long) ref, owner->id->c_str());
+
+}
+
+void Relay::detachPeer(const std::shared_ptr<RelayedPeer>& peer) {
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_relayedPeers.erase(peer->getRef());
+  }
+
+  peer->close();
+
+  auto frame = RelayFrameDto::createShared();
+  frame->type = RelayFrameType::LEAVE;
+  frame->refs = oatpp::Vector<oatpp::Int64>({peer->getRef()});
+  peer->getLink()->send(frame);
+
+}
+
+void Relay::onOwnerFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame) {
+
+  if(!frame->refs || frame->refs->size() != 1 || !frame->refs[0]) {
+    return;
+  }
+
+  v_int64 ref = frame->refs[0];
+
+  switch(*frame->type) {
+
+    case RelayFrameType::JOIN: {
+      auto registry = m_registry.lock();
+      if(registry) {
+        auto peer = registry->addRemotePeer(link, ref, frame->gameId, frame->sessionId, frame->isHost, frame->address);
+        if(peer) {
+          bool added = false;
+          {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!link->isClosed()) {
+              m_remotePeers[link.get()][ref] = peer;
+              added = true;
+            }
+          }
+          if(!added) {
+            registry->removeRemotePeer(peer);
+          }
+        }
+      }
+      break;
+    }
+
+    case RelayFrameType::MESSAGE: {
+      std::shared_ptr<Peer> peer;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto linkIt = m_remotePeers.find(link.get());
+        if(linkIt != m_remotePeers.end()) {
+          auto it = linkIt->second.find(ref);
+          if(it != linkIt->second.end()) {
+            peer = it->second;
+          }
+        }
+      }
+      if(peer) {
+        peer->handleRelayedMessage(frame->data);
+      }
+      break;
+    }
+
+    case RelayFrameType::LEAVE: {
+      std::shared_ptr<Peer> peer;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto linkIt = m_remotePeers.find(link.get());
+        if(linkIt != m_remotePeers.end()) {
+          auto it = linkIt->second.find(ref);
+          if(it != linkIt->second.end()) {
+            peer = it->second;
+            linkIt->second.erase(it);
+          }
+        }
+      }
+      auto registry = m_registry.lock();
+      if(peer && registry) {
+        registry->removeRemotePeer(peer);
+      }
+      break;
+    }
+
+    default:
+      break;
+
+  }
+
+}
+
+void Relay::onEdgeFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame) {
+
+  if(!frame->refs) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<RelayedPeer>> peers;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto& ref : *frame->refs) {
+      if(ref) {
+        auto it = m_relayedPeers.find(*ref);
+        if(it != m_relayedPeers.end()) {
+          peers.push_back(it->second);
+        }
+      }
+    }
+  }
+
+  switch(*frame->type) {
+
+    case RelayFrameType::DELIVER:
+      for(auto& peer : peers) {
+        peer->deliver(frame->data);
+      }
+      break;
+
+    case RelayFrameType::CLOSE:
+      for(auto& peer : peers) {
+        peer->close();
+      }
+      break;
+
+    default:
+      break;
+
+  }
+
+}
+
+void Relay::onFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame) {
+  switch(*frame->type) {
+    case RelayFrameType::JOIN:
+    case RelayFrameType::MESSAGE:
+    case RelayFrameType::LEAVE:
+      onOwnerFrame(link, frame);
+      break;
+    default:
+      onEdgeFrame(link, frame);
+  }
+}
+
+void Relay::onLinkClosed(const std::shared_ptr<RelayLink>& link) {
+
+  HELI_LOGD("Relay", "Link to node '%s' closed", link->getNodeId()->c_str());
+
+  std::vector<std::shared_ptr<RelayedPeer>> relayedPeers;
+  std::vector<std::shared_ptr<Peer>> remotePeers;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto linkIt = m_outboundLinks.find(link->getNodeId());
+    if(linkIt != m_outboundLinks.end() && linkIt->second == link) {
+      m_outboundLinks.erase(linkIt);
+    }
+
+    for(auto& pair : m_relayedPeers) {
+      if(pair.second->getLink() == link) {
+        relayedPeers.push_back(pair.second);
+      }
+    }
+
+    auto peersIt = m_remotePeers.find(link.get());
+    if(peersIt != m_remotePeers.end()) {
+      for(auto& pair : peersIt->second) {
+        remotePeers.push_back(pair.second);
+      }
+      m_remotePeers.erase(peersIt);
+    }
+  }
+
+  /* relayed peers reconnect and get relayed over the new link */
+  for(auto& peer : relayedPeers) {
+    peer->close();
+  }
+
+  auto registry = m_registry.lock();
+  if(registry) {
+    for(auto& peer : remotePeers) {
+      registry->removeRemotePeer(peer);
+    }
+  }
+
+}
+
+void Relay::onAfterCreate_NonBlocking(const std::shared_ptr<AsyncWebSocket>& socket, const std::shared_ptr<const ParameterMap>& params) {
+
+  oatpp::String nodeId;
+  auto it = params->find(Constants::PARAM_NODE_ID);
+  if(it != params->end()) {
+    nodeId = it->second;
+  }
+
+  if(!nodeId) {
+    socket->getConnection().invalidate();
+    return;
+  }
+
+  auto link = createLink(nodeId);
+  socket->setListener(link);
+  link->setSocket(socket);
+
+  HELI_LOGD("Relay", "Link from node '%s' accepted", nodeId->c_str());
+
+}
+
+void Relay::onBeforeDestroy_NonBlocking(const std::shared_ptr<AsyncWebSocket>& socket) {
+  auto link = std::static_pointer_cast<RelayLink>(socket->getListener());
+  if(link) {
+    link->close();
+  } else {
+    socket->getConnection().invalidate();
+  }
+}
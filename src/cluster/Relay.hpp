@@ -0,0 +1,139 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_cluster_Relay_hpp
+#define Helicopter_cluster_Relay_hpp
+
+#include "./Cluster.hpp"
+#include "./RelayLink.hpp"
+#include "./RelayedPeer.hpp"
+
+#include "Constants.hpp"
+
+#include "oatpp-websocket/AsyncConnectionHandler.hpp"
+
+#include "oatpp/core/macro/component.hpp"
+
+#include <unordered_map>
+
+class Registry; // FWD
+class Peer; // FWD
+
+/**
+ * Inter-node relay.
+ * Edge side - peers connected to this node whose sessions are owned by other nodes are relayed to the owner nodes.
+ * Owner side - peers relayed by other nodes are added to sessions of this node as remote peers.
+ * There is one link per pair of nodes - all relayed peers of both nodes are multiplexed over it.
+ */
+class Relay : public oatpp::websocket::AsyncConnectionHandler::SocketInstanceListener,
+              public RelayLink::Handler,
+              public std::enable_shared_from_this<Relay> {
+private:
+  std::unordered_map<oatpp::String, std::shared_ptr<RelayLink>> m_outboundLinks; // owner node ID --> link
+  std::unordered_map<v_int64, std::shared_ptr<RelayedPeer>> m_relayedPeers; // edge side. ref --> peer
+  std::unordered_map<RelayLink*, std::unordered_map<v_int64, std::shared_ptr<Peer>>> m_remotePeers; // owner side. link --> ref --> peer
+  std::atomic<v_int64> m_refCounter;
+  std::mutex m_mutex;
+private:
+  std::weak_ptr<Registry> m_registry;
+  std::shared_ptr<oatpp::websocket::AsyncConnectionHandler> m_connectionHandler;
+private:
+  /* Inject application components */
+  OATPP_COMPONENT(oatpp::Object<ConfigDto>, m_config);
+  OATPP_COMPONENT(std::shared_ptr<Cluster>, m_cluster);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, m_asyncExecutor);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, m_objectMapper, Constants::COMPONENT_WS_API);
+private:
+  std::shared_ptr<RelayLink> createLink(const oatpp::String& nodeId);
+  std::shared_ptr<RelayLink> getOutboundLink(const oatpp::Object<ClusterNodeDto>& node);
+  void connect(const std::shared_ptr<RelayLink>& link, const oatpp::Object<ClusterNodeDto>& node);
+  void onOwnerFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame);
+  void onEdgeFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame);
+private:
+  Relay();
+public:
+
+  /**
+   * Create shared Relay.
+   * @return
+   */
+  static std::shared_ptr<Relay> createShared();
+
+  /**
+   * Check if relay is enabled in cluster config.
+   * @return
+   */
+  bool isEnabled();
+
+  /**
+   * Set registry to add remote peers to.
+   * @param registry
+   */
+  void setRegistry(const std::shared_ptr<Registry>& registry);
+
+  /**
+   * Get connection handler for inbound links.
+   * @return
+   */
+  std::shared_ptr<oatpp::network::ConnectionHandler> getConnectionHandler();
+
+  /**
+   * Edge side. Relay peer to the node owning the session.
+   * @param socket - peer's socket.
+   * @param owner - node owning the session.
+   * @param gameId
+   * @param sessionId
+   * @param isHost
+   * @param address - peer's address. Owner node checks its connect rate.
+   * @param maxMessageSize - max size of the message from peer.
+   */
+  void attachPeer(const std::shared_ptr<AsyncWebSocket>& socket,
+                  const oatpp::Object<ClusterNodeDto>& owner,
+                  const oatpp::String& gameId,
+                  const oatpp::String& sessionId,
+                  bool isHost,
+                  const oatpp::String& address,
+                  v_int64 maxMessageSize);
+
+  /**
+   * Edge side. Relayed peer disconnected.
+   * @param peer
+   */
+  void detachPeer(const std::shared_ptr<RelayedPeer>& peer);
+
+public: // RelayLink::Handler
+
+  void onFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame) override;
+  void onLinkClosed(const std::shared_ptr<RelayLink>& link) override;
+
+public: // SocketInstanceListener - inbound links
+
+  void onAfterCreate_NonBlocking(const std::shared_ptr<AsyncWebSocket>& socket, const std::shared_ptr<const ParameterMap>& params) override;
+  void onBeforeDestroy_NonBlocking(const std::shared_ptr<AsyncWebSocket>& socket) override;
+
+};
+
+#endif //Helicopter_cluster_Relay_hpp
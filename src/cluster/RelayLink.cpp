@@ -0,0 +1,236 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "RelayLink.hpp"
+
+#include "utils/AsyncLogger.hpp"
+#include "utils/Metrics.hpp"
+
+RelayLink::RelayLink(const oatpp::String& nodeId,
+                     const std::shared_ptr<oatpp::async::Executor>& executor,
+                     const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                     const std::shared_ptr<Handler>& handler,
+                     v_int64 maxQueuedFrames)
+  : m_nodeId(nodeId)
+  , m_executor(executor)
+  , m_objectMapper(objectMapper)
+  , m_handler(handler)
+  , m_maxQueuedFrames(maxQueuedFrames)
+  , m_outbox(std::make_shared<Outbox>())
+  , m_closed(false)
+  , m_broken(false)
+{}
+
+void RelayLink::startSending() {
+
+  class SendFramesCoroutine : public oatpp::async::Coroutine<SendFramesCoroutine> {
+  private:
+    oatpp::async::Lock* m_lock;
+    std::shared_ptr<AsyncWebSocket> m_websocket;
+    std::shared_ptr<Outbox> m_outbox;
+  public:
+
+    SendFramesCoroutine(oatpp::async::Lock* lock,
+                        const std::shared_ptr<AsyncWebSocket>& websocket,
+                        const std::shared_ptr<Outbox>& outbox)
+      : m_lock(lock)
+      , m_websocket(websocket)
+      , m_outbox(outbox)
+    {}
+
+    Action act() override {
+
+      std::unique_lock<std::mutex> lock(m_outbox->mutex);
+      if(m_outbox->queue.empty()) {
+        m_outbox->active = false;
+        return finish();
+      }
+      auto frame = m_outbox->queue.back();
+      m_outbox->queue.pop_back();
+      lock.unlock();
+
+      return oatpp::async::synchronize(m_lock, m_websocket->sendOneFrameTextAsync(frame)).next(repeat());
+
+    }
+
+    Action handleError(oatpp::async::Error* error) override {
+      return yieldTo(&SendFramesCoroutine::act);
+    }
+
+  };
+
+  /* m_outbox->mutex is locked by caller */
+  if(!m_outbox->active && !m_outbox->queue.empty()) {
+    std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    if(m_socket) {
+      m_outbox->active = true;
+      m_executor->execute<SendFramesCoroutine>(&m_writeLock, m_socket, m_outbox);
+    }
+  }
+
+}
+
+void RelayLink::breakConnection() {
+  /* close() notifies handler which takes session locks - callers of send() may hold them.
+   * Invalidate connection instead - the link is closed when the socket stops listening */
+  std::lock_guard<std::mutex> socketLock(m_socketMutex);
+  if(m_socket) {
+    m_socket->getConnection().invalidate();
+  }
+}
+
+void RelayLink::setSocket(const std::shared_ptr<AsyncWebSocket>& socket) {
+  {
+    std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    m_socket = socket;
+    if(m_broken) {
+      m_socket->getConnection().invalidate();
+      return;
+    }
+  }
+  std::lock_guard<std::mutex> lock(m_outbox->mutex);
+  startSending();
+}
+
+oatpp::String RelayLink::getNodeId() {
+  return m_nodeId;
+}
+
+bool RelayLink::send(const oatpp::Object<RelayFrameDto>& frame) {
+
+  if(m_closed || m_broken) {
+    return false;
+  }
+
+  auto data = m_objectMapper->writeToString(frame);
+
+  std::lock_guard<std::mutex> lock(m_outbox->mutex);
+  if((v_int64) m_outbox->queue.size() >= m_maxQueuedFrames) {
+    if(!m_broken.exchange(true)) {
+      HELI_LOGE("RelayLink", "Outbox overflow. Node='%s'. Link closed.", m_nodeId->c_str());
+      Metrics::increment(Metrics::RELAY_OVERFLOWS);
+      m_outbox->queue.clear();
+      breakConnection();
+    }
+    return false;
+  }
+  m_outbox->queue.push_front(data);
+  startSending();
+  return true;
+
+}
+
+bool RelayLink::deliver(const oatpp::Vector<oatpp::Int64>& refs, const oatpp::String& data) {
+  auto frame = RelayFrameDto::createShared();
+  frame->type = RelayFrameType::DELIVER;
+  frame->refs = refs;
+  frame->data = data;
+  return send(frame);
+}
+
+bool RelayLink::deliver(v_int64 ref, const oatpp::String& data) {
+  return deliver(oatpp::Vector<oatpp::Int64>({ref}), data);
+}
+
+void RelayLink::closePeer(v_int64 ref) {
+  auto frame = RelayFrameDto::createShared();
+  frame->type = RelayFrameType::CLOSE;
+  frame->refs = oatpp::Vector<oatpp::Int64>({ref});
+  send(frame);
+}
+
+void RelayLink::close() {
+
+  if(m_closed.exchange(true)) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    if(m_socket) {
+      m_socket->getConnection().invalidate();
+      m_socket.reset();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_outbox->mutex);
+    m_outbox->queue.clear();
+  }
+
+  auto handler = m_handler.lock();
+  if(handler) {
+    handler->onLinkClosed(shared_from_this());
+  }
+
+}
+
+bool RelayLink::isClosed() {
+  return m_closed || m_broken;
+}
+
+oatpp::async::CoroutineStarter RelayLink::onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) {
+  return oatpp::async::synchronize(&m_writeLock, socket->sendPongAsync(message));
+}
+
+oatpp::async::CoroutineStarter RelayLink::onPong(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) {
+  return nullptr; // do nothing
+}
+
+oatpp::async::CoroutineStarter RelayLink::onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) {
+  HELI_LOGD("RelayLink", "onClose received. Node='%s'", m_nodeId->c_str());
+  return nullptr; // do nothing
+}
+
+oatpp::async::CoroutineStarter RelayLink::readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) {
+
+  if(size == 0) { // message transfer finished
+
+    auto wholeMessage = m_messageBuffer.toString();
+    m_messageBuffer.setCurrentPosition(0);
+
+    oatpp::Object<RelayFrameDto> frame;
+
+    try {
+      frame = m_objectMapper->readFromString<oatpp::Object<RelayFrameDto>>(wholeMessage);
+    } catch (const std::runtime_error& e) {
+      HELI_LOGE("RelayLink", "Can't parse relay frame. Node='%s'. Link closed.", m_nodeId->c_str());
+      close();
+      return nullptr;
+    }
+
+    auto handler = m_handler.lock();
+    if(frame && frame->type && handler) {
+      handler->onFrame(shared_from_this(), frame);
+    }
+
+  } else if(size > 0) { // message frame received
+    m_messageBuffer.writeSimple(data, size);
+  }
+
+  return nullptr;
+
+}
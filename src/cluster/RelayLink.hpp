@@ -0,0 +1,229 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_cluster_RelayLink_hpp
+#define Helicopter_cluster_RelayLink_hpp
+
+#include "oatpp-websocket/AsyncWebSocket.hpp"
+
+#include "oatpp/core/async/Lock.hpp"
+#include "oatpp/core/async/Executor.hpp"
+#include "oatpp/core/data/mapping/ObjectMapper.hpp"
+#include "oatpp/core/data/stream/BufferStream.hpp"
+#include "oatpp/core/Types.hpp"
+#include "oatpp/core/macro/codegen.hpp"
+
+#include <list>
+#include <mutex>
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+ENUM(RelayFrameType, v_int32,
+
+     /**
+      * Edge --> Owner. Peer connected to the edge node joins session on the owner node.
+      */
+     VALUE(JOIN, 0),
+
+     /**
+      * Edge --> Owner. Message from peer. `data` - message as received from peer.
+      */
+     VALUE(MESSAGE, 1),
+
+     /**
+      * Edge --> Owner. Peer disconnected from the edge node.
+      */
+     VALUE(LEAVE, 2),
+
+     /**
+      * Owner --> Edge. Deliver `data` - pre-encoded message, to all peers listed in `refs`.
+      */
+     VALUE(DELIVER, 3),
+
+     /**
+      * Owner --> Edge. Close connections of peers listed in `refs`.
+      */
+     VALUE(CLOSE, 4)
+
+);
+
+/**
+ * Frame of the node-to-node relay link.
+ * Peers are addressed by `refs` - IDs of peer connections on the edge node.
+ */
+class RelayFrameDto : public oatpp::DTO {
+
+  DTO_INIT(RelayFrameDto, DTO)
+
+  DTO_FIELD(Enum<RelayFrameType>::AsNumber, type);
+  DTO_FIELD(Vector<Int64>, refs);
+  DTO_FIELD(String, gameId);
+  DTO_FIELD(String, sessionId);
+  DTO_FIELD(Boolean, isHost);
+  DTO_FIELD(String, address); // JOIN - address of the relayed peer for admission control on the owner node
+  DTO_FIELD(String, data);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+/**
+ * Persistent node-to-node connection multiplexing peers of many sessions.
+ * Frames are sent in order. Frames sent before the link is connected are queued.
+ */
+class RelayLink : public oatpp::websocket::AsyncWebSocket::Listener, public std::enable_shared_from_this<RelayLink> {
+public:
+
+  /**
+   * Receiver of relay frames.
+   */
+  class Handler {
+  public:
+
+    /**
+     * Default virtual destructor.
+     */
+    virtual ~Handler() = default;
+
+    /**
+     * Called when frame is received.
+     * @param link
+     * @param frame
+     */
+    virtual void onFrame(const std::shared_ptr<RelayLink>& link, const oatpp::Object<RelayFrameDto>& frame) = 0;
+
+    /**
+     * Called once when link is closed.
+     * @param link
+     */
+    virtual void onLinkClosed(const std::shared_ptr<RelayLink>& link) = 0;
+
+  };
+
+private:
+
+  struct Outbox {
+    std::list<oatpp::String> queue;
+    std::mutex mutex;
+    bool active = false;
+  };
+
+private:
+  oatpp::String m_nodeId;
+  std::shared_ptr<oatpp::async::Executor> m_executor;
+  std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper;
+  std::weak_ptr<Handler> m_handler;
+  v_int64 m_maxQueuedFrames;
+private:
+  oatpp::data::stream::BufferOutputStream m_messageBuffer;
+  oatpp::async::Lock m_writeLock;
+  std::shared_ptr<AsyncWebSocket> m_socket;
+  std::shared_ptr<Outbox> m_outbox;
+  std::atomic<bool> m_closed;
+  std::atomic<bool> m_broken;
+  std::mutex m_socketMutex;
+private:
+  void startSending();
+  void breakConnection();
+public:
+
+  /**
+   * Constructor.
+   * @param nodeId - ID of the node on the other side of the link.
+   * @param executor - executor to run link coroutines on.
+   * @param objectMapper - object mapper to encode frames.
+   * @param handler - receiver of incoming frames.
+   * @param maxQueuedFrames - max number of frames waiting to be sent. If the limit is reached the link is closed.
+   */
+  RelayLink(const oatpp::String& nodeId,
+            const std::shared_ptr<oatpp::async::Executor>& executor,
+            const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+            const std::shared_ptr<Handler>& handler,
+            v_int64 maxQueuedFrames);
+
+  /**
+   * Set connected socket and send queued frames.
+   * @param socket
+   */
+  void setSocket(const std::shared_ptr<AsyncWebSocket>& socket);
+
+  /**
+   * Get ID of the node on the other side of the link.
+   * @return
+   */
+  oatpp::String getNodeId();
+
+  /**
+   * Queue frame. If outbox is full the link is broken - its connection is invalidated and the link is closed
+   * once the socket stops listening. Frames are not dropped silently - peers on both sides are disconnected.
+   * @param frame
+   * @return - `false` if frame was dropped.
+   */
+  bool send(const oatpp::Object<RelayFrameDto>& frame);
+
+  /**
+   * Deliver pre-encoded message to peers of the edge node. Single frame for all peers.
+   * @param refs
+   * @param data
+   * @return - `false` if frame was dropped.
+   */
+  bool deliver(const oatpp::Vector<oatpp::Int64>& refs, const oatpp::String& data);
+
+  /**
+   * Deliver pre-encoded message to peer of the edge node.
+   * @param ref
+   * @param data
+   * @return - `false` if frame was dropped.
+   */
+  bool deliver(v_int64 ref, const oatpp::String& data);
+
+  /**
+   * Close connection of peer of the edge node.
+   * @param ref
+   */
+  void closePeer(v_int64 ref);
+
+  /**
+   * Close link. Handler is notified once.
+   */
+  void close();
+
+  /**
+   * Check if link is closed or broken and about to be closed.
+   * @return
+   */
+  bool isClosed();
+
+public: // WebSocket Listener methods
+
+  CoroutineStarter onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
+  CoroutineStarter onPong(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
+  CoroutineStarter onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) override;
+  CoroutineStarter readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) override;
+
+};
+
+#endif //Helicopter_cluster_RelayLink_hpp
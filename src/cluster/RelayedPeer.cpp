@@ -0,0 +1,124 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "RelayedPeer.hpp"
+
+RelayedPeer::RelayedPeer(const std::shared_ptr<AsyncWebSocket>& socket,
+                         const std::shared_ptr<RelayLink>& link,
+                         const std::shared_ptr<oatpp::async::Executor>& executor,
+                         v_int64 ref,
+                         v_int64 maxMessageSize)
+  : m_socket(socket)
+  , m_link(link)
+  , m_executor(executor)
+  , m_ref(ref)
+  , m_maxMessageSize(maxMessageSize)
+{}
+
+void RelayedPeer::deliver(const oatpp::String& data) {
+
+  class DeliverCoroutine : public oatpp::async::Coroutine<DeliverCoroutine> {
+  private:
+    oatpp::async::Lock* m_lock;
+    std::shared_ptr<AsyncWebSocket> m_websocket;
+    oatpp::String m_message;
+  public:
+
+    DeliverCoroutine(oatpp::async::Lock* lock,
+                     const std::shared_ptr<AsyncWebSocket>& websocket,
+                     const oatpp::String& message)
+      : m_lock(lock)
+      , m_websocket(websocket)
+      , m_message(message)
+    {}
+
+    Action act() override {
+      return oatpp::async::synchronize(m_lock, m_websocket->sendOneFrameTextAsync(m_message)).next(finish());
+    }
+
+  };
+
+  std::lock_guard<std::mutex> socketLock(m_socketMutex);
+  if (m_socket) {
+    m_executor->execute<DeliverCoroutine>(&m_writeLock, m_socket, data);
+  }
+
+}
+
+void RelayedPeer::close() {
+  std::lock_guard<std::mutex> socketLock(m_socketMutex);
+  if (m_socket) {
+    m_socket->getConnection().invalidate();
+    m_socket.reset();
+  }
+}
+
+std::shared_ptr<RelayLink> RelayedPeer::getLink() {
+  return m_link;
+}
+
+v_int64 RelayedPeer::getRef() {
+  return m_ref;
+}
+
+oatpp::async::CoroutineStarter RelayedPeer::onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) {
+  return oatpp::async::synchronize(&m_writeLock, socket->sendPongAsync(message));
+}
+
+oatpp::async::CoroutineStarter RelayedPeer::onPong(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) {
+  return nullptr; // do nothing
+}
+
+oatpp::async::CoroutineStarter RelayedPeer::onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) {
+  return nullptr; // do nothing
+}
+
+oatpp::async::CoroutineStarter RelayedPeer::readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) {
+
+  if(m_messageBuffer.getCurrentPosition() + size > m_maxMessageSize) {
+    /* owner node would reject it anyway */
+    m_messageBuffer.setCurrentPosition(0);
+    close();
+    return nullptr;
+  }
+
+  if(size == 0) { // message transfer finished
+
+    auto frame = RelayFrameDto::createShared();
+    frame->type = RelayFrameType::MESSAGE;
+    frame->refs = oatpp::Vector<oatpp::Int64>({m_ref});
+    frame->data = m_messageBuffer.toString();
+    m_messageBuffer.setCurrentPosition(0);
+
+    m_link->send(frame);
+
+  } else if(size > 0) { // message frame received
+    m_messageBuffer.writeSimple(data, size);
+  }
+
+  return nullptr;
+
+}
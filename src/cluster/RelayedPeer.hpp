@@ -0,0 +1,88 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_cluster_RelayedPeer_hpp
+#define Helicopter_cluster_RelayedPeer_hpp
+
+#include "./RelayLink.hpp"
+
+/**
+ * Edge side of the relayed peer.
+ * Peer is connected to this node but its session is owned by other node.
+ * Messages of the peer are forwarded to the owner node as is, messages from the owner node are written to the peer's socket.
+ */
+class RelayedPeer : public oatpp::websocket::AsyncWebSocket::Listener {
+private:
+  oatpp::data::stream::BufferOutputStream m_messageBuffer;
+  oatpp::async::Lock m_writeLock;
+private:
+  std::shared_ptr<AsyncWebSocket> m_socket;
+  std::mutex m_socketMutex;
+  std::shared_ptr<RelayLink> m_link;
+  std::shared_ptr<oatpp::async::Executor> m_executor;
+  v_int64 m_ref;
+  v_int64 m_maxMessageSize;
+public:
+
+  /**
+   * Constructor.
+   * @param socket - peer's socket.
+   * @param link - link to the node owning the session.
+   * @param executor - executor to write to the peer's socket on.
+   * @param ref - ID of the peer connection on this node.
+   * @param maxMessageSize - max size of the message from peer.
+   */
+  RelayedPeer(const std::shared_ptr<AsyncWebSocket>& socket,
+              const std::shared_ptr<RelayLink>& link,
+              const std::shared_ptr<oatpp::async::Executor>& executor,
+              v_int64 ref,
+              v_int64 maxMessageSize);
+
+  /**
+   * Write pre-encoded message to peer's socket.
+   * @param data
+   */
+  void deliver(const oatpp::String& data);
+
+  /**
+   * Close peer's connection.
+   */
+  void close();
+
+  std::shared_ptr<RelayLink> getLink();
+
+  v_int64 getRef();
+
+public: // WebSocket Listener methods
+
+  CoroutineStarter onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
+  CoroutineStarter onPong(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
+  CoroutineStarter onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) override;
+  CoroutineStarter readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) override;
+
+};
+
+#endif //Helicopter_cluster_RelayedPeer_hpp
@@ -34,6 +34,110 @@
 
 #include OATPP_CODEGEN_BEGIN(DTO)
 
+/**
+ * How game sessions are spread across session executors.
+ */
+ENUM(SessionPlacement, v_int32,
+
+     /**
+      * Executor is chosen by hash of the session ID.
+      */
+     VALUE(HASH, 0, "hash"),
+
+     /**
+      * Executor with the least number of sessions is chosen.
+      */
+     VALUE(LOAD, 1, "load")
+
+);
+
+/**
+ * I/O backend of executor I/O workers.
+ */
+ENUM(IoBackend, v_int32,
+
+     /**
+      * Best backend available on the platform.
+      */
+     VALUE(AUTO, 0, "auto"),
+
+     /**
+      * Portable naive I/O worker - polls I/O coroutines in a loop.
+      */
+     VALUE(NAIVE, 1, "naive"),
+
+     /**
+      * Event I/O worker with epoll. Linux only.
+      */
+     VALUE(EPOLL, 2, "epoll"),
+
+     /**
+      * Event I/O worker with kqueue. macOS/BSD only.
+      */
+     VALUE(KQUEUE, 3, "kqueue"),
+
+     /**
+      * io_uring. Not supported by oatpp executor yet - falls back to the event I/O worker.
+      */
+     VALUE(IO_URING, 4, "io_uring")
+
+);
+
+/**
+ * Executor threads topology.
+ * CPU lists are in the Linux cpulist format - ex.: `"0-3,8,10-11"`.
+ * CPU pinning is supported on Linux only.
+ */
+class ExecutorConfigDto : public oatpp::DTO {
+
+  DTO_INIT(ExecutorConfigDto, DTO)
+
+  /**
+   * Number of processor workers - threads running coroutines.
+   */
+  DTO_FIELD(UInt32, processorWorkers) = 1;
+
+  /**
+   * Number of I/O workers.
+   */
+  DTO_FIELD(UInt32, ioWorkers) = 1;
+
+  /**
+   * Number of timer workers.
+   */
+  DTO_FIELD(UInt32, timerWorkers) = 1;
+
+  /**
+   * I/O backend.
+   */
+  DTO_FIELD(Enum<IoBackend>::AsString, ioBackend) = IoBackend::AUTO;
+
+  /**
+   * CPUs to pin processor workers to. Each processor worker is pinned to one CPU of the list (round-robin).
+   * null - no pinning.
+   */
+  DTO_FIELD(String, processorCpus);
+
+  /**
+   * NUMA node to place processor workers on. If `processorCpus` is also set - only CPUs of the node are used.
+   * null - any node.
+   */
+  DTO_FIELD(Int32, processorNumaNode);
+
+  /**
+   * CPUs to pin I/O and timer workers to. Workers may run on any CPU of the list.
+   * null - no pinning.
+   */
+  DTO_FIELD(String, ioCpus);
+
+  /**
+   * NUMA node to place I/O and timer workers on. If `ioCpus` is also set - only CPUs of the node are used.
+   * null - any node.
+   */
+  DTO_FIELD(Int32, ioNumaNode);
+
+};
+
 /**
  * TLS config.
  */
@@ -77,6 +181,154 @@ class ServerConfigDto : public oatpp::DTO {
 
 };
 
+/**
+ * Cluster mode config.
+ */
+class ClusterConfigDto : public oatpp::DTO {
+
+  DTO_INIT(ClusterConfigDto, DTO)
+
+  /**
+   * ID of this node. Must be listed in the members file.
+   */
+  DTO_FIELD(String, nodeId);
+
+  /**
+   * Path to members file - JSON array of cluster nodes.
+   * Static stand-in for discovery - all nodes of the cluster must have the same members file.
+   */
+  DTO_FIELD(String, membersFile);
+
+  /**
+   * Number of points on the consistent hash ring per node.
+   */
+  DTO_FIELD(UInt32, virtualNodes) = 128;
+
+  /**
+   * Relay mode. Accept peers of sessions owned by other nodes and relay their traffic to the owner node
+   * over the inter-node link, instead of redirecting the peer.
+   */
+  DTO_FIELD(Boolean, relay) = false;
+
+  /**
+   * Shared secret of the cluster. Required in relay mode.
+   * Nodes send it in `X-Cluster-Secret` header when opening a relay link - links without a valid secret are rejected.
+   */
+  DTO_FIELD(String, relaySecret);
+
+  /**
+   * Max number of frames queued for sending on one inter-node link.
+   * If queue is full the link is considered broken and is closed - peers relayed over it are disconnected
+   * and reconnect over a new link. Counted in `helicopter_relay_overflows_total`.
+   */
+  DTO_FIELD(UInt32, relayMaxQueuedFrames) = 65536;
+
+};
+
+class TracingConfigDto : public oatpp::DTO {
+
+  DTO_INIT(TracingConfigDto, DTO)
+
+  /**
+   * Trace file. Spans are appended in Chrome trace JSON format (open with `chrome://tracing` or Perfetto).
+   */
+  DTO_FIELD(String, file);
+
+  /**
+   * Trace all inbound messages which have `ocid`.
+   */
+  DTO_FIELD(Boolean, traceOcid) = true;
+
+  /**
+   * Fraction of all inbound messages to trace. `0.0` - none, `1.0` - all.
+   */
+  DTO_FIELD(Float64, sampleRate) = 0.0;
+
+  /**
+   * The maximum number of spans waiting to be written. Spans over the limit are dropped.
+   */
+  DTO_FIELD(UInt32, maxQueuedSpans) = 65536;
+
+};
+
+class RecordingConfigDto : public oatpp::DTO {
+
+  DTO_INIT(RecordingConfigDto, DTO)
+
+  /**
+   * Directory of recordings. Each recorded session is written to `<gameId>-<sessionId>-<startMicros>.hrec`
+   * with the `.hidx` index next to it.
+   */
+  DTO_FIELD(String, directory);
+
+  /**
+   * The maximum bytes of records buffered per session between flushes. Records over the limit are dropped.
+   */
+  DTO_FIELD(UInt32, maxBufferedBytes) = 1024 * 1024; // 1Mb
+
+  /**
+   * How often buffered records are flushed to files.
+   */
+  DTO_FIELD(UInt32, flushMillis) = 50;
+
+  /**
+   * Recording files are grown and remapped by this number of bytes.
+   */
+  DTO_FIELD(UInt64, fileGrowBytes) = 16 * 1024 * 1024; // 16Mb
+
+  /**
+   * One index entry per this number of bytes of records.
+   */
+  DTO_FIELD(UInt32, indexIntervalBytes) = 64 * 1024; // 64Kb
+
+};
+
+class DrainConfigDto : public oatpp::DTO {
+
+  DTO_INIT(DrainConfigDto, DTO)
+
+  /**
+   * How long to wait for the existing sessions to finish if sessions are not handed off.
+   */
+  DTO_FIELD(UInt32, timeoutSeconds) = 600;
+
+  /**
+   * Unix socket of the successor process. If set - sessions are handed off to the successor on drain,
+   * peers are told to reconnect.
+   */
+  DTO_FIELD(String, handoffSocket);
+
+  /**
+   * Host API URL of the successor sent to hosts in the reconnect message.
+   * null - hosts reconnect to the same address.
+   */
+  DTO_FIELD(String, successorHostAPIUrl);
+
+  /**
+   * Client API URL of the successor sent to clients in the reconnect message.
+   * null - clients reconnect to the same address.
+   */
+  DTO_FIELD(String, successorClientAPIUrl);
+
+  /**
+   * I/O timeout of the handoff socket on both sides. Predecessor waits this long for each write
+   * and for the successor's acknowledgement (which comes after all sessions are restored).
+   * On timeout handoff fails and the predecessor keeps serving its sessions.
+   */
+  DTO_FIELD(UInt32, handoffTimeoutMillis) = 10000;
+
+  /**
+   * Successor side. Unix socket to accept sessions handed off by the predecessor.
+   */
+  DTO_FIELD(String, acceptHandoffSocket);
+
+  /**
+   * Successor side. How long peers of the handed off session may take to reconnect.
+   */
+  DTO_FIELD(UInt32, resumeTimeoutSeconds) = 30;
+
+};
+
 class ConfigDto : public oatpp::DTO {
 public:
 
@@ -97,6 +349,127 @@ public:
    */
   DTO_FIELD(String, gamesConfigFile);
 
+  /**
+   * How often to check if games config file is modified. Modified file is reloaded -
+   * games pick up new configs on the next session creation or pinger tick.
+   * `0` - reload on admin request only.
+   */
+  DTO_FIELD(UInt32, gamesConfigWatchMillis) = 2000;
+
+  /**
+   * Threads topology of the application executor.
+   * null - oatpp defaults, no pinning.
+   */
+  DTO_FIELD(Object<ExecutorConfigDto>, executor);
+
+  /**
+   * Threads topology of the control executor.
+   * Control executor runs pingers, pings and kicks - timing-sensitive work is not queued behind relay traffic.
+   * null - one processor, I/O and timer worker, no pinning.
+   */
+  DTO_FIELD(Object<ExecutorConfigDto>, controlExecutor);
+
+  /**
+   * Cluster mode config.
+   * null - cluster mode is disabled, all sessions are hosted by this node.
+   */
+  DTO_FIELD(Object<ClusterConfigDto>, cluster);
+
+  /**
+   * Graceful drain and session handoff config.
+   */
+  DTO_FIELD(Object<DrainConfigDto>, drain) = DrainConfigDto::createShared();
+
+  /**
+   * Token for admin API - `POST api/admin/drain` and `POST api/admin/reload-games-config` with `X-Admin-Token` header.
+   * null - admin API is disabled, drain is triggered by SIGTERM/SIGINT only, games config is reloaded by file watch only.
+   */
+  DTO_FIELD(String, adminToken);
+
+  /**
+   * The maximum number of peers connected to server (all games).
+   * `0` - no limit.
+   */
+  DTO_FIELD(UInt32, maxPeers) = 10000;
+
+  /**
+   * The maximum rate of new connections from one IP address.
+   * `0` - no limit.
+   */
+  DTO_FIELD(UInt32, maxConnectsPerSecondPerIp) = 10;
+
+  /**
+   * The maximum number of new connections from one IP address accepted in a burst.
+   */
+  DTO_FIELD(UInt32, maxConnectsBurstPerIp) = 20;
+
+  /**
+   * Number of single-threaded executors game sessions are pinned to.
+   * All coroutines of a session run serially on its executor's thread.
+   * `0` - sessions share the application executor.
+   * Must be `0` if `shards` > 0 - sessions are pinned to the executor of their shard.
+   */
+  DTO_FIELD(UInt32, sessionExecutors) = 0;
+
+  /**
+   * How game sessions are spread across session executors.
+   */
+  DTO_FIELD(Enum<SessionPlacement>::AsString, sessionPlacement) = SessionPlacement::HASH;
+
+  /**
+   * Number of runtime shards.
+   * Each shard has its own executor, `SO_REUSEPORT` listeners and set of game sessions.
+   * `0` - no sharding, single executor serves all connections.
+   */
+  DTO_FIELD(UInt32, shards) = 0;
+
+  /**
+   * Threads topology of each shard executor.
+   * null - one processor, I/O and timer worker per shard, no pinning.
+   */
+  DTO_FIELD(Object<ExecutorConfigDto>, shardExecutor);
+
+  /**
+   * Sampled per-message tracing config.
+   * null - tracing is disabled.
+   */
+  DTO_FIELD(Object<TracingConfigDto>, tracing);
+
+  /**
+   * Session recording config. Sessions of games with `record` enabled are recorded.
+   * null - recording is disabled.
+   */
+  DTO_FIELD(Object<RecordingConfigDto>, recording);
+
+  /**
+   * Expose `/metrics` endpoint on Host API Server.
+   */
+  DTO_FIELD(Boolean, metrics) = true;
+
+  /**
+   * How often executor probes measure scheduling delay of each processor worker.
+   * `0` - probes are disabled.
+   */
+  DTO_FIELD(UInt32, executorProbeMillis) = 100;
+
+  /**
+   * New game sessions are rejected with `SERVER_BUSY` while queue delay of any processor worker
+   * (moving average) is above this value.
+   * `0` - no limit.
+   */
+  DTO_FIELD(UInt32, maxQueueDelayMillis) = 0;
+
+  /**
+   * Number of records in the async logger's ring buffer. Records are dropped when the buffer is full.
+   */
+  DTO_FIELD(UInt32, logBufferSize) = 8192;
+
+  /**
+   * Max log records per second per log site. Skipped records are counted and reported with the next record.
+   * `0` - no limit.
+   */
+  DTO_FIELD(UInt32, logRateLimit) = 50;
+
 };
 
 #include OATPP_CODEGEN_END(DTO)
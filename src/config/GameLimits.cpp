@@ -0,0 +1,56 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "GameLimits.hpp"
+
+#include <algorithm>
+
+constexpr v_uint32 GameLimits::MAX_AOI_RADIUS;
+
+GameLimits GameLimits::compile(const oatpp::Object<GameConfigDto>& config) {
+
+  GameConfigDto defaults;
+  const GameConfigDto& c = *config;
+
+  GameLimits limits;
+  limits.maxPeers = c.maxPeers ? *c.maxPeers : *defaults.maxPeers;
+  limits.maxMessageSizeBytes = c.maxMessageSizeBytes ? *c.maxMessageSizeBytes : *defaults.maxMessageSizeBytes;
+  limits.maxMessagesPerSecond = c.maxMessagesPerSecond ? *c.maxMessagesPerSecond : *defaults.maxMessagesPerSecond;
+  limits.maxBytesPerSecond = c.maxBytesPerSecond ? *c.maxBytesPerSecond : *defaults.maxBytesPerSecond;
+  limits.rateLimitBurstMillis = c.rateLimitBurstMillis ? *c.rateLimitBurstMillis : *defaults.rateLimitBurstMillis;
+  limits.rateLimitPolicy = c.rateLimitPolicy ? *c.rateLimitPolicy : *defaults.rateLimitPolicy;
+  limits.maxQueuedMessages = c.maxQueuedMessages ? *c.maxQueuedMessages : *defaults.maxQueuedMessages;
+  limits.maxPendingMessages = std::max<v_uint32>(1, c.maxPendingMessages ? *c.maxPendingMessages : *defaults.maxPendingMessages);
+  limits.pingIntervalMillis = c.pingIntervalMillis ? *c.pingIntervalMillis : *defaults.pingIntervalMillis;
+  limits.maxFailedPings = c.maxFailedPings ? *c.maxFailedPings : *defaults.maxFailedPings;
+  limits.staticHost = c.staticHost ? *c.staticHost : *defaults.staticHost;
+  limits.hostMigrationWindowMillis = c.hostMigrationWindowMillis ? *c.hostMigrationWindowMillis : *defaults.hostMigrationWindowMillis;
+  limits.hostMigrationPingGainMicros = c.hostMigrationPingGainMicros ? *c.hostMigrationPingGainMicros : *defaults.hostMigrationPingGainMicros;
+  limits.aoiRadius = std::min<v_uint32>(MAX_AOI_RADIUS, c.aoiRadius ? *c.aoiRadius : *defaults.aoiRadius);
+
+  return limits;
+
+}
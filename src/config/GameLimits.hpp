@@ -0,0 +1,68 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_config_GameLimits_hpp
+#define Helicopter_config_GameLimits_hpp
+
+#include "./GamesConfig.hpp"
+
+/**
+ * Game config flattened for the hot path.
+ * Compiled from `GameConfigDto` once per session - per-message checks read plain fields,
+ * no refcounted `oatpp::Object` copies and no nullable wrappers.
+ */
+struct GameLimits {
+
+  /**
+   * Upper bound of `aoiRadius`. Bounds the number of grid cells visited by an area of interest query.
+   */
+  static constexpr v_uint32 MAX_AOI_RADIUS = 64;
+
+  v_uint32 maxPeers;
+  v_uint64 maxMessageSizeBytes;
+  v_uint32 maxMessagesPerSecond;
+  v_uint64 maxBytesPerSecond;
+  v_uint64 rateLimitBurstMillis;
+  RateLimitPolicy rateLimitPolicy;
+  v_uint32 maxQueuedMessages;
+  v_uint32 maxPendingMessages;
+  v_uint64 pingIntervalMillis;
+  v_uint64 maxFailedPings;
+  bool staticHost;
+  v_uint64 hostMigrationWindowMillis;
+  v_uint64 hostMigrationPingGainMicros;
+  v_uint32 aoiRadius;
+
+  /**
+   * Compile game config. Null fields get defaults of `GameConfigDto`. `aoiRadius` is clamped to `MAX_AOI_RADIUS`.
+   * @param config
+   * @return
+   */
+  static GameLimits compile(const oatpp::Object<GameConfigDto>& config);
+
+};
+
+#endif //Helicopter_config_GameLimits_hpp
@@ -26,40 +26,129 @@
 
 #include "GamesConfig.hpp"
 
+#include "utils/AsyncLogger.hpp"
+
+#include <sys/stat.h>
+
 GamesConfig::GamesConfig(const oatpp::String& configFilename)
   : m_configFile(configFilename)
+  , m_watching(false)
 {
+
+  std::unordered_map<oatpp::String, oatpp::Object<GameConfigDto>> games;
+
   if(configFilename) {
     auto json = oatpp::String::loadFromFile(configFilename->c_str());
-    m_games = m_mapper.readFromString<oatpp::UnorderedFields<oatpp::Object<GameConfigDto>>>(json);
+    auto configs = m_mapper.readFromString<oatpp::UnorderedFields<oatpp::Object<GameConfigDto>>>(json);
+    if(configs) {
+      games.insert(configs->begin(), configs->end());
+    }
   }
+
+  std::lock_guard<std::mutex> lock(m_writeMutex);
+  publish(std::move(games));
+
 }
 
-void GamesConfig::putGameConfig(const oatpp::Object<GameConfigDto>& config) {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  if(m_games == nullptr) {
-    m_games = oatpp::UnorderedFields<oatpp::Object<GameConfigDto>>({});
+GamesConfig::~GamesConfig() {
+  m_watching = false;
+  if(m_watchThread.joinable()) {
+    m_watchThread.join();
   }
-  m_games->insert({config->gameId, config});
+}
+
+void GamesConfig::publish(std::unordered_map<oatpp::String, oatpp::Object<GameConfigDto>>&& games) {
+  auto current = std::atomic_load(&m_snapshot);
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->version = current ? current->version + 1 : 0;
+  snapshot->games = std::move(games);
+  std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(snapshot));
+}
+
+void GamesConfig::putGameConfig(const oatpp::Object<GameConfigDto>& config) {
+  std::lock_guard<std::mutex> lock(m_writeMutex);
+  auto games = std::atomic_load(&m_snapshot)->games;
+  games[config->gameId] = config;
+  publish(std::move(games));
 }
 
 oatpp::Object<GameConfigDto> GamesConfig::getGameConfig(const oatpp::String& gameId) {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  if(m_games) {
-    auto it = m_games->find(gameId);
-    if(it != m_games->end()) {
-      return it->second;
-    }
+  auto snapshot = std::atomic_load(&m_snapshot);
+  auto it = snapshot->games.find(gameId);
+  if(it != snapshot->games.end()) {
+    return it->second;
   }
   return nullptr;
 }
 
-bool GamesConfig::save() {
-  oatpp::String json;
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    json = m_mapper.writeToString(m_games);
+v_int64 GamesConfig::getVersion() {
+  return std::atomic_load(&m_snapshot)->version;
+}
+
+bool GamesConfig::reload() {
+
+  if(!m_configFile) {
+    return false;
+  }
+
+  oatpp::UnorderedFields<oatpp::Object<GameConfigDto>> configs;
+  try {
+    auto json = oatpp::String::loadFromFile(m_configFile->c_str());
+    configs = m_mapper.readFromString<oatpp::UnorderedFields<oatpp::Object<GameConfigDto>>>(json);
+  } catch (std::exception& e) {
+    HELI_LOGE("GamesConfig", "Can't reload games config '%s': %s", m_configFile->c_str(), e.what());
+    return false;
+  }
+
+  if(!configs) {
+    HELI_LOGE("GamesConfig", "Can't reload games config '%s': empty config", m_configFile->c_str());
+    return false;
   }
+
+  std::unordered_map<oatpp::String, oatpp::Object<GameConfigDto>> games(configs->begin(), configs->end());
+
+  std::lock_guard<std::mutex> lock(m_writeMutex);
+  publish(std::move(games));
+
+  HELI_LOGI("GamesConfig", "Games config reloaded. Version - %lld", (long long) std::atomic_load(&m_snapshot)->version);
+
+  return true;
+
+}
+
+void GamesConfig::watch(v_int64 intervalMillis) {
+
+  struct stat info;
+  v_int64 modified = ::stat(m_configFile->c_str(), &info) == 0 ? (v_int64) info.st_mtime : 0;
+
+  while(m_watching) {
+
+    /* sleep in short steps to stop promptly */
+    for(v_int64 slept = 0; slept < intervalMillis && m_watching; slept += 100) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    if(::stat(m_configFile->c_str(), &info) == 0 && (v_int64) info.st_mtime != modified) {
+      modified = (v_int64) info.st_mtime;
+      reload();
+    }
+
+  }
+
+}
+
+void GamesConfig::startWatching(v_int64 intervalMillis) {
+  if(!m_configFile || m_watching.exchange(true)) {
+    return;
+  }
+  m_watchThread = std::thread(&GamesConfig::watch, this, intervalMillis);
+}
+
+bool GamesConfig::save() {
+  auto snapshot = std::atomic_load(&m_snapshot);
+  auto configs = oatpp::UnorderedFields<oatpp::Object<GameConfigDto>>::createShared();
+  configs->insert(snapshot->games.begin(), snapshot->games.end());
+  oatpp::String json = m_mapper.writeToString(configs);
   if(m_configFile) {
     json.saveToFile(m_configFile->c_str());
     return true;
@@ -31,10 +31,37 @@
 #include "oatpp/parser/json/mapping/ObjectMapper.hpp"
 #include "oatpp/core/macro/codegen.hpp"
 
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
 #include <mutex>
 
 #include OATPP_CODEGEN_BEGIN(DTO)
 
+/**
+ * What to do with peer's messages exceeding the rate limit.
+ */
+ENUM(RateLimitPolicy, v_int32,
+
+     /**
+      * Discard messages over the limit.
+      */
+     VALUE(DROP, 0, "drop"),
+
+     /**
+      * Defer reading of the next messages until peer is within the limit.
+      */
+     VALUE(THROTTLE, 1, "throttle"),
+
+     /**
+      * Disconnect the peer.
+      */
+     VALUE(KICK, 2, "kick")
+
+);
+
 /**
  * Game config
  */
@@ -50,9 +77,23 @@ class GameConfigDto : public oatpp::DTO {
   /**
    * Host peer can't change.
    * If host peer disconnects the game is over and all other peers are dropped.
+   * If `false` - server promotes the best-connected peer when host disconnects or when
+   * other peer has significantly lower ping for `hostMigrationWindowMillis`.
    */
   DTO_FIELD(Boolean, staticHost) = true;
 
+  /**
+   * Dynamic host only.
+   * How long a peer should have the best ping in the session before it is promoted to host.
+   */
+  DTO_FIELD(UInt64, hostMigrationWindowMillis) = 30 * 1000; // 30 seconds
+
+  /**
+   * Dynamic host only.
+   * How much lower the peer's ping should be comparing to host's ping to become a host candidate.
+   */
+  DTO_FIELD(UInt64, hostMigrationPingGainMicros) = 20 * 1000; // 20 milliseconds
+
   /**
    * The maximum number of peers connected to game (including host peer).
    */
@@ -63,12 +104,42 @@ class GameConfigDto : public oatpp::DTO {
    */
   DTO_FIELD(UInt64, maxMessageSizeBytes) = 4 * 1024; // Default - 4Kb
 
+  /**
+   * Max number of messages per second received from one peer.
+   * `0` - no limit. Default - no limit.
+   */
+  DTO_FIELD(UInt32, maxMessagesPerSecond) = 0;
+
+  /**
+   * Max number of bytes per second received from one peer.
+   * `0` - no limit. Default - no limit.
+   */
+  DTO_FIELD(UInt64, maxBytesPerSecond) = 0;
+
+  /**
+   * For how long the peer may send at the max rate without being limited.
+   * Rate limits are token buckets of `rate * rateLimitBurstMillis / 1000` capacity.
+   */
+  DTO_FIELD(UInt64, rateLimitBurstMillis) = 2 * 1000; // 2 seconds
+
+  /**
+   * What to do with peer's messages exceeding `maxMessagesPerSecond` or `maxBytesPerSecond`.
+   */
+  DTO_FIELD(Enum<RateLimitPolicy>::AsString, rateLimitPolicy) = RateLimitPolicy::THROTTLE;
+
   /**
    * Max number of messages queued for the peer.
    * If exceeded messages are dropped.
    */
   DTO_FIELD(UInt32, maxQueuedMessages) = 100;
 
+  /**
+   * Max number of inbound messages of one peer waiting to be handled on the session's executor
+   * (`sessionExecutors` or `shards` mode). When reached, reading from the peer is paused until the session catches up.
+   * Messages of relayed peers over the limit are dropped.
+   */
+  DTO_FIELD(UInt32, maxPendingMessages) = 32;
+
   /**
    * How often should server ping client.
    */
@@ -80,22 +151,61 @@ class GameConfigDto : public oatpp::DTO {
    */
   DTO_FIELD(UInt64, maxFailedPings) = 100;
 
+  /**
+   * Radius of the peer's area of interest in cells of the spatial grid.
+   * Spatial broadcast is delivered to peers whose area of interest overlaps the sender's area of interest.
+   * Values above 64 are clamped to 64.
+   */
+  DTO_FIELD(UInt32, aoiRadius) = 1;
+
+  /**
+   * Record inbound messages and synchronized events of the game's sessions.
+   * Requires `recording` in the server config.
+   */
+  DTO_FIELD(Boolean, record) = false;
+
 };
 
+/**
+ * Games configs.
+ * Configs are published as immutable snapshots - readers do a single atomic load, writers copy the snapshot
+ * and publish a new one. Published `GameConfigDto` objects must not be modified.
+ */
 class GamesConfig {
+private:
+
+  struct Snapshot {
+    v_int64 version;
+    std::unordered_map<oatpp::String, oatpp::Object<GameConfigDto>> games;
+  };
+
 private:
   oatpp::String m_configFile;
   oatpp::parser::json::mapping::ObjectMapper m_mapper;
-  oatpp::UnorderedFields<oatpp::Object<GameConfigDto>> m_games;
-  std::mutex m_mutex;
+  /* read with std::atomic_load, written with std::atomic_store. Readers keep the snapshot they loaded alive */
+  std::shared_ptr<const Snapshot> m_snapshot;
+  std::mutex m_writeMutex;
+private:
+  std::atomic<bool> m_watching;
+  std::thread m_watchThread;
+private:
+  /* call under m_writeMutex */
+  void publish(std::unordered_map<oatpp::String, oatpp::Object<GameConfigDto>>&& games);
+  void watch(v_int64 intervalMillis);
 public:
 
   /**
    * Path to config file containing configs for games.
+   * Throws `std::runtime_error` if config file can't be parsed.
    * @param configFilename
    */
   GamesConfig(const oatpp::String& configFilename);
 
+  /**
+   * Stop watching config file.
+   */
+  ~GamesConfig();
+
   /**
    * Put game config
    * @param gameId
@@ -104,12 +214,30 @@ public:
   void putGameConfig(const oatpp::Object<GameConfigDto>& config);
 
   /**
-   * Get game config
+   * Get game config. Lock-free.
    * @param gameId
    * @return
    */
   oatpp::Object<GameConfigDto> getGameConfig(const oatpp::String& gameId);
 
+  /**
+   * Get version of the current snapshot. Incremented on each change.
+   * @return
+   */
+  v_int64 getVersion();
+
+  /**
+   * Reload configs from config file. If file can't be parsed - current configs are kept.
+   * @return - `true` if configs were reloaded.
+   */
+  bool reload();
+
+  /**
+   * Reload configs when config file is modified.
+   * @param intervalMillis - how often to check modification time of the file.
+   */
+  void startWatching(v_int64 intervalMillis);
+
   /**
    * Save current state of games config to config file.
    */
@@ -0,0 +1,115 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_controller_AdminController_hpp
+#define Helicopter_controller_AdminController_hpp
+
+#include "game/AdmissionControl.hpp"
+#include "config/GamesConfig.hpp"
+#include "utils/AsyncLogger.hpp"
+#include "utils/Secret.hpp"
+
+#include "Constants.hpp"
+
+#include "oatpp/web/server/api/ApiController.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include "oatpp/core/macro/codegen.hpp"
+#include "oatpp/core/macro/component.hpp"
+
+
+#include OATPP_CODEGEN_BEGIN(ApiController) /// <-- Begin Code-Gen
+
+/**
+ * Admin API. Enabled if `adminToken` is configured. Requests must have `X-Admin-Token` header.
+ */
+class AdminController : public oatpp::web::server::api::ApiController {
+private:
+  typedef AdminController __ControllerType;
+private:
+  OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
+  OATPP_COMPONENT(std::shared_ptr<GamesConfig>, gamesConfig);
+public:
+  AdminController(OATPP_COMPONENT(std::shared_ptr<ObjectMapper>, objectMapper, Constants::COMPONENT_REST_API))
+    : oatpp::web::server::api::ApiController(objectMapper)
+  {}
+public:
+
+  /**
+   * Start drain - stop accepting new sessions, hand off or finish existing sessions and shut down.
+   */
+  ENDPOINT_ASYNC("POST", "api/admin/drain", Drain) {
+
+    ENDPOINT_ASYNC_INIT(Drain)
+
+    Action act() override {
+
+      auto token = request->getHeader("X-Admin-Token");
+      if(!Secret::equals(token, controller->config->adminToken)) {
+        return _return(controller->createResponse(Status::CODE_403, "Invalid admin token."));
+      }
+
+      controller->admission->setDraining();
+      HELI_LOGD("AdminController", "Drain requested");
+
+      return _return(controller->createResponse(Status::CODE_202, "Draining."));
+
+    }
+
+  };
+
+  /**
+   * Reload games config file. Games pick up new configs on the next session creation or pinger tick.
+   */
+  ENDPOINT_ASYNC("POST", "api/admin/reload-games-config", ReloadGamesConfig) {
+
+    ENDPOINT_ASYNC_INIT(ReloadGamesConfig)
+
+    Action act() override {
+
+      auto token = request->getHeader("X-Admin-Token");
+      if(!Secret::equals(token, controller->config->adminToken)) {
+        return _return(controller->createResponse(Status::CODE_403, "Invalid admin token."));
+      }
+
+      if(!controller->gamesConfig->reload()) {
+        return _return(controller->createResponse(Status::CODE_500, "Games config can't be reloaded."));
+      }
+
+      return _return(controller->createResponse(Status::CODE_200,
+        "Reloaded. Version - " + oatpp::utils::conversion::int64ToStr(controller->gamesConfig->getVersion())));
+
+    }
+
+  };
+
+};
+
+#include OATPP_CODEGEN_END(ApiController) /// <-- End Code-Gen
+
+#endif /* Helicopter_controller_AdminController_hpp */
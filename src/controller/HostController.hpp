@@ -27,6 +27,9 @@
 #ifndef Helicopter_controller_HostController_hpp
 #define Helicopter_controller_HostController_hpp
 
+#include "cluster/Cluster.hpp"
+#include "game/AdmissionControl.hpp"
+
 #include "Constants.hpp"
 
 #include "oatpp-websocket/Handshaker.hpp"
@@ -44,10 +47,14 @@ class HostController : public oatpp::web::server::api::ApiController {
 private:
   typedef HostController __ControllerType;
 private:
-  OATPP_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, websocketConnectionHandler, Constants::COMPONENT_WS_API);
+  std::shared_ptr<oatpp::network::ConnectionHandler> websocketConnectionHandler;
+  OATPP_COMPONENT(std::shared_ptr<Cluster>, cluster);
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
 public:
-  HostController(OATPP_COMPONENT(std::shared_ptr<ObjectMapper>, objectMapper, Constants::COMPONENT_REST_API))
+  HostController(const std::shared_ptr<oatpp::network::ConnectionHandler>& pWebsocketConnectionHandler,
+               OATPP_COMPONENT(std::shared_ptr<ObjectMapper>, objectMapper, Constants::COMPONENT_REST_API))
     : oatpp::web::server::api::ApiController(objectMapper)
+    , websocketConnectionHandler(pWebsocketConnectionHandler)
   {}
 public:
 
@@ -60,6 +67,25 @@ public:
 
     Action act() override {
 
+      /* cheap checks go first - under connect flood rejected requests never reach the handshake */
+      auto address = request->getConnection()->getInputStreamContext().getProperties().get(Constants::CONNECTION_PROPERTY_PEER_ADDRESS);
+      if(!controller->admission->checkConnectRate(address)) {
+        return _return(controller->createResponse(Status::CODE_429, "Too many connections from this address."));
+      }
+
+      /* Cluster mode - redirect to the node owning the session. In relay mode the peer is accepted and relayed */
+      auto owner = controller->cluster->getRemoteSessionOwner(request->getQueryParameter(Constants::PARAM_GAME_ID),
+                                                              request->getQueryParameter(Constants::PARAM_GAME_SESSION_ID));
+      if(owner && !controller->cluster->isRelayEnabled()) {
+        auto redirect = controller->createResponse(Status::CODE_307, "Session is hosted by node '" + owner->id + "'.");
+        redirect->putHeader("Location", owner->hostAPIUrl + request->getStartingLine().path.toString());
+        return _return(redirect);
+      }
+
+      if(controller->admission->isFull()) {
+        return _return(controller->createResponse(Status::CODE_503, "Server reached the maximum number of peers."));
+      }
+
       /* Websocket handshake */
       auto response = oatpp::websocket::Handshaker::serversideHandshake(request->getHeaders(), controller->websocketConnectionHandler);
       auto parameters = std::make_shared<oatpp::network::ConnectionHandler::ParameterMap>();
@@ -67,6 +93,11 @@ public:
       (*parameters)[Constants::PARAM_GAME_ID] = request->getQueryParameter(Constants::PARAM_GAME_ID);
       (*parameters)[Constants::PARAM_GAME_SESSION_ID] = request->getQueryParameter(Constants::PARAM_GAME_SESSION_ID);
       (*parameters)[Constants::PARAM_PEER_TYPE] = Constants::PARAM_PEER_TYPE_HOST;
+      (*parameters)[Constants::PARAM_PEER_ADDRESS] = address;
+
+      /* peer reconnects after session handoff */
+      (*parameters)[Constants::PARAM_PEER_ID] = request->getQueryParameter(Constants::PARAM_PEER_ID);
+      (*parameters)[Constants::PARAM_RESUME_TOKEN] = request->getQueryParameter(Constants::PARAM_RESUME_TOKEN);
 
       /* Set connection upgrade params */
       response->setConnectionUpgradeParameters(parameters);
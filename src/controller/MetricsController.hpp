@@ -0,0 +1,209 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_controller_MetricsController_hpp
+#define Helicopter_controller_MetricsController_hpp
+
+#include "game/Registry.hpp"
+#include "dto/MetricsDTOs.hpp"
+#include "utils/ExecutorProbe.hpp"
+#include "utils/Metrics.hpp"
+
+#include "Constants.hpp"
+
+#include "oatpp/web/server/api/ApiController.hpp"
+
+#include "oatpp/core/data/stream/BufferStream.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include "oatpp/core/macro/codegen.hpp"
+#include "oatpp/core/macro/component.hpp"
+
+#include <unordered_set>
+
+
+#include OATPP_CODEGEN_BEGIN(ApiController) /// <-- Begin Code-Gen
+
+/**
+ * Metrics in Prometheus text exposition format.
+ * Counters are merged from per-thread blocks, gauges are computed on scrape.
+ * Latency percentiles are served as JSON.
+ */
+class MetricsController : public oatpp::web::server::api::ApiController {
+private:
+  typedef MetricsController __ControllerType;
+private:
+  std::vector<std::shared_ptr<Registry>> registries;
+  std::vector<std::shared_ptr<ExecutorProbe>> probes;
+private:
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
+private:
+
+  static void writeQuantiles(oatpp::data::stream::ConsistentOutputStream& stream,
+                             const char* name,
+                             const oatpp::String& labels,
+                             const LatencyHistogram& histogram)
+  {
+    auto percentiles = histogram.getPercentiles();
+    stream << name << "{" << labels << ",quantile=\"0.5\"} " << percentiles.p50 << "\n";
+    stream << name << "{" << labels << ",quantile=\"0.99\"} " << percentiles.p99 << "\n";
+    stream << name << "{" << labels << ",quantile=\"0.999\"} " << percentiles.p999 << "\n";
+    stream << name << "_count{" << labels << "} " << percentiles.count << "\n";
+  }
+
+  oatpp::String writeMetrics() {
+
+    oatpp::data::stream::BufferOutputStream stream;
+
+    Metrics::writeCounters(&stream);
+
+    std::unordered_set<std::string> games;
+    v_int64 sessionsCount = 0;
+    v_int64 peersCount = 0;
+    for(auto& registry : registries) {
+      for(auto& session : registry->getAllSessions()) {
+        games.insert(*session->getConfig()->gameId);
+        sessionsCount ++;
+        peersCount += session->getAllPeers().size();
+      }
+    }
+
+    stream << "# TYPE helicopter_games gauge\n";
+    stream << "helicopter_games " << (v_int64) games.size() << "\n";
+    stream << "# TYPE helicopter_sessions gauge\n";
+    stream << "helicopter_sessions " << sessionsCount << "\n";
+    stream << "# TYPE helicopter_peers gauge\n";
+    stream << "helicopter_peers " << peersCount << "\n";
+
+    stream << "# HELP helicopter_executor_tasks Coroutines scheduled on executor and not finished yet.\n";
+    stream << "# TYPE helicopter_executor_tasks gauge\n";
+    for(auto& probe : probes) {
+      stream << "helicopter_executor_tasks{executor=\"" << probe->getName() << "\"} " << (v_int64) probe->getExecutor()->getTasksCount() << "\n";
+    }
+
+    stream << "# HELP helicopter_executor_timer_lag_micros How late timer-based coroutines are woken up.\n";
+    stream << "# TYPE helicopter_executor_timer_lag_micros summary\n";
+    for(auto& probe : probes) {
+      for(v_int32 i = 0; i < probe->getWorkersCount(); i ++) {
+        auto labels = "executor=\"" + probe->getName() + "\",worker=\"" + oatpp::utils::conversion::int32ToStr(i) + "\"";
+        writeQuantiles(stream, "helicopter_executor_timer_lag_micros", labels, probe->getWorker(i).timerLag);
+      }
+    }
+
+    stream << "# HELP helicopter_executor_queue_delay_micros How long ready coroutines wait in worker's queue.\n";
+    stream << "# TYPE helicopter_executor_queue_delay_micros summary\n";
+    for(auto& probe : probes) {
+      for(v_int32 i = 0; i < probe->getWorkersCount(); i ++) {
+        auto labels = "executor=\"" + probe->getName() + "\",worker=\"" + oatpp::utils::conversion::int32ToStr(i) + "\"";
+        writeQuantiles(stream, "helicopter_executor_queue_delay_micros", labels, probe->getWorker(i).queueDelay);
+      }
+    }
+
+    stream << "# HELP helicopter_executor_busy_ratio Estimated share of time worker has coroutines queued.\n";
+    stream << "# TYPE helicopter_executor_busy_ratio gauge\n";
+    for(auto& probe : probes) {
+      for(v_int32 i = 0; i < probe->getWorkersCount(); i ++) {
+        stream << "helicopter_executor_busy_ratio{executor=\"" << probe->getName() << "\",worker=\"" << i << "\"} "
+               << probe->getWorker(i).busyRatio.load(std::memory_order_relaxed) << "\n";
+      }
+    }
+
+    stream << "# TYPE helicopter_overloaded gauge\n";
+    stream << "helicopter_overloaded " << (admission->isOverloaded() ? 1 : 0) << "\n";
+
+    return stream.toString();
+
+  }
+
+  static oatpp::Object<PercentilesDto> createPercentiles(Metrics::Latency kind, v_int32 slot) {
+    auto percentiles = Metrics::getLatency(kind, slot);
+    auto dto = PercentilesDto::createShared();
+    dto->count = percentiles.count;
+    dto->p50 = percentiles.p50;
+    dto->p99 = percentiles.p99;
+    dto->p999 = percentiles.p999;
+    dto->max = percentiles.max;
+    return dto;
+  }
+
+  oatpp::Vector<oatpp::Object<MessageLatencyDto>> getLatencies() {
+    auto result = oatpp::Vector<oatpp::Object<MessageLatencyDto>>::createShared();
+    for(v_int32 slot = 0; slot < Metrics::CODE_SLOTS_COUNT; slot ++) {
+      auto latency = MessageLatencyDto::createShared();
+      latency->code = Metrics::getSlotCode(slot);
+      latency->endToEnd = createPercentiles(Metrics::LATENCY_END_TO_END, slot);
+      latency->queueWait = createPercentiles(Metrics::LATENCY_QUEUE_WAIT, slot);
+      latency->write = createPercentiles(Metrics::LATENCY_WRITE, slot);
+      if(latency->queueWait->count > 0) {
+        result->push_back(latency);
+      }
+    }
+    return result;
+  }
+
+public:
+  MetricsController(const std::vector<std::shared_ptr<Registry>>& pRegistries,
+                    const std::vector<std::shared_ptr<ExecutorProbe>>& pProbes,
+                    OATPP_COMPONENT(std::shared_ptr<ObjectMapper>, objectMapper, Constants::COMPONENT_REST_API))
+    : oatpp::web::server::api::ApiController(objectMapper)
+    , registries(pRegistries)
+    , probes(pProbes)
+  {}
+public:
+
+  /**
+   * Prometheus scrape.
+   */
+  ENDPOINT_ASYNC("GET", "metrics", Scrape) {
+
+    ENDPOINT_ASYNC_INIT(Scrape)
+
+    Action act() override {
+      auto response = controller->createResponse(Status::CODE_200, controller->writeMetrics());
+      response->putHeader(Header::CONTENT_TYPE, "text/plain; version=0.0.4");
+      return _return(response);
+    }
+
+  };
+
+  /**
+   * Latency percentiles of outgoing messages per message code.
+   */
+  ENDPOINT_ASYNC("GET", "metrics/latency", Latency) {
+
+    ENDPOINT_ASYNC_INIT(Latency)
+
+    Action act() override {
+      return _return(controller->createDtoResponse(Status::CODE_200, controller->getLatencies()));
+    }
+
+  };
+
+};
+
+#include OATPP_CODEGEN_END(ApiController) /// <-- End Code-Gen
+
+#endif /* Helicopter_controller_MetricsController_hpp */
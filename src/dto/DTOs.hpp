@@ -98,6 +98,23 @@ ENUM(MessageCodes, v_int32,
       */
      VALUE(OUTGOING_SYNCHRONIZED_EVENT, 9),
 
+     /**
+      * Peer declares its cell in the session's spatial grid.
+      * Server is agnostic of the game world - it only operates with cell coordinates.
+      */
+     VALUE(INCOMING_AREA_OF_INTEREST, 10),
+
+     /**
+      * Peer broadcasts message to peers whose area of interest overlaps the sender's area of interest.
+      */
+     VALUE(INCOMING_SPATIAL_BROADCAST, 11),
+
+     /**
+      * Server is shutting down and the session is handed off to other server process.
+      * Peer should reconnect to the given URL. The connection is closed right after this message.
+      */
+     VALUE(OUTGOING_RECONNECT, 12),
+
 ///////////////////////////////////////////////////////////////////
 //// 100 - 199 outgoing host messages
 
@@ -119,6 +136,11 @@ ENUM(MessageCodes, v_int32,
       */
      VALUE(INCOMING_HOST_KICK_CLIENTS, 200),
 
+     /**
+      * Host writes changed keys to the session state store.
+      */
+     VALUE(INCOMING_HOST_STATE_UPDATE, 201),
+
 ///////////////////////////////////////////////////////////////////
 //// 300 - 399 outgoing client messages
 
@@ -127,13 +149,23 @@ ENUM(MessageCodes, v_int32,
      */
      VALUE(OUTGOING_CLIENT_KICKED, 300),
 
+    /**
+     * Server sends keys of the session state changed since the client's last acknowledged version.
+     */
+     VALUE(OUTGOING_CLIENT_STATE_DELTA, 301),
+
 ///////////////////////////////////////////////////////////////////
 //// 400 - 499 incoming client messages
 
      /**
       * Client sends direct message to host.
       */
-     VALUE(INCOMING_CLIENT_MESSAGE, 400)
+     VALUE(INCOMING_CLIENT_MESSAGE, 400),
+
+     /**
+      * Client acknowledges version of the session state it has applied.
+      */
+     VALUE(INCOMING_CLIENT_STATE_ACK, 401)
 
 );
 
@@ -170,7 +202,27 @@ ENUM(ErrorCodes, v_int32,
      /**
       * Session is in an invalid state.
       */
-     VALUE(INVALID_STATE, 5)
+     VALUE(INVALID_STATE, 5),
+
+     /**
+      * Game session reached the maximum number of peers.
+      */
+     VALUE(SESSION_FULL, 6),
+
+     /**
+      * Server reached the maximum number of peers.
+      */
+     VALUE(SERVER_BUSY, 7),
+
+     /**
+      * Too many requests from the peer.
+      */
+     VALUE(RATE_LIMITED, 8),
+
+     /**
+      * Server is draining - it doesn't accept new game sessions.
+      */
+     VALUE(SERVER_DRAINING, 9)
 
 );
 
@@ -240,6 +292,25 @@ class DirectMessageDto : public oatpp::DTO {
 
 };
 
+/**
+ * Cell in the session's spatial grid.
+ */
+class CellDto : public oatpp::DTO {
+
+  DTO_INIT(CellDto, DTO)
+
+  /**
+   * X coordinate of the cell.
+   */
+  DTO_FIELD(Int32, x);
+
+  /**
+   * Y coordinate of the cell.
+   */
+  DTO_FIELD(Int32, y);
+
+};
+
 /**
  * Outgoing message.
  */
@@ -283,6 +354,79 @@ class OutgoingSynchronizedMessageDto : public oatpp::DTO {
 
 };
 
+/**
+ * Update of the session state store.
+ */
+class StateUpdateDto : public oatpp::DTO {
+
+  DTO_INIT(StateUpdateDto, DTO)
+
+  /**
+   * Keys to put and their new values.
+   */
+  DTO_FIELD(UnorderedFields<String>, entries);
+
+  /**
+   * Keys to remove.
+   */
+  DTO_FIELD(Vector<String>, removed);
+
+};
+
+/**
+ * Reconnect message.
+ */
+class ReconnectMessageDto : public oatpp::DTO {
+
+  DTO_INIT(ReconnectMessageDto, DTO)
+
+  /**
+   * URL to reconnect to. Relative to the current server if the successor is on the same address.
+   * Contains `peerId` and `resumeToken` query parameters.
+   */
+  DTO_FIELD(String, url);
+
+  /**
+   * ID of the peer - it is preserved after reconnect.
+   */
+  DTO_FIELD(Int64, peerId);
+
+  /**
+   * One-time token to resume the peer on the new server.
+   */
+  DTO_FIELD(String, resumeToken);
+
+};
+
+/**
+ * Delta of the session state store.
+ */
+class StateDeltaDto : public oatpp::DTO {
+
+  DTO_INIT(StateDeltaDto, DTO)
+
+  /**
+   * Version of the state after the delta is applied.
+   */
+  DTO_FIELD(Int64, version);
+
+  /**
+   * Version the delta is computed against. `0` - delta is a full snapshot.
+   */
+  DTO_FIELD(Int64, baseVersion);
+
+  /**
+   * Keys changed since the base version and their values.
+   */
+  DTO_FIELD(UnorderedFields<String>, entries);
+
+  /**
+   * Keys removed since the base version.
+   */
+  DTO_FIELD(Vector<String>, removed);
+
+};
+
 /**
  * Message
  */
@@ -323,6 +467,9 @@ class MessageDto : public oatpp::DTO {
       case MessageCodes::OUTGOING_ERROR:
         return oatpp::Object<ErrorDto>::Class::getType();
 
+      case MessageCodes::OUTGOING_NEW_HOST:
+        return oatpp::Int64::Class::getType();
+
       case MessageCodes::OUTGOING_MESSAGE:
         return oatpp::Object<OutgoingMessageDto>::Class::getType();
 
@@ -338,6 +485,15 @@ class MessageDto : public oatpp::DTO {
       case MessageCodes::OUTGOING_SYNCHRONIZED_EVENT:
         return oatpp::Object<OutgoingSynchronizedMessageDto>::Class::getType();
 
+      case MessageCodes::INCOMING_AREA_OF_INTEREST:
+        return oatpp::Object<CellDto>::Class::getType();
+
+      case MessageCodes::INCOMING_SPATIAL_BROADCAST:
+        return oatpp::String::Class::getType();
+
+      case MessageCodes::OUTGOING_RECONNECT:
+        return oatpp::Object<ReconnectMessageDto>::Class::getType();
+
       case MessageCodes::OUTGOING_HOST_CLIENT_JOINED:
       case MessageCodes::OUTGOING_HOST_CLIENT_LEFT:
         return oatpp::Int64::Class::getType();
@@ -345,12 +501,21 @@ class MessageDto : public oatpp::DTO {
       case MessageCodes::INCOMING_HOST_KICK_CLIENTS:
         return oatpp::Vector<oatpp::Int64>::Class::getType();
 
+      case MessageCodes::INCOMING_HOST_STATE_UPDATE:
+        return oatpp::Object<StateUpdateDto>::Class::getType();
+
       case MessageCodes::OUTGOING_CLIENT_KICKED:
         return oatpp::String::Class::getType();
 
+      case MessageCodes::OUTGOING_CLIENT_STATE_DELTA:
+        return oatpp::Object<StateDeltaDto>::Class::getType();
+
       case MessageCodes::INCOMING_CLIENT_MESSAGE:
         return oatpp::String::Class::getType();
 
+      case MessageCodes::INCOMING_CLIENT_STATE_ACK:
+        return oatpp::Int64::Class::getType();
+
       default:
         throw std::runtime_error("not implemented");
 
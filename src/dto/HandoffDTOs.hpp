@@ -0,0 +1,143 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_dto_HandoffDTOs_hpp
+#define Helicopter_dto_HandoffDTOs_hpp
+
+#include "./DTOs.hpp"
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+/**
+ * Key of the session state store.
+ */
+class StateEntryDto : public oatpp::DTO {
+
+  DTO_INIT(StateEntryDto, DTO)
+
+  /**
+   * Key.
+   */
+  DTO_FIELD(String, key);
+
+  /**
+   * Value. null - key was removed.
+   */
+  DTO_FIELD(String, value);
+
+  /**
+   * Version of the state the key was changed in.
+   */
+  DTO_FIELD(Int64, version);
+
+};
+
+/**
+ * Peer of the handed off session.
+ */
+class PeerSnapshotDto : public oatpp::DTO {
+
+  DTO_INIT(PeerSnapshotDto, DTO)
+
+  /**
+   * ID of the peer. Preserved on the new server.
+   */
+  DTO_FIELD(Int64, peerId);
+
+  /**
+   * Is the peer host of the session.
+   */
+  DTO_FIELD(Boolean, isHost);
+
+  /**
+   * One-time token peer uses to resume on the new server.
+   */
+  DTO_FIELD(String, resumeToken);
+
+  /**
+   * Version of the session state acknowledged by the client.
+   */
+  DTO_FIELD(Int64, ackedVersion);
+
+  /**
+   * Cell of the peer in the spatial grid. null - peer hasn't declared its cell.
+   */
+  DTO_FIELD(Object<CellDto>, cell);
+
+  /**
+   * Messages queued for the peer and not sent yet - in order of sending.
+   */
+  DTO_FIELD(Vector<Object<MessageDto>>, queue);
+
+};
+
+/**
+ * Game session handed off to the successor process.
+ */
+class SessionSnapshotDto : public oatpp::DTO {
+
+  DTO_INIT(SessionSnapshotDto, DTO)
+
+  /**
+   * Game ID.
+   */
+  DTO_FIELD(String, gameId);
+
+  /**
+   * Session ID.
+   */
+  DTO_FIELD(String, sessionId);
+
+  /**
+   * Next peer ID to assign.
+   */
+  DTO_FIELD(Int64, peerIdCounter);
+
+  /**
+   * Next synchronized event ID - event sequence continues on the new server.
+   */
+  DTO_FIELD(Int64, synchronizedEventId);
+
+  /**
+   * Version of the session state.
+   */
+  DTO_FIELD(Int64, stateVersion);
+
+  /**
+   * Keys of the session state.
+   */
+  DTO_FIELD(Vector<Object<StateEntryDto>>, state);
+
+  /**
+   * Session roster.
+   */
+  DTO_FIELD(Vector<Object<PeerSnapshotDto>>, peers);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#endif //Helicopter_dto_HandoffDTOs_hpp
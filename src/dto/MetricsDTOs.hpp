@@ -0,0 +1,85 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_dto_MetricsDTOs_hpp
+#define Helicopter_dto_MetricsDTOs_hpp
+
+#include "./DTOs.hpp"
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+/**
+ * Latency percentiles. Values are in microseconds.
+ */
+class PercentilesDto : public oatpp::DTO {
+
+  DTO_INIT(PercentilesDto, DTO)
+
+  /**
+   * Number of recorded values.
+   */
+  DTO_FIELD(UInt64, count);
+
+  DTO_FIELD(Int64, p50);
+  DTO_FIELD(Int64, p99);
+  DTO_FIELD(Int64, p999);
+  DTO_FIELD(Int64, max);
+
+};
+
+/**
+ * Latency of outgoing messages with the same code.
+ */
+class MessageLatencyDto : public oatpp::DTO {
+
+  DTO_INIT(MessageLatencyDto, DTO)
+
+  /**
+   * Code of the outgoing message. `-1` - unknown code.
+   */
+  DTO_FIELD(Int32, code);
+
+  /**
+   * From the moment the inbound message is read till the write of the outgoing message is complete.
+   * Messages relayed for peers only.
+   */
+  DTO_FIELD(Object<PercentilesDto>, endToEnd);
+
+  /**
+   * Time spent in the recipient's queue.
+   */
+  DTO_FIELD(Object<PercentilesDto>, queueWait);
+
+  /**
+   * From dequeue till the socket write is complete.
+   */
+  DTO_FIELD(Object<PercentilesDto>, write);
+
+};
+
+#include OATPP_CODEGEN_END(DTO)
+
+#endif //Helicopter_dto_MetricsDTOs_hpp
@@ -0,0 +1,125 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "AdmissionControl.hpp"
+
+AdmissionControl::AdmissionControl(const oatpp::Object<ConfigDto>& config)
+  : m_peersCount(0)
+  , m_draining(false)
+  , m_maxPeers(config->maxPeers)
+  , m_connectRate(config->maxConnectsPerSecondPerIp)
+  , m_connectBurst(config->maxConnectsBurstPerIp)
+  , m_maxQueueDelayMicros((v_int64) config->maxQueueDelayMillis * 1000)
+{}
+
+void AdmissionControl::evictIdleAddresses(Shard& shard, v_int64 timestamp) {
+
+  auto it = shard.buckets.begin();
+  while(it != shard.buckets.end()) {
+    if(it->second.isFull(timestamp)) {
+      it = shard.buckets.erase(it);
+    } else {
+      it ++;
+    }
+  }
+
+  /* under a flood from many addresses - forget them all rather than grow */
+  if(shard.buckets.size() >= SHARD_MAX_ADDRESSES) {
+    shard.buckets.clear();
+  }
+
+}
+
+bool AdmissionControl::checkConnectRate(const oatpp::String& address) {
+
+  if(!address || m_connectRate <= 0) {
+    return true;
+  }
+
+  auto& shard = m_shards[std::hash<oatpp::String>{}(address) % SHARDS_COUNT];
+  auto timestamp = oatpp::base::Environment::getMicroTickCount();
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  auto it = shard.buckets.find(address);
+  if(it == shard.buckets.end()) {
+    if(shard.buckets.size() >= SHARD_MAX_ADDRESSES) {
+      evictIdleAddresses(shard, timestamp);
+    }
+    it = shard.buckets.insert({address, TokenBucket(m_connectRate, m_connectBurst, timestamp)}).first;
+  }
+
+  return it->second.tryConsume(1, timestamp);
+
+}
+
+bool AdmissionControl::tryAcquirePeerSlot() {
+  if(m_maxPeers <= 0) {
+    m_peersCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  if(m_peersCount.fetch_add(1, std::memory_order_relaxed) >= m_maxPeers) {
+    m_peersCount.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void AdmissionControl::releasePeerSlot() {
+  m_peersCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool AdmissionControl::isFull() {
+  return m_maxPeers > 0 && m_peersCount.load(std::memory_order_relaxed) >= m_maxPeers;
+}
+
+v_int64 AdmissionControl::getPeersCount() {
+  return m_peersCount.load(std::memory_order_relaxed);
+}
+
+void AdmissionControl::setDraining() {
+  m_draining.store(true, std::memory_order_release);
+}
+
+bool AdmissionControl::isDraining() {
+  return m_draining.load(std::memory_order_acquire);
+}
+
+void AdmissionControl::setExecutorProbes(const std::vector<std::shared_ptr<ExecutorProbe>>& probes) {
+  m_probes = probes;
+}
+
+bool AdmissionControl::isOverloaded() {
+  if(m_maxQueueDelayMicros <= 0) {
+    return false;
+  }
+  for(auto& probe : m_probes) {
+    if(probe->getMaxQueueDelay() > m_maxQueueDelayMicros) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_game_AdmissionControl_hpp
+#define Helicopter_game_AdmissionControl_hpp
+
+#include "config/Config.hpp"
+#include "utils/ExecutorProbe.hpp"
+#include "utils/TokenBucket.hpp"
+
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+
+/**
+ * Server-wide admission control.
+ * Evaluated for each new connection before the peer is allocated.
+ */
+class AdmissionControl {
+private:
+
+  /*
+   * Connect rate buckets are split to shards to reduce lock contention under connect flood.
+   */
+  static constexpr v_int32 SHARDS_COUNT = 16;
+
+  /*
+   * Max number of tracked addresses per shard.
+   */
+  static constexpr v_int32 SHARD_MAX_ADDRESSES = 4096;
+
+  struct Shard {
+    std::unordered_map<oatpp::String, TokenBucket> buckets;
+    std::mutex mutex;
+  };
+
+private:
+  std::atomic<v_int64> m_peersCount;
+  std::atomic<bool> m_draining;
+  v_int64 m_maxPeers;
+  v_float64 m_connectRate;
+  v_float64 m_connectBurst;
+  Shard m_shards[SHARDS_COUNT];
+  v_int64 m_maxQueueDelayMicros;
+  std::vector<std::shared_ptr<ExecutorProbe>> m_probes; // set once at startup
+private:
+  void evictIdleAddresses(Shard& shard, v_int64 timestamp);
+public:
+
+  /**
+   * Constructor.
+   * @param config
+   */
+  AdmissionControl(const oatpp::Object<ConfigDto>& config);
+
+  /**
+   * Check connect rate of the address.
+   * @param address - peer address. If `nullptr` - rate is not checked.
+   * @return - `false` if the address exceeded connect rate.
+   */
+  bool checkConnectRate(const oatpp::String& address);
+
+  /**
+   * Reserve slot for a new peer.
+   * @return - `false` if server reached max number of peers.
+   */
+  bool tryAcquirePeerSlot();
+
+  /**
+   * Release slot of the disconnected peer.
+   */
+  void releasePeerSlot();
+
+  /**
+   * Check if server reached max number of peers. Cheap pre-check before the websocket handshake -
+   * the slot is still reserved with `tryAcquirePeerSlot()` once the socket is created.
+   * @return
+   */
+  bool isFull();
+
+  /**
+   * Get number of peers connected to server.
+   * @return
+   */
+  v_int64 getPeersCount();
+
+  /**
+   * Start drain - server stops accepting new game sessions. Existing sessions are served.
+   */
+  void setDraining();
+
+  /**
+   * Check if server is draining.
+   * @return
+   */
+  bool isDraining();
+
+  /**
+   * Set executor probes to watch for saturation. Call before servers are started.
+   * @param probes
+   */
+  void setExecutorProbes(const std::vector<std::shared_ptr<ExecutorProbe>>& probes);
+
+  /**
+   * Check if any executor worker is saturated - its queue delay is above `maxQueueDelayMillis`.
+   * @return
+   */
+  bool isOverloaded();
+
+};
+
+#endif //Helicopter_game_AdmissionControl_hpp
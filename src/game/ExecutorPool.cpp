@@ -0,0 +1,105 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ExecutorPool.hpp"
+
+ExecutorPool::ExecutorPool(v_int32 size, SessionPlacement placement)
+  : m_placement(placement)
+  , m_affine(true)
+  , m_ownsExecutors(true)
+{
+  for(v_int32 i = 0; i < size; i ++) {
+    /* single processor worker - session coroutines never run in parallel */
+    m_executors.push_back(std::make_shared<oatpp::async::Executor>(1, 1, 1));
+    m_sessionsCount.push_back(0);
+  }
+}
+
+ExecutorPool::ExecutorPool(const std::shared_ptr<oatpp::async::Executor>& executor, bool affine)
+  : m_placement(SessionPlacement::HASH)
+  , m_affine(affine)
+  , m_ownsExecutors(false)
+{
+  m_executors.push_back(executor);
+  m_sessionsCount.push_back(0);
+}
+
+ExecutorPool::~ExecutorPool() {
+  if(m_ownsExecutors) {
+    for(auto& executor : m_executors) {
+      executor->stop();
+    }
+    for(auto& executor : m_executors) {
+      executor->join();
+    }
+  }
+}
+
+v_int32 ExecutorPool::acquire(const oatpp::String& sessionKey) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  v_int32 index = 0;
+
+  if(m_executors.size() > 1) {
+    switch (m_placement) {
+
+      case SessionPlacement::HASH:
+        index = (v_int32) (std::hash<oatpp::String>{}(sessionKey) % m_executors.size());
+        break;
+
+      case SessionPlacement::LOAD:
+        for(v_int32 i = 1; i < (v_int32) m_sessionsCount.size(); i ++) {
+          if(m_sessionsCount[i] < m_sessionsCount[index]) {
+            index = i;
+          }
+        }
+        break;
+
+    }
+  }
+
+  m_sessionsCount[index] ++;
+  return index;
+
+}
+
+void ExecutorPool::release(v_int32 index) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_sessionsCount[index] --;
+}
+
+std::shared_ptr<oatpp::async::Executor> ExecutorPool::getExecutor(v_int32 index) {
+  return m_executors[index];
+}
+
+const std::vector<std::shared_ptr<oatpp::async::Executor>>& ExecutorPool::getExecutors() {
+  return m_executors;
+}
+
+bool ExecutorPool::isAffine() {
+  return m_affine;
+}
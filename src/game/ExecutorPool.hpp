@@ -0,0 +1,107 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_game_ExecutorPool_hpp
+#define Helicopter_game_ExecutorPool_hpp
+
+#include "config/Config.hpp"
+
+#include "oatpp/core/async/Executor.hpp"
+
+#include <vector>
+#include <mutex>
+
+/**
+ * Executors game sessions are pinned to.
+ * In affine mode each executor has a single processor worker, so all coroutines of a session
+ * (inbound messages, fan-out, pings) run serially on the same thread - like an actor's mailbox.
+ * In shared mode all sessions run on the application executor.
+ */
+class ExecutorPool {
+private:
+  std::vector<std::shared_ptr<oatpp::async::Executor>> m_executors;
+  std::vector<v_int64> m_sessionsCount;
+  SessionPlacement m_placement;
+  bool m_affine;
+  bool m_ownsExecutors;
+  std::mutex m_mutex;
+public:
+
+  /**
+   * Create pool of single-threaded executors. Affine mode.
+   * @param size - number of executors.
+   * @param placement - how sessions are spread across executors.
+   */
+  ExecutorPool(v_int32 size, SessionPlacement placement);
+
+  /**
+   * Create pool of one executor owned by someone else.
+   * @param executor
+   * @param affine - `true` if inbound messages should be handled on this executor
+   * (ex.: executor of the shard owning the session). `false` - shared mode.
+   */
+  ExecutorPool(const std::shared_ptr<oatpp::async::Executor>& executor, bool affine = false);
+
+  /**
+   * Stop and join owned executors.
+   */
+  ~ExecutorPool();
+
+  /**
+   * Choose executor for a new session.
+   * @param sessionKey - key to hash. Used with `SessionPlacement::HASH`.
+   * @return - index of the executor. Release it with `release()` once session is destroyed.
+   */
+  v_int32 acquire(const oatpp::String& sessionKey);
+
+  /**
+   * Release executor acquired for session.
+   * @param index
+   */
+  void release(v_int32 index);
+
+  /**
+   * Get executor by index.
+   * @param index
+   * @return
+   */
+  std::shared_ptr<oatpp::async::Executor> getExecutor(v_int32 index);
+
+  /**
+   * Get all executors of the pool.
+   * @return
+   */
+  const std::vector<std::shared_ptr<oatpp::async::Executor>>& getExecutors();
+
+  /**
+   * Check if inbound messages of the session should be handled on the session's executor.
+   * @return
+   */
+  bool isAffine();
+
+};
+
+#endif //Helicopter_game_ExecutorPool_hpp
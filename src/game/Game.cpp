@@ -26,13 +26,53 @@
 
 #include "Game.hpp"
 
-Game::Game(const oatpp::Object<GameConfigDto>& config)
+#include "utils/AsyncLogger.hpp"
+#include "utils/Clock.hpp"
+
+Game::Game(const oatpp::Object<GameConfigDto>& config,
+           const std::shared_ptr<ExecutorPool>& sessionExecutors)
   : m_state(std::make_shared<State>())
+  , m_sessionExecutors(sessionExecutors)
 {
   m_state->config = config;
+  m_state->gamesConfig = m_gamesConfig;
   m_state->isPingerActive = false;
 }
 
+void Game::State::refreshConfig() {
+  /* sessions keep the config they were created with */
+  auto latest = gamesConfig->getGameConfig(config->gameId);
+  if(latest) {
+    config = latest;
+  }
+}
+
+void Game::State::runPingRound() {
+
+  refreshConfig();
+
+  for(auto& session : sessions) {
+    session.second->checkAllPeersPings();
+  }
+
+  for(auto& session : sessions) {
+    session.second->pingAllPeers();
+  }
+
+  /* restored sessions whose peers didn't reconnect after handoff */
+  auto timestamp = oatpp::base::Environment::getMicroTickCount();
+  auto it = sessions.begin();
+  while(it != sessions.end()) {
+    if(it->second->expireReservations(timestamp)) {
+      HELI_LOGD("Pinger", "Abandoned session deleted - '%s'", it->first->c_str());
+      it = sessions.erase(it);
+    } else {
+      it ++;
+    }
+  }
+
+}
+
 void Game::startPinger() {
 
   class Pinger : public oatpp::async::Coroutine<Pinger> {
@@ -50,16 +90,13 @@ void Game::startPinger() {
 
       if(m_state->sessions.empty()) {
         m_state->isPingerActive = false;
-        OATPP_LOGD("Pinger", "Stopped")
+        HELI_LOGD("Pinger", "Stopped");
         return finish();
       }
 
-      for(auto& session : m_state->sessions) {
-        session.second->checkAllPeersPings();
-      }
-
-      for(auto& session : m_state->sessions) {
-        session.second->pingAllPeers();
+      /* manual clock - rounds are run by the test via Game::runPingRound() */
+      if(!Clock::isManual()) {
+        m_state->runPingRound();
       }
 
       return waitRepeat(std::chrono::milliseconds(m_state->config->pingIntervalMillis));
@@ -69,9 +106,9 @@ void Game::startPinger() {
   };
 
   if(!m_state->isPingerActive) {
-    OATPP_LOGD("Pinger", "Started")
+    HELI_LOGD("Pinger", "Started");
     m_state->isPingerActive = true;
-    m_asyncExecutor->execute<Pinger>(m_state);
+    m_controlExecutor->execute<Pinger>(m_state);
   }
 }
 
@@ -84,7 +121,9 @@ std::shared_ptr<Session> Game::createNewSession(const oatpp::String& sessionId)
     return nullptr;
   }
 
-  auto session = std::make_shared<Session>(sessionId, m_state->config);
+  m_state->refreshConfig();
+
+  auto session = std::make_shared<Session>(sessionId, m_state->config, m_sessionExecutors);
   m_state->sessions.insert({sessionId, session});
 
   startPinger();
@@ -92,6 +131,11 @@ std::shared_ptr<Session> Game::createNewSession(const oatpp::String& sessionId)
   return session;
 }
 
+void Game::runPingRound() {
+  std::lock_guard<std::mutex> lock(m_state->mutex);
+  m_state->runPingRound();
+}
+
 std::shared_ptr<Session> Game::findSession(const oatpp::String& sessionId) {
   std::lock_guard<std::mutex> lock(m_state->mutex);
   auto it = m_state->sessions.find(sessionId);
@@ -105,3 +149,34 @@ void Game::deleteSession(const oatpp::String& sessionId) {
   std::lock_guard<std::mutex> lock(m_state->mutex);
   m_state->sessions.erase(sessionId);
 }
+
+std::vector<std::shared_ptr<Session>> Game::getAllSessions() {
+  std::lock_guard<std::mutex> lock(m_state->mutex);
+  std::vector<std::shared_ptr<Session>> result;
+  result.reserve(m_state->sessions.size());
+  for(auto& pair : m_state->sessions) {
+    result.emplace_back(pair.second);
+  }
+  return result;
+}
+
+std::shared_ptr<Session> Game::restoreSession(const oatpp::Object<SessionSnapshotDto>& snapshot, v_int64 resumeDeadline) {
+
+  std::lock_guard<std::mutex> lock(m_state->mutex);
+
+  auto it = m_state->sessions.find(snapshot->sessionId);
+  if(it != m_state->sessions.end()) {
+    return nullptr;
+  }
+
+  m_state->refreshConfig();
+
+  auto session = std::make_shared<Session>(snapshot->sessionId, m_state->config, m_sessionExecutors);
+  session->restore(snapshot, resumeDeadline);
+  m_state->sessions.insert({snapshot->sessionId, session});
+
+  startPinger();
+
+  return session;
+
+}
@@ -30,18 +30,29 @@
 #include "./Session.hpp"
 #include "config/GamesConfig.hpp"
 
+#include "Constants.hpp"
+
 class Game {
 private:
   struct State {
     oatpp::Object<GameConfigDto> config;
+    std::shared_ptr<GamesConfig> gamesConfig;
     std::unordered_map<oatpp::String, std::shared_ptr<Session>> sessions;
     std::mutex mutex;
     bool isPingerActive;
+    /* pick up the latest published config. Call under mutex */
+    void refreshConfig();
+    /* check pings of the previous round and ping all peers. Call under mutex */
+    void runPingRound();
   };
 private:
   std::shared_ptr<State> m_state;
 private:
-  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, m_asyncExecutor);
+  std::shared_ptr<ExecutorPool> m_sessionExecutors;
+private:
+  /* pinger runs on the control executor */
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, m_controlExecutor, Constants::COMPONENT_CONTROL);
+  OATPP_COMPONENT(std::shared_ptr<GamesConfig>, m_gamesConfig);
 private:
   void startPinger();
 public:
@@ -49,8 +60,10 @@ public:
   /**
    * Constructor.
    * @param config
+   * @param sessionExecutors - executors to pin game sessions to.
    */
-  Game(const oatpp::Object<GameConfigDto>& config);
+  Game(const oatpp::Object<GameConfigDto>& config,
+       const std::shared_ptr<ExecutorPool>& sessionExecutors);
 
   /**
    * Not thread safe.
@@ -61,6 +74,12 @@ public:
    */
   std::shared_ptr<Session> createNewSession(const oatpp::String& sessionId);
 
+  /**
+   * Check pings of the previous round and ping all peers of all sessions.
+   * Called by the pinger every `pingIntervalMillis`. With manual `Clock` - called by tests.
+   */
+  void runPingRound();
+
   /**
    * NOT thread-safe
    * @param sessionId
@@ -74,6 +93,20 @@ public:
    */
   void deleteSession(const oatpp::String& sessionId);
 
+  /**
+   * Get all sessions of the game.
+   * @return
+   */
+  std::vector<std::shared_ptr<Session>> getAllSessions();
+
+  /**
+   * Handoff. Restore session exported by the predecessor process.
+   * @param snapshot
+   * @param resumeDeadline - timestamp in microseconds after which peers which didn't reconnect are dropped.
+   * @return - `std::shared_ptr` to the restored Session or `nullptr` if session with such ID already exists.
+   */
+  std::shared_ptr<Session> restoreSession(const oatpp::Object<SessionSnapshotDto>& snapshot, v_int64 resumeDeadline);
+
 };
 
 #endif //Helicopter_game_Game_hpp
@@ -27,20 +27,88 @@
 #include "Peer.hpp"
 #include "Session.hpp"
 
+#include "utils/AsyncLogger.hpp"
+#include "utils/Clock.hpp"
+#include "utils/Metrics.hpp"
+
 #include "oatpp/core/utils/ConversionUtils.hpp"
 
+#include <algorithm>
+
+namespace {
+
+  /* how often a peer with a full mailbox checks if the session caught up */
+  constexpr v_int64 MAILBOX_POLL_MICROS = 1000;
+
+}
+
 Peer::Peer(const std::shared_ptr<AsyncWebSocket>& socket,
            const std::shared_ptr<Session>& gameSession,
-           v_int64 peerId)
+           v_int64 peerId,
+           const std::shared_ptr<RelayLink>& relayLink,
+           v_int64 relayRef)
   : m_socket(socket)
   , m_gameSession(gameSession)
+  , m_limits(&gameSession->getLimits())
+  , m_executor(gameSession->getExecutor())
   , m_peerId(peerId)
   , m_messageQueue(std::make_shared<MessageQueue>())
+  , m_relayLink(relayLink)
+  , m_relayRef(relayRef)
   , m_pingTime(-1)
   , m_failedPings(0)
   , m_lastPingTimestamp(-1)
+  , m_pingSentTimestamp(-1)
+  , m_messagesBucket(createRateLimit(m_limits->maxMessagesPerSecond, 1, *m_limits))
+  , m_bytesBucket(createRateLimit(m_limits->maxBytesPerSecond, m_limits->maxMessageSizeBytes, *m_limits))
+  , m_limitMessages(m_limits->maxMessagesPerSecond > 0)
+  , m_limitBytes(m_limits->maxBytesPerSecond > 0)
+  , m_pendingMessages(0)
 {}
 
+TokenBucket Peer::createRateLimit(v_float64 rate, v_float64 minCapacity, const GameLimits& limits) {
+  /* capacity can't be less than a single message, or such message will never pass */
+  v_float64 capacity = std::max(rate * limits.rateLimitBurstMillis / 1000.0, minCapacity);
+  return TokenBucket(rate, capacity, oatpp::base::Environment::getMicroTickCount());
+}
+
+oatpp::String Peer::serializeMessage(const oatpp::Object<MessageDto>& message) {
+  auto data = m_objectMapper->writeToString(message);
+  Metrics::countOutgoing(static_cast<v_int32>(*message->code), data->size());
+  return data;
+}
+
+bool Peer::checkRateLimits(v_buff_size messageSize, v_int64& throttleMicros) {
+
+  throttleMicros = 0;
+
+  if(!m_limitMessages && !m_limitBytes) {
+    return true;
+  }
+
+  auto timestamp = oatpp::base::Environment::getMicroTickCount();
+
+  if(m_limits->rateLimitPolicy == RateLimitPolicy::THROTTLE) {
+    if(m_limitMessages) {
+      throttleMicros = m_messagesBucket.consume(1, timestamp);
+    }
+    if(m_limitBytes) {
+      throttleMicros = std::max(throttleMicros, m_bytesBucket.consume(messageSize, timestamp));
+    }
+    return true;
+  }
+
+  bool withinLimits = true;
+  if(m_limitMessages) {
+    withinLimits = m_messagesBucket.tryConsume(1, timestamp);
+  }
+  if(withinLimits && m_limitBytes) {
+    withinLimits = m_bytesBucket.tryConsume(messageSize, timestamp);
+  }
+  return withinLimits;
+
+}
+
 oatpp::async::CoroutineStarter Peer::sendMessageAsync(const oatpp::Object<MessageDto>& message) {
 
   class SendMessageCoroutine : public oatpp::async::Coroutine<SendMessageCoroutine> {
@@ -65,8 +133,10 @@ oatpp::async::CoroutineStarter Peer::sendMessageAsync(const oatpp::Object<Messag
   };
 
   std::lock_guard<std::mutex> socketLock(m_socketMutex);
-  if (m_socket) {
-    return SendMessageCoroutine::start(&m_writeLock, m_socket, m_objectMapper->writeToString(message));
+  if (m_relayLink) {
+    m_relayLink->deliver(m_relayRef, serializeMessage(message));
+  } else if (m_socket) {
+    return SendMessageCoroutine::start(&m_writeLock, m_socket, serializeMessage(message));
   }
 
   return nullptr;
@@ -115,15 +185,20 @@ oatpp::async::CoroutineStarter Peer::sendErrorAsync(const oatpp::Object<ErrorDto
   message->payload = error;
 
   std::lock_guard<std::mutex> socketLock(m_socketMutex);
-  if (m_socket) {
-    return SendErrorCoroutine::start(&m_writeLock, m_socket, m_objectMapper->writeToString(message), fatal);
+  if (m_relayLink) {
+    m_relayLink->deliver(m_relayRef, serializeMessage(message));
+    if(fatal) {
+      m_relayLink->closePeer(m_relayRef);
+    }
+  } else if (m_socket) {
+    return SendErrorCoroutine::start(&m_writeLock, m_socket, serializeMessage(message), fatal);
   }
 
   return nullptr;
 
 }
 
-bool Peer::queueMessage(const oatpp::Object<MessageDto>& message) {
+bool Peer::queueMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
 
   class SendMessageCoroutine : public oatpp::async::Coroutine<SendMessageCoroutine> {
   private:
@@ -131,16 +206,27 @@ bool Peer::queueMessage(const oatpp::Object<MessageDto>& message) {
     oatpp::async::Lock* m_lock;
     std::shared_ptr<AsyncWebSocket> m_websocket;
     std::shared_ptr<MessageQueue> m_queue;
+    std::shared_ptr<Tracer> m_tracer;
+    v_int64 m_peerId;
+    QueuedMessage m_current;
+    v_int64 m_dequeuedTimestamp;
+    v_int32 m_code;
   public:
 
     SendMessageCoroutine(const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& mapper,
                          oatpp::async::Lock* lock,
                          const std::shared_ptr<AsyncWebSocket>& websocket,
-                         const std::shared_ptr<MessageQueue>& queue)
+                         const std::shared_ptr<MessageQueue>& queue,
+                         const std::shared_ptr<Tracer>& tracer,
+                         v_int64 peerId)
       : m_mapper(mapper)
       , m_lock(lock)
       , m_websocket(websocket)
       , m_queue(queue)
+      , m_tracer(tracer)
+      , m_peerId(peerId)
+      , m_dequeuedTimestamp(0)
+      , m_code(-1)
     {}
 
     Action act() override {
@@ -150,13 +236,36 @@ bool Peer::queueMessage(const oatpp::Object<MessageDto>& message) {
         m_queue->active = false;
         return finish();
       }
-      auto msg = m_queue->queue.back();
+      m_current = m_queue->queue.back();
       m_queue->queue.pop_back();
       lock.unlock();
 
-      auto json = m_mapper->writeToString(msg);
-      return oatpp::async::synchronize(m_lock,m_websocket->sendOneFrameTextAsync(json)).next(repeat());
+      m_dequeuedTimestamp = oatpp::base::Environment::getMicroTickCount();
+      m_code = static_cast<v_int32>(*m_current.message->code);
+
+      auto json = m_mapper->writeToString(m_current.message);
+      Metrics::countOutgoing(m_code, json->size());
+      return oatpp::async::synchronize(m_lock,m_websocket->sendOneFrameTextAsync(json)).next(yieldTo(&SendMessageCoroutine::onSent));
+
+    }
 
+    Action onSent() {
+      v_int64 timestamp = oatpp::base::Environment::getMicroTickCount();
+      Metrics::recordLatency(Metrics::LATENCY_QUEUE_WAIT, m_code, m_dequeuedTimestamp - m_current.queuedTimestamp);
+      Metrics::recordLatency(Metrics::LATENCY_WRITE, m_code, timestamp - m_dequeuedTimestamp);
+      if(m_current.origin.receivedTimestamp >= 0) {
+        Metrics::recordLatency(Metrics::LATENCY_END_TO_END, m_code, timestamp - m_current.origin.receivedTimestamp);
+      }
+      if(m_current.origin.traceId != 0) {
+        const MessageOrigin& origin = m_current.origin;
+        m_tracer->record({"queued", origin.traceId, origin.ocid, m_peerId, m_code,
+                          m_current.queuedTimestamp, m_dequeuedTimestamp - m_current.queuedTimestamp});
+        m_tracer->record({"write", origin.traceId, origin.ocid, m_peerId, m_code,
+                          m_dequeuedTimestamp, timestamp - m_dequeuedTimestamp});
+      }
+      m_current.message = nullptr;
+      m_current.origin = MessageOrigin();
+      return yieldTo(&SendMessageCoroutine::act);
     }
 
     Action handleError(oatpp::async::Error* error) override {
@@ -165,42 +274,81 @@ bool Peer::queueMessage(const oatpp::Object<MessageDto>& message) {
 
   };
 
+  if(message && m_relayLink) {
+    /* relay link has its own outbox */
+    if(m_relayLink->deliver(m_relayRef, serializeMessage(message))) {
+      return true;
+    }
+    Metrics::increment(Metrics::QUEUE_OVERFLOW_DROPS);
+    return false;
+  }
+
   if(message) {
     std::lock_guard<std::mutex> lock(m_messageQueue->mutex);
-    if(m_messageQueue->queue.size() < m_gameSession->getConfig()->maxQueuedMessages) {
-      m_messageQueue->queue.push_front(message);
+    if(m_messageQueue->queue.size() < m_limits->maxQueuedMessages) {
+      m_messageQueue->queue.push_front({message, origin, oatpp::base::Environment::getMicroTickCount()});
       if (!m_messageQueue->active) {
         m_messageQueue->active = true;
         std::lock_guard<std::mutex> socketLock(m_socketMutex);
         if (m_socket) {
-          m_asyncExecutor->execute<SendMessageCoroutine>(m_objectMapper, &m_writeLock, m_socket, m_messageQueue);
+          m_executor->execute<SendMessageCoroutine>(m_objectMapper, &m_writeLock, m_socket, m_messageQueue, m_tracer, m_peerId);
         }
       }
       return true;
     }
+    Metrics::increment(Metrics::QUEUE_OVERFLOW_DROPS);
   }
   return false;
 }
 
 void Peer::ping(v_int64 timestampMicroseconds) {
 
+  class SendPingCoroutine : public oatpp::async::Coroutine<SendPingCoroutine> {
+  private:
+    std::shared_ptr<Peer> m_peer;
+    std::shared_ptr<AsyncWebSocket> m_websocket;
+    oatpp::String m_message;
+  public:
+
+    SendPingCoroutine(const std::shared_ptr<Peer>& peer,
+                      const std::shared_ptr<AsyncWebSocket>& websocket,
+                      const oatpp::String& message)
+      : m_peer(peer)
+      , m_websocket(websocket)
+      , m_message(message)
+    {}
+
+    Action act() override {
+      /* write lock is acquired - time spent in the outgoing queue is not counted in ping */
+      {
+        std::lock_guard<std::mutex> pingLock(m_peer->m_pingMutex);
+        m_peer->m_pingSentTimestamp = Clock::getMicroTickCount();
+      }
+      return m_websocket->sendOneFrameTextAsync(m_message).next(finish());
+    }
+
+  };
+
   class PingCoroutine : public oatpp::async::Coroutine<PingCoroutine> {
   private:
     oatpp::async::Lock* m_lock;
+    std::shared_ptr<Peer> m_peer;
     std::shared_ptr<AsyncWebSocket> m_websocket;
     oatpp::String m_message;
   public:
 
     PingCoroutine(oatpp::async::Lock* lock,
+                  const std::shared_ptr<Peer>& peer,
                   const std::shared_ptr<AsyncWebSocket>& websocket,
                   const oatpp::String& message)
       : m_lock(lock)
+      , m_peer(peer)
       , m_websocket(websocket)
       , m_message(message)
     {}
 
     Action act() override {
-      return oatpp::async::synchronize(m_lock, m_websocket->sendOneFrameTextAsync(m_message)).next(finish());
+      return oatpp::async::synchronize(m_lock, SendPingCoroutine::start(m_peer, m_websocket, m_message)).next(finish());
     }
 
   };
@@ -208,24 +356,35 @@ void Peer::ping(v_int64 timestampMicroseconds) {
   auto message = MessageDto::createShared(MessageCodes::OUTGOING_PING, oatpp::Int64(timestampMicroseconds));
 
   std::lock_guard<std::mutex> socketLock(m_socketMutex);
-  if (m_socket) {
-    m_asyncExecutor->execute<PingCoroutine>(&m_writeLock, m_socket, m_objectMapper->writeToString(message));
+  if (m_relayLink) {
+    {
+      std::lock_guard<std::mutex> pingLock(m_pingMutex);
+      m_pingSentTimestamp = Clock::getMicroTickCount();
+    }
+    m_relayLink->deliver(m_relayRef, serializeMessage(message));
+  } else if (m_socket) {
+    m_controlExecutor->execute<PingCoroutine>(&m_writeLock, shared_from_this(), m_socket, serializeMessage(message));
   }
 
 }
 
 void Peer::kick() {
+  Metrics::increment(Metrics::KICKS);
+  disconnect(MessageDto::createShared(MessageCodes::OUTGOING_CLIENT_KICKED, oatpp::String("you were kicked.")));
+}
+
+void Peer::disconnect(const oatpp::Object<MessageDto>& message) {
 
-  class KickCoroutine : public oatpp::async::Coroutine<KickCoroutine> {
+  class DisconnectCoroutine : public oatpp::async::Coroutine<DisconnectCoroutine> {
   private:
     oatpp::async::Lock* m_lock;
     std::shared_ptr<AsyncWebSocket> m_websocket;
     oatpp::String m_message;
   public:
 
-    KickCoroutine(oatpp::async::Lock* lock,
-                  const std::shared_ptr<AsyncWebSocket>& websocket,
-                  const oatpp::String& message)
+    DisconnectCoroutine(oatpp::async::Lock* lock,
+                        const std::shared_ptr<AsyncWebSocket>& websocket,
+                        const oatpp::String& message)
       : m_lock(lock)
       , m_websocket(websocket)
       , m_message(message)
@@ -233,7 +392,7 @@ void Peer::kick() {
 
     Action act() override {
       return oatpp::async::synchronize(m_lock, m_websocket->sendOneFrameTextAsync(m_message))
-        .next(yieldTo(&KickCoroutine::onMessageSent));
+        .next(yieldTo(&DisconnectCoroutine::onMessageSent));
     }
 
     Action onMessageSent() {
@@ -243,14 +402,40 @@ void Peer::kick() {
 
   };
 
-  auto message = MessageDto::createShared(MessageCodes::OUTGOING_CLIENT_KICKED, oatpp::String("you were kicked."));
-
   std::lock_guard<std::mutex> socketLock(m_socketMutex);
-  if (m_socket) {
-    m_asyncExecutor->execute<KickCoroutine>(&m_writeLock, m_socket, m_objectMapper->writeToString(message));
+  if (m_relayLink) {
+    m_relayLink->deliver(m_relayRef, serializeMessage(message));
+    m_relayLink->closePeer(m_relayRef);
+  } else if (m_socket) {
+    m_controlExecutor->execute<DisconnectCoroutine>(&m_writeLock, m_socket, serializeMessage(message));
   }
 }
 
+std::vector<oatpp::Object<MessageDto>> Peer::takeQueuedMessages() {
+  std::lock_guard<std::mutex> lock(m_messageQueue->mutex);
+  /* queue is pushed to the front and sent from the back */
+  std::vector<oatpp::Object<MessageDto>> result;
+  result.reserve(m_messageQueue->queue.size());
+  for(auto it = m_messageQueue->queue.rbegin(); it != m_messageQueue->queue.rend(); it ++) {
+    result.push_back(it->message);
+  }
+  m_messageQueue->queue.clear();
+  return result;
+}
+
+v_int64 Peer::getQueuedMessagesCount() {
+  std::lock_guard<std::mutex> lock(m_messageQueue->mutex);
+  return m_messageQueue->queue.size();
+}
+
+std::shared_ptr<RelayLink> Peer::getRelayLink() {
+  return m_relayLink;
+}
+
+v_int64 Peer::getRelayRef() {
+  return m_relayRef;
+}
+
 std::shared_ptr<Session> Peer::getGameSession() {
   return m_gameSession;
 }
@@ -262,6 +447,9 @@ v_int64 Peer::getPeerId() {
 void Peer::invalidateSocket() {
   {
     std::lock_guard<std::mutex> socketLock(m_socketMutex);
+    if (m_relayLink) {
+      m_relayLink->closePeer(m_relayRef);
+    }
     if (m_socket) {
       m_socket->getConnection().invalidate();
       m_socket.reset();
@@ -280,18 +468,27 @@ void Peer::checkPingsRules(const v_int64 currentPingSessionTimestamp) {
 
   if(m_lastPingTimestamp != currentPingSessionTimestamp) {
     m_failedPings ++;
+    Metrics::increment(Metrics::FAILED_PINGS);
   }
 
-  OATPP_LOGD("Peer", "failed pings=%d", m_failedPings)
+  HELI_LOGD("Peer", "failed pings=%lld", (long long) m_failedPings);
 
-  if (m_failedPings >= m_gameSession->getConfig()->maxFailedPings) {
-    OATPP_LOGD("Peer", "maxFailedPings exceeded. PeerId=%lld. Peer dropped.", m_peerId);
+  if (m_failedPings >= m_limits->maxFailedPings) {
+    HELI_LOGD("Peer", "maxFailedPings exceeded. PeerId=%lld. Peer dropped.", (long long) m_peerId);
     invalidateSocket();
   }
 
 }
 
-oatpp::async::CoroutineStarter Peer::handlePong(const oatpp::Object<MessageDto>& message) {
+v_int64 Peer::getPingTime(const v_int64 pingSessionTimestamp) {
+  std::lock_guard<std::mutex> pingLock(m_pingMutex);
+  if(m_lastPingTimestamp != pingSessionTimestamp) {
+    return -1;
+  }
+  return m_pingTime;
+}
+
+oatpp::async::CoroutineStarter Peer::handlePong(const oatpp::Object<MessageDto>& message, v_int64 receivedTimestamp) {
 
   auto timestamp = message->payload.retrieve<oatpp::Int64>();
 
@@ -299,7 +496,15 @@ oatpp::async::CoroutineStarter Peer::handlePong(const oatpp::Object<MessageDto>&
     return sendErrorAsync(ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, "Message MUST contain 'payload.'"));
   }
 
-  v_int64 pt = m_gameSession->reportPeerPong(m_peerId, timestamp);
+  v_int64 pingTime = -1;
+  {
+    std::lock_guard<std::mutex> pingLock(m_pingMutex);
+    if(m_pingSentTimestamp >= 0) {
+      pingTime = Clock::fromSystem(receivedTimestamp) - m_pingSentTimestamp;
+    }
+  }
+
+  v_int64 pt = m_gameSession->reportPeerPong(m_peerId, timestamp, pingTime);
 
   {
     std::lock_guard<std::mutex> pingLock(m_pingMutex);
@@ -313,27 +518,24 @@ oatpp::async::CoroutineStarter Peer::handlePong(const oatpp::Object<MessageDto>&
   return nullptr;
 }
 
-oatpp::async::CoroutineStarter Peer::handleBroadcast(const oatpp::Object<MessageDto>& message) {
+oatpp::async::CoroutineStarter Peer::handleBroadcast(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
 
   auto peers = m_gameSession->getAllPeers();
+  peers.erase(std::remove_if(peers.begin(), peers.end(), [this](const std::shared_ptr<Peer>& peer) {
+    return peer->getPeerId() == m_peerId;
+  }), peers.end());
 
-  for(auto peer : peers) {
-
-    if(peer->getPeerId() != m_peerId) {
-      auto payload = OutgoingMessageDto::createShared();
-      payload->peerId = m_peerId;
-      payload->data = message->payload.retrieve<oatpp::String>();
-
-      peer->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload));
-    }
+  auto payload = OutgoingMessageDto::createShared();
+  payload->peerId = m_peerId;
+  payload->data = message->payload.retrieve<oatpp::String>();
 
-  }
+  m_gameSession->sendMessageToPeers(peers, MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload), origin);
 
   return nullptr;
 
 }
 
-oatpp::async::CoroutineStarter Peer::handleDirectMessage(const oatpp::Object<MessageDto>& message) {
+oatpp::async::CoroutineStarter Peer::handleDirectMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
 
   auto dm = message->payload.retrieve<oatpp::Object<DirectMessageDto>>();
 
@@ -346,26 +548,60 @@ oatpp::async::CoroutineStarter Peer::handleDirectMessage(const oatpp::Object<Mes
   }
 
   auto peers = m_gameSession->getPeers(dm->peerIds);
+  peers.erase(std::remove_if(peers.begin(), peers.end(), [this](const std::shared_ptr<Peer>& peer) {
+    return peer->getPeerId() == m_peerId;
+  }), peers.end());
 
-  for(auto peer : peers) {
+  auto payload = OutgoingMessageDto::createShared();
+  payload->peerId = m_peerId;
+  payload->data = dm->data;
 
-    if(peer->getPeerId() != m_peerId) {
-      auto payload = OutgoingMessageDto::createShared();
-      payload->peerId = m_peerId;
-      payload->data = dm->data;
+  m_gameSession->sendMessageToPeers(peers, MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload), origin);
 
-      peer->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload));
-    }
+  return nullptr;
 
+}
+
+oatpp::async::CoroutineStarter Peer::handleSynchronizedEvent(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
+  m_gameSession->broadcastSynchronizedEvent(m_peerId, message->payload.retrieve<oatpp::String>(), origin);
+  return nullptr;
+}
+
+oatpp::async::CoroutineStarter Peer::handleAreaOfInterest(const oatpp::Object<MessageDto>& message) {
+
+  auto cell = message->payload.retrieve<oatpp::Object<CellDto>>();
+
+  if(!cell || !cell->x || !cell->y) {
+    return sendErrorAsync(ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, "Payload MUST contain 'x' and 'y' coordinates of the cell."));
   }
 
+  m_gameSession->setPeerCell(m_peerId, cell->x, cell->y);
+
   return nullptr;
 
 }
 
-oatpp::async::CoroutineStarter Peer::handleSynchronizedEvent(const oatpp::Object<MessageDto>& message) {
-  m_gameSession->broadcastSynchronizedEvent(m_peerId, message->payload.retrieve<oatpp::String>());
+oatpp::async::CoroutineStarter Peer::handleSpatialBroadcast(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
+
+  bool found;
+  auto peers = m_gameSession->getPeersInAreaOfInterest(m_peerId, found);
+
+  if(!found) {
+    return sendErrorAsync(ErrorDto::createShared(ErrorCodes::INVALID_STATE, "Peer has to declare its area of interest before spatial broadcast."));
+  }
+
+  if(peers.empty()) {
+    return nullptr;
+  }
+
+  auto payload = OutgoingMessageDto::createShared();
+  payload->peerId = m_peerId;
+  payload->data = message->payload.retrieve<oatpp::String>();
+
+  m_gameSession->sendMessageToPeers(peers, MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload), origin);
+
   return nullptr;
+
 }
 
 oatpp::async::CoroutineStarter Peer::handleKickMessage(const oatpp::Object<MessageDto>& message) {
@@ -399,7 +635,7 @@ oatpp::async::CoroutineStarter Peer::handleKickMessage(const oatpp::Object<Messa
 
 }
 
-oatpp::async::CoroutineStarter Peer::handleClientMessage(const oatpp::Object<MessageDto>& message) {
+oatpp::async::CoroutineStarter Peer::handleClientMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
 
   auto host = m_gameSession->getHost();
   if(host == nullptr) {
@@ -414,26 +650,87 @@ oatpp::async::CoroutineStarter Peer::handleClientMessage(const oatpp::Object<Mes
   payload->peerId = m_peerId;
   payload->data = message->payload.retrieve<oatpp::String>();
 
-  host->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload));
+  host->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_MESSAGE, payload), origin);
 
   return nullptr;
 
 }
 
-oatpp::async::CoroutineStarter Peer::handleMessage(const oatpp::Object<MessageDto>& message) {
+oatpp::async::CoroutineStarter Peer::handleStateUpdate(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
+
+  if(!m_gameSession->isHostPeer(m_peerId)) {
+    return sendErrorAsync(ErrorDto::createShared(ErrorCodes::OPERATION_NOT_PERMITTED, "Only Host peer can update session state."));
+  }
+
+  auto update = message->payload.retrieve<oatpp::Object<StateUpdateDto>>();
+
+  if(!update) {
+    return sendErrorAsync(ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, "Message MUST contain 'payload.'"));
+  }
+
+  m_gameSession->updateState(update, origin);
+
+  return nullptr;
+
+}
+
+oatpp::async::CoroutineStarter Peer::handleStateAck(const oatpp::Object<MessageDto>& message) {
+
+  auto version = message->payload.retrieve<oatpp::Int64>();
+
+  if(!version) {
+    return sendErrorAsync(ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, "Message MUST contain 'payload.'"));
+  }
+
+  if(!m_gameSession->acknowledgeState(m_peerId, version)) {
+    return sendErrorAsync(ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, "Invalid state version."));
+  }
+
+  return nullptr;
+
+}
+
+void Peer::traceSpan(const char* name, const MessageOrigin& origin, v_int32 code, v_int64 start, v_int64 end) {
+  m_tracer->record({name, origin.traceId, origin.ocid, m_peerId, code, start, end - start});
+}
+
+oatpp::async::CoroutineStarter Peer::handleMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
+
+  if(origin.traceId == 0) {
+    return dispatchMessage(message, origin);
+  }
+
+  v_int64 start = oatpp::base::Environment::getMicroTickCount();
+  auto result = dispatchMessage(message, origin);
+  traceSpan("handle", origin, message->code ? static_cast<v_int32>(*message->code) : -1,
+            start, oatpp::base::Environment::getMicroTickCount());
+  return result;
+
+}
+
+oatpp::async::CoroutineStarter Peer::dispatchMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin) {
 
   if(!message->code) {
     return sendErrorAsync(ErrorDto::createShared(ErrorCodes::BAD_MESSAGE, "Message MUST contain 'code' field."));
   }
 
+  if(m_gameSession->isHandingOff()) {
+    /* session is moving to the successor - peer is about to be told to reconnect */
+    return nullptr;
+  }
+
   switch (*message->code) {
 
-    case MessageCodes::INCOMING_PONG: return handlePong(message);
-    case MessageCodes::INCOMING_BROADCAST: return handleBroadcast(message);
-    case MessageCodes::INCOMING_DIRECT_MESSAGE: return handleDirectMessage(message);
-    case MessageCodes::INCOMING_SYNCHRONIZED_EVENT: return handleSynchronizedEvent(message);
+    case MessageCodes::INCOMING_PONG: return handlePong(message, origin.receivedTimestamp);
+    case MessageCodes::INCOMING_BROADCAST: return handleBroadcast(message, origin);
+    case MessageCodes::INCOMING_DIRECT_MESSAGE: return handleDirectMessage(message, origin);
+    case MessageCodes::INCOMING_SYNCHRONIZED_EVENT: return handleSynchronizedEvent(message, origin);
+    case MessageCodes::INCOMING_AREA_OF_INTEREST: return handleAreaOfInterest(message);
+    case MessageCodes::INCOMING_SPATIAL_BROADCAST: return handleSpatialBroadcast(message, origin);
     case MessageCodes::INCOMING_HOST_KICK_CLIENTS: return handleKickMessage(message);
-    case MessageCodes::INCOMING_CLIENT_MESSAGE: return handleClientMessage(message);
+    case MessageCodes::INCOMING_CLIENT_MESSAGE: return handleClientMessage(message, origin);
+    case MessageCodes::INCOMING_HOST_STATE_UPDATE: return handleStateUpdate(message, origin);
+    case MessageCodes::INCOMING_CLIENT_STATE_ACK: return handleStateAck(message);
 
     default:
       return sendErrorAsync(ErrorDto::createShared(ErrorCodes::OPERATION_NOT_PERMITTED, "Invalid operation code."));
@@ -453,37 +750,170 @@ oatpp::async::CoroutineStarter Peer::onPong(const std::shared_ptr<AsyncWebSocket
 }
 
 oatpp::async::CoroutineStarter Peer::onClose(const std::shared_ptr<AsyncWebSocket>& socket, v_uint16 code, const oatpp::String& message) {
-  OATPP_LOGD("Peer", "onClose received.")
+  HELI_LOGD("Peer", "onClose received.");
   return nullptr; // do nothing
 }
 
+oatpp::async::CoroutineStarter Peer::handleWholeMessage(const oatpp::String& wholeMessage, v_int64 receivedTimestamp, bool relayed) {
+
+  class HandleMessageCoroutine : public oatpp::async::Coroutine<HandleMessageCoroutine> {
+  private:
+    std::shared_ptr<Peer> m_peer;
+    oatpp::Object<MessageDto> m_message;
+    MessageOrigin m_origin;
+  public:
+
+    HandleMessageCoroutine(const std::shared_ptr<Peer>& peer, const oatpp::Object<MessageDto>& message, const MessageOrigin& origin)
+      : m_peer(peer)
+      , m_message(message)
+      , m_origin(origin)
+    {}
+
+    ~HandleMessageCoroutine() {
+      /* handled or failed - free the mailbox slot */
+      m_peer->m_pendingMessages.fetch_sub(1, std::memory_order_release);
+    }
+
+    Action act() override {
+      return m_peer->handleMessage(m_message, m_origin).next(finish());
+    }
+
+  };
+
+  class MailboxWaitCoroutine : public oatpp::async::Coroutine<MailboxWaitCoroutine> {
+  private:
+    std::shared_ptr<Peer> m_peer;
+  public:
+
+    MailboxWaitCoroutine(const std::shared_ptr<Peer>& peer)
+      : m_peer(peer)
+    {}
+
+    Action act() override {
+      if(m_peer->m_pendingMessages.load(std::memory_order_acquire) < (v_int32) m_peer->m_limits->maxPendingMessages) {
+        return finish();
+      }
+      return waitRepeat(std::chrono::microseconds(MAILBOX_POLL_MICROS));
+    }
+
+  };
+
+  class ThrottleCoroutine : public oatpp::async::Coroutine<ThrottleCoroutine> {
+  private:
+    v_int64 m_delayMicros;
+  public:
+
+    ThrottleCoroutine(v_int64 delayMicros)
+      : m_delayMicros(delayMicros)
+    {}
+
+    Action act() override {
+      if(m_delayMicros > 0) {
+        auto delay = m_delayMicros;
+        m_delayMicros = 0;
+        return waitRepeat(std::chrono::microseconds(delay));
+      }
+      return finish();
+    }
+
+  };
+
+  /* rate limits are checked before parsing - over-limit messages cost nothing more than the read */
+  v_int64 throttleMicros;
+  if(!checkRateLimits(wholeMessage->size(), throttleMicros)) {
+    if(m_limits->rateLimitPolicy == RateLimitPolicy::KICK) {
+      HELI_LOGD("Peer", "Rate limit exceeded. PeerId=%lld. Peer kicked.", (long long) m_peerId);
+      Metrics::increment(Metrics::KICKS);
+      auto err = ErrorDto::createShared(ErrorCodes::RATE_LIMITED, "Fatal Error. Rate limit exceeded.");
+      return sendErrorAsync(err, true);
+    }
+    return nullptr; // message dropped
+  }
+
+  if(relayed && throttleMicros > 0) {
+    return nullptr; // relay link can't be paused for one peer - message dropped
+  }
+
+  oatpp::Object<MessageDto> message;
+
+  try {
+    message = m_objectMapper->readFromString<oatpp::Object<MessageDto>>(wholeMessage);
+  } catch (const std::runtime_error& e) {
+    Metrics::countIncoming(-1, wholeMessage->size());
+    auto err = ErrorDto::createShared(
+      ErrorCodes::BAD_MESSAGE,
+      "Fatal Error. Can't parse message.");
+    return sendErrorAsync(err, true);
+  }
+
+  v_int32 code = message->code ? static_cast<v_int32>(*message->code) : -1;
+  Metrics::countIncoming(code, wholeMessage->size());
+
+  m_gameSession->recordInbound(m_peerId, receivedTimestamp, wholeMessage);
+
+  MessageOrigin origin(receivedTimestamp, m_tracer->startTrace(message->ocid), message->ocid);
+  if(origin.traceId != 0) {
+    /* read of the last frame till parsed */
+    traceSpan("parse", origin, code, receivedTimestamp, oatpp::base::Environment::getMicroTickCount());
+  }
+
+  CoroutineStarter result;
+
+  if(message->code && *message->code == MessageCodes::INCOMING_PONG) {
+    /* pongs are handled in place - not queued behind the session's messages */
+    result = handlePong(message, receivedTimestamp);
+  } else if(relayed || m_gameSession->isExecutorAffine()) {
+    /* handle message in the session's mailbox */
+    v_int32 pending = m_pendingMessages.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if(relayed && pending > (v_int32) m_limits->maxPendingMessages) {
+      /* relay link can't be paused for one peer - message dropped */
+      m_pendingMessages.fetch_sub(1, std::memory_order_release);
+      Metrics::increment(Metrics::QUEUE_OVERFLOW_DROPS);
+      return nullptr;
+    }
+    m_executor->execute<HandleMessageCoroutine>(shared_from_this(), message, origin);
+    if(!relayed && pending >= (v_int32) m_limits->maxPendingMessages) {
+      /* mailbox is full - the next message is not read until the session catches up */
+      result = MailboxWaitCoroutine::start(shared_from_this());
+    }
+  } else {
+    result = handleMessage(message, origin);
+  }
+
+  if(throttleMicros > 0) {
+    /* the next message is not read until the peer is out of the rate limit debt */
+    result.next(ThrottleCoroutine::start(throttleMicros));
+  }
+
+  return result;
+
+}
+
+void Peer::handleRelayedMessage(const oatpp::String& data) {
+  if(data) {
+    handleWholeMessage(data, oatpp::base::Environment::getMicroTickCount(), true);
+  }
+}
+
 oatpp::async::CoroutineStarter Peer::readMessage(const std::shared_ptr<AsyncWebSocket>& socket, v_uint8 opcode, p_char8 data, oatpp::v_io_size size) {
 
-  if(m_messageBuffer.getCurrentPosition() + size >  m_gameSession->getConfig()->maxMessageSizeBytes) {
+  if(m_messageBuffer.getCurrentPosition() + size >  m_limits->maxMessageSizeBytes) {
     auto err = ErrorDto::createShared(
       ErrorCodes::BAD_MESSAGE,
       "Fatal Error. Serialized message size shouldn't exceed " +
-      oatpp::utils::conversion::int64ToStdStr(m_gameSession->getConfig()->maxMessageSizeBytes) + " bytes.");
+      oatpp::utils::conversion::int64ToStdStr(m_limits->maxMessageSizeBytes) + " bytes.");
     return sendErrorAsync(err, true);
   }
 
   if(size == 0) { // message transfer finished
 
+    /* taken before any processing - pong RTT doesn't include our own backlog */
+    v_int64 receivedTimestamp = oatpp::base::Environment::getMicroTickCount();
+
     auto wholeMessage = m_messageBuffer.toString();
     m_messageBuffer.setCurrentPosition(0);
 
-    oatpp::Object<MessageDto> message;
-
-    try {
-      message = m_objectMapper->readFromString<oatpp::Object<MessageDto>>(wholeMessage);
-    } catch (const std::runtime_error& e) {
-      auto err = ErrorDto::createShared(
-        ErrorCodes::BAD_MESSAGE,
-        "Fatal Error. Can't parse message.");
-      return sendErrorAsync(err, true);
-    }
-
-    return handleMessage(message);
+    return handleWholeMessage(wholeMessage, receivedTimestamp, false);
 
   } else if(size > 0) { // message frame received
     m_messageBuffer.writeSimple(data, size);
@@ -491,4 +921,4 @@ oatpp::async::CoroutineStarter Peer::readMessage(const std::shared_ptr<AsyncWebS
 
   return nullptr; // do nothing
 
-}
\ No newline at end of file
+}
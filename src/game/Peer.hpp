@@ -31,9 +31,15 @@
 
 #include "config/Config.hpp"
 #include "config/GamesConfig.hpp"
+#include "config/GameLimits.hpp"
 
 #include "dto/DTOs.hpp"
 
+#include "cluster/RelayLink.hpp"
+
+#include "utils/TokenBucket.hpp"
+#include "utils/Tracer.hpp"
+
 #include "oatpp-websocket/AsyncWebSocket.hpp"
 
 #include "oatpp/network/ConnectionProvider.hpp"
@@ -45,11 +51,51 @@
 
 class Session; // FWD
 
-class Peer : public oatpp::websocket::AsyncWebSocket::Listener {
+/**
+ * Inbound message outgoing messages are sent for.
+ * Carried with queued messages for latency metrics and tracing.
+ */
+struct MessageOrigin {
+
+  /**
+   * When the inbound message was read. `-1` - message originates on server.
+   */
+  v_int64 receivedTimestamp;
+
+  /**
+   * Trace ID. `0` - message is not traced.
+   */
+  v_int64 traceId;
+
+  /**
+   * Operation correlation ID of the inbound message.
+   */
+  oatpp::String ocid;
+
+  MessageOrigin()
+    : receivedTimestamp(-1)
+    , traceId(0)
+  {}
+
+  MessageOrigin(v_int64 pReceivedTimestamp, v_int64 pTraceId, const oatpp::String& pOcid)
+    : receivedTimestamp(pReceivedTimestamp)
+    , traceId(pTraceId)
+    , ocid(pOcid)
+  {}
+
+};
+
+class Peer : public oatpp::websocket::AsyncWebSocket::Listener, public std::enable_shared_from_this<Peer> {
 private:
 
+  struct QueuedMessage {
+    oatpp::Object<MessageDto> message;
+    MessageOrigin origin;
+    v_int64 queuedTimestamp;
+  };
+
   struct MessageQueue {
-    std::list<oatpp::Object<MessageDto>> queue;
+    std::list<QueuedMessage> queue;
     std::mutex mutex;
     bool active = false;
   };
@@ -70,34 +116,111 @@ private:
   std::shared_ptr<AsyncWebSocket> m_socket;
   std::mutex m_socketMutex;
   std::shared_ptr<Session> m_gameSession;
+  const GameLimits* m_limits; // owned by m_gameSession
+  std::shared_ptr<oatpp::async::Executor> m_executor; // executor of the game session
   v_int64 m_peerId;
   std::shared_ptr<MessageQueue> m_messageQueue;
+private:
+  /* remote peer - connected to other node, messages go through the relay link */
+  std::shared_ptr<RelayLink> m_relayLink;
+  v_int64 m_relayRef;
 private:
   v_int64 m_pingTime;
   v_int64 m_failedPings;
   v_int64 m_lastPingTimestamp;
+  v_int64 m_pingSentTimestamp; // when the latest ping frame was written to the socket
   std::mutex m_pingMutex;
 private:
+  /* inbound rate limits - accessed from readMessage only */
+  TokenBucket m_messagesBucket;
+  TokenBucket m_bytesBucket;
+  bool m_limitMessages;
+  bool m_limitBytes;
+private:
+  /* inbound messages posted to the session's executor and not yet handled */
+  std::atomic<v_int32> m_pendingMessages;
+private:
 
   /* Inject application components */
-  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, m_asyncExecutor);
   OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, m_objectMapper, Constants::COMPONENT_WS_API);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, m_controlExecutor, Constants::COMPONENT_CONTROL);
+  OATPP_COMPONENT(std::shared_ptr<Tracer>, m_tracer);
 
 private:
 
-  CoroutineStarter handlePong(const oatpp::Object<MessageDto>& message);
-  CoroutineStarter handleBroadcast(const oatpp::Object<MessageDto>& message);
-  CoroutineStarter handleDirectMessage(const oatpp::Object<MessageDto>& message);
-  CoroutineStarter handleSynchronizedEvent(const oatpp::Object<MessageDto>& message);
+  static TokenBucket createRateLimit(v_float64 rate, v_float64 minCapacity, const GameLimits& limits);
+
+  /**
+   * Serialize outgoing message and count it in metrics.
+   * @param message
+   * @return
+   */
+  oatpp::String serializeMessage(const oatpp::Object<MessageDto>& message);
+
+  /**
+   * Charge message to the peer's rate limits.
+   * @param messageSize
+   * @param throttleMicros - for how long to defer the next read. Throttle policy only.
+   * @return - `false` if message exceeds rate limits and has to be dropped (or peer kicked).
+   */
+  bool checkRateLimits(v_buff_size messageSize, v_int64& throttleMicros);
+
+private:
+
+  CoroutineStarter handlePong(const oatpp::Object<MessageDto>& message, v_int64 receivedTimestamp);
+  CoroutineStarter handleBroadcast(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+  CoroutineStarter handleDirectMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+  CoroutineStarter handleSynchronizedEvent(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+  CoroutineStarter handleAreaOfInterest(const oatpp::Object<MessageDto>& message);
+  CoroutineStarter handleSpatialBroadcast(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
   CoroutineStarter handleKickMessage(const oatpp::Object<MessageDto>& message);
-  CoroutineStarter handleClientMessage(const oatpp::Object<MessageDto>& message);
-  CoroutineStarter handleMessage(const oatpp::Object<MessageDto>& message);
+  CoroutineStarter handleClientMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+  CoroutineStarter handleStateUpdate(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+  CoroutineStarter handleStateAck(const oatpp::Object<MessageDto>& message);
+  CoroutineStarter dispatchMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+
+  /**
+   * Handle parsed message. Records "handle" span if message is traced.
+   * @param message
+   * @param origin
+   * @return
+   */
+  CoroutineStarter handleMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin);
+
+  /**
+   * Record span of the traced message.
+   * @param name
+   * @param origin
+   * @param code
+   * @param start - timestamp in microseconds.
+   * @param end - timestamp in microseconds.
+   */
+  void traceSpan(const char* name, const MessageOrigin& origin, v_int32 code, v_int64 start, v_int64 end);
+
+  /**
+   * Check rate limits, parse and dispatch the whole message. Called sequentially for the peer.
+   * @param wholeMessage
+   * @param receivedTimestamp - when the message was read.
+   * @param relayed - message was received through the relay link.
+   * @return
+   */
+  CoroutineStarter handleWholeMessage(const oatpp::String& wholeMessage, v_int64 receivedTimestamp, bool relayed);
 
 public:
 
+  /**
+   * Constructor.
+   * @param socket - peer's socket. `nullptr` for remote peer.
+   * @param gameSession
+   * @param peerId
+   * @param relayLink - remote peer only. Link to the node the peer is connected to.
+   * @param relayRef - remote peer only. ID of the peer connection on that node.
+   */
   Peer(const std::shared_ptr<AsyncWebSocket>& socket,
        const std::shared_ptr<Session>& gameSession,
-       v_int64 peerId);
+       v_int64 peerId,
+       const std::shared_ptr<RelayLink>& relayLink = nullptr,
+       v_int64 relayRef = -1);
 
   /**
    * Send message to peer.
@@ -115,9 +238,10 @@ public:
   /**
    * Queue message to send to peer.
    * @param message
+   * @param origin - inbound message this message is sent for. Default - message originates on server.
    * @return
    */
-  bool queueMessage(const oatpp::Object<MessageDto>& message);
+  bool queueMessage(const oatpp::Object<MessageDto>& message, const MessageOrigin& origin = MessageOrigin());
 
   /**
    * Ping peer.
@@ -129,12 +253,37 @@ public:
    */
   void kick();
 
+  /**
+   * Send the last message to peer and close the connection.
+   * @param message
+   */
+  void disconnect(const oatpp::Object<MessageDto>& message);
+
+  /**
+   * Handoff. Take messages queued for peer and not sent yet.
+   * @return - messages in order of sending.
+   */
+  std::vector<oatpp::Object<MessageDto>> takeQueuedMessages();
+
+  /**
+   * Get number of messages queued for peer and not sent yet.
+   * @return
+   */
+  v_int64 getQueuedMessagesCount();
+
   /**
    * Check ping rules.
    * @param currentPingSessionTimestamp
    */
   void checkPingsRules(const v_int64 currentPingSessionTimestamp);
 
+  /**
+   * Get peer's ping measured in the given ping session.
+   * @param pingSessionTimestamp
+   * @return - ping in microseconds or `-1` if peer didn't respond to this ping.
+   */
+  v_int64 getPingTime(const v_int64 pingSessionTimestamp);
+
   /**
    * Get the game session the peer associated with.
    * @return
@@ -152,6 +301,24 @@ public:
    */
   void invalidateSocket();
 
+  /**
+   * Get relay link of the remote peer.
+   * @return - link or `nullptr` if peer is connected to this node.
+   */
+  std::shared_ptr<RelayLink> getRelayLink();
+
+  /**
+   * Get ID of the remote peer's connection on the node it's connected to.
+   * @return
+   */
+  v_int64 getRelayRef();
+
+  /**
+   * Handle message of the remote peer received through the relay link.
+   * @param data - message as sent by peer.
+   */
+  void handleRelayedMessage(const oatpp::String& data);
+
 public: // WebSocket Listener methods
 
   CoroutineStarter onPing(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& message) override;
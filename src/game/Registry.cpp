@@ -26,21 +26,39 @@
 
 #include "Registry.hpp"
 
+#include "utils/AsyncLogger.hpp"
+
 #include "Constants.hpp"
 
-Registry::Registry()
-{}
+#include "oatpp/core/utils/ConversionUtils.hpp"
 
-void Registry::sendSocketErrorAsync(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::Object<ErrorDto>& error, bool fatal) {
+Registry::Registry(const std::shared_ptr<oatpp::async::Executor>& executor,
+                   const std::shared_ptr<ExecutorPool>& sessionExecutors)
+  : m_asyncExecutor(executor)
+  , m_sessionExecutors(sessionExecutors)
+{
+  m_rateLimitedFrame = serializeError(ErrorDto::createShared(ErrorCodes::RATE_LIMITED, "Too many connections from this address."));
+  m_serverBusyFrame = serializeError(ErrorDto::createShared(ErrorCodes::SERVER_BUSY, "Server reached the maximum number of peers."));
+  m_sessionFullFrame = serializeError(ErrorDto::createShared(ErrorCodes::SESSION_FULL, "Game session reached the maximum number of peers."));
+}
+
+oatpp::String Registry::serializeError(const oatpp::Object<ErrorDto>& error) {
+  auto message = MessageDto::createShared();
+  message->code = MessageCodes::OUTGOING_ERROR;
+  message->payload = error;
+  return m_objectMapper->writeToString(message);
+}
 
-  class SendErrorCoroutine : public oatpp::async::Coroutine<SendErrorCoroutine> {
+void Registry::sendSocketFrameAsync(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& frame, bool fatal) {
+
+  class SendFrameCoroutine : public oatpp::async::Coroutine<SendFrameCoroutine> {
   private:
     std::shared_ptr<AsyncWebSocket> m_websocket;
     oatpp::String m_message;
     bool m_fatal;
   public:
 
-    SendErrorCoroutine(const std::shared_ptr<AsyncWebSocket>& websocket,
+    SendFrameCoroutine(const std::shared_ptr<AsyncWebSocket>& websocket,
                        const oatpp::String& message,
                        bool fatal)
             : m_websocket(websocket)
@@ -63,12 +81,12 @@ void Registry::sendSocketErrorAsync(const std::shared_ptr<AsyncWebSocket>& socke
 
   };
 
-  auto message = MessageDto::createShared();
-  message->code = MessageCodes::OUTGOING_ERROR;
-  message->payload = error;
+  m_asyncExecutor->execute<SendFrameCoroutine>(socket, frame, fatal);
 
-  m_asyncExecutor->execute<SendErrorCoroutine>(socket, m_objectMapper->writeToString(message), fatal);
+}
 
+void Registry::sendSocketErrorAsync(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::Object<ErrorDto>& error, bool fatal) {
+  sendSocketFrameAsync(socket, serializeError(error), fatal);
 }
 
 oatpp::String Registry::getRequiredParameter(const oatpp::String& name, const std::shared_ptr<const ParameterMap>& params, SessionInfo& sessionInfo) {
@@ -96,9 +114,47 @@ Registry::SessionInfo Registry::getSessionForPeer(
   auto peerType = getRequiredParameter(Constants::PARAM_PEER_TYPE, params, result);
   if(result.error) return result;
 
+  auto resumeTokenIt = params->find(Constants::PARAM_RESUME_TOKEN);
+  if(resumeTokenIt != params->end() && resumeTokenIt->second) {
+
+    /* peer reconnects after the session was handed off to this process */
+    auto peerIdStr = getRequiredParameter(Constants::PARAM_PEER_ID, params, result);
+    if(result.error) return result;
+
+    bool success;
+    auto peerId = oatpp::utils::conversion::strToInt64(peerIdStr, success);
+
+    auto game = getSessionOwnerGame(gameId, sessionId);
+    if(success && game) {
+      result.session = game->findSession(sessionId);
+    }
+    if(result.session) {
+      result.reservation = result.session->claimReservation(peerId, resumeTokenIt->second);
+    }
+    if(!result.reservation) {
+      result.session = nullptr;
+      result.error = ErrorDto::createShared(ErrorCodes::SESSION_NOT_FOUND, "No reserved peer found for given peerId and resumeToken.");
+      return result;
+    }
+
+    result.isHost = result.reservation->isHost;
+    return result;
+
+  }
+
   result.isHost = peerType == Constants::PARAM_PEER_TYPE_HOST;
 
-  auto game = getGameById(gameId);
+  if(result.isHost && m_admission->isDraining()) {
+    result.error = ErrorDto::createShared(ErrorCodes::SERVER_DRAINING, "Server is draining. Can't create new session.");
+    return result;
+  }
+
+  if(result.isHost && m_admission->isOverloaded()) {
+    result.error = ErrorDto::createShared(ErrorCodes::SERVER_BUSY, "Server is overloaded. Can't create new session.");
+    return result;
+  }
+
+  auto game = getSessionOwnerGame(gameId, sessionId);
   if(!game) {
     result.error = ErrorDto::createShared(ErrorCodes::GAME_NOT_FOUND, "Game config not found. Game config should be present on the server.");
     return result;
@@ -133,7 +189,7 @@ std::shared_ptr<Game> Registry::getGameById(const oatpp::String& gameId) {
 
   auto config = m_gameConfig->getGameConfig(gameId);
   if(config) {
-    auto game = std::make_shared<Game>(config);
+    auto game = std::make_shared<Game>(config, m_sessionExecutors);
     m_games.insert({config->gameId, game});
     return game;
   }
@@ -142,50 +198,249 @@ std::shared_ptr<Game> Registry::getGameById(const oatpp::String& gameId) {
 
 }
 
+std::shared_ptr<Game> Registry::getSessionOwnerGame(const oatpp::String& gameId, const oatpp::String& sessionId) {
+
+  if(!m_shards.empty()) {
+    auto hash = std::hash<oatpp::String>{}(gameId + "/" + sessionId);
+    auto owner = m_shards[hash % m_shards.size()].lock();
+    if(owner && owner.get() != this) {
+      return owner->getGameById(gameId);
+    }
+  }
+
+  return getGameById(gameId);
+
+}
+
+std::vector<std::shared_ptr<Session>> Registry::getAllSessions() {
+
+  std::vector<std::shared_ptr<Game>> games;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto& pair : m_games) {
+      games.emplace_back(pair.second);
+    }
+  }
+
+  std::vector<std::shared_ptr<Session>> result;
+  for(auto& game : games) {
+    auto sessions = game->getAllSessions();
+    result.insert(result.end(), sessions.begin(), sessions.end());
+  }
+  return result;
+
+}
+
+bool Registry::restoreSession(const oatpp::Object<SessionSnapshotDto>& snapshot, v_int64 resumeDeadline) {
+
+  if(!snapshot || !snapshot->gameId || !snapshot->sessionId) {
+    return false;
+  }
+
+  auto game = getSessionOwnerGame(snapshot->gameId, snapshot->sessionId);
+  if(!game) {
+    HELI_LOGW("Registry", "Handoff - game config not found for '%s'. Session dropped.", snapshot->gameId->c_str());
+    return false;
+  }
+
+  if(!game->restoreSession(snapshot, resumeDeadline)) {
+    HELI_LOGW("Registry", "Handoff - session '%s' already exists. Session dropped.", snapshot->sessionId->c_str());
+    return false;
+  }
+
+  return true;
+
+}
+
+void Registry::setShards(const std::vector<std::weak_ptr<Registry>>& shards) {
+  m_shards = shards;
+}
+
+bool Registry::tryRelayPeer(const std::shared_ptr<AsyncWebSocket>& socket, const std::shared_ptr<const ParameterMap>& params) {
+
+  if(!m_relay->isEnabled()) {
+    return false;
+  }
+
+  auto gameIt = params->find(Constants::PARAM_GAME_ID);
+  auto sessionIt = params->find(Constants::PARAM_GAME_SESSION_ID);
+  auto peerTypeIt = params->find(Constants::PARAM_PEER_TYPE);
+  if(gameIt == params->end() || sessionIt == params->end() || peerTypeIt == params->end()) {
+    return false;
+  }
+
+  auto owner = m_cluster->getRemoteSessionOwner(gameIt->second, sessionIt->second);
+  if(!owner) {
+    return false;
+  }
+
+  auto gameConfig = m_gameConfig->getGameConfig(gameIt->second);
+  if(!gameConfig) {
+    return false;
+  }
+
+  oatpp::String address;
+  auto addressIt = params->find(Constants::PARAM_PEER_ADDRESS);
+  if(addressIt != params->end()) {
+    address = addressIt->second;
+  }
+
+  m_relay->attachPeer(socket, owner, gameIt->second, sessionIt->second,
+                      peerTypeIt->second == Constants::PARAM_PEER_TYPE_HOST,
+                      address,
+                      gameConfig->maxMessageSizeBytes);
+
+  return true;
+
+}
+
+std::shared_ptr<Peer> Registry::addRemotePeer(const std::shared_ptr<RelayLink>& link,
+                                              v_int64 ref,
+                                              const oatpp::String& gameId,
+                                              const oatpp::String& sessionId,
+                                              bool isHost,
+                                              const oatpp::String& address)
+{
+
+  if(!m_admission->checkConnectRate(address)) {
+    link->deliver(ref, m_rateLimitedFrame);
+    link->closePeer(ref);
+    return nullptr;
+  }
+
+  if(!m_admission->tryAcquirePeerSlot()) {
+    link->deliver(ref, m_serverBusyFrame);
+    link->closePeer(ref);
+    return nullptr;
+  }
+
+  auto params = std::make_shared<ParameterMap>();
+  (*params)[Constants::PARAM_GAME_ID] = gameId;
+  (*params)[Constants::PARAM_GAME_SESSION_ID] = sessionId;
+  (*params)[Constants::PARAM_PEER_TYPE] = isHost ? Constants::PARAM_PEER_TYPE_HOST : Constants::PARAM_PEER_TYPE_CLIENT;
+
+  auto sessionInfo = getSessionForPeer(nullptr, params);
+
+  if(sessionInfo.error) {
+    m_admission->releasePeerSlot();
+    link->deliver(ref, serializeError(sessionInfo.error));
+    link->closePeer(ref);
+    return nullptr;
+  }
+
+  if(!sessionInfo.session->tryAcquirePeerSlot()) {
+    m_admission->releasePeerSlot();
+    link->deliver(ref, m_sessionFullFrame);
+    link->closePeer(ref);
+    return nullptr;
+  }
+
+  auto peer = std::make_shared<Peer>(
+    nullptr,
+    sessionInfo.session,
+    sessionInfo.session->generateNewPeerId(),
+    link,
+    ref
+  );
+
+  HELI_LOGD("Registry", "remote peer created. Node='%s', ref=%lld", link->getNodeId()->c_str(), (long long) ref);
+
+  sessionInfo.session->addPeer(peer, sessionInfo.isHost);
+
+  return peer;
+
+}
+
+void Registry::removeRemotePeer(const std::shared_ptr<Peer>& peer) {
+  removePeer(peer);
+  m_admission->releasePeerSlot();
+}
+
+void Registry::removePeer(const std::shared_ptr<Peer>& peer) {
+
+  peer->invalidateSocket();
+
+  auto session = peer->getGameSession();
+
+  bool isEmptySession;
+  session->removePeerById(peer->getPeerId(), isEmptySession);
+  session->releasePeerSlot();
+
+  if (isEmptySession) {
+    auto game = getSessionOwnerGame(session->getConfig()->gameId, session->getId());
+    game->deleteSession(session->getId());
+    HELI_LOGD("Registry", "Session deleted - %p", (void*) session.get());
+  }
+
+}
+
 void Registry::onAfterCreate_NonBlocking(const std::shared_ptr<AsyncWebSocket>& socket, const std::shared_ptr<const ParameterMap>& params) {
 
-  OATPP_LOGD("Registry", "socket created - %d", socket.get())
+  HELI_LOGD("Registry", "socket created - %p", (void*) socket.get());
+
+  /* connect rate and server capacity are pre-checked by controllers before the handshake.
+   * Slot is reserved here - concurrent handshakes may pass the pre-check together */
+
+  if(!m_admission->tryAcquirePeerSlot()) {
+    sendSocketFrameAsync(socket, m_serverBusyFrame, true);
+    return;
+  }
+
+  /* cluster mode - session is owned by other node */
+  if(tryRelayPeer(socket, params)) {
+    return;
+  }
 
   auto sessionInfo = getSessionForPeer(socket, params);
 
   if(sessionInfo.error) {
+    m_admission->releasePeerSlot();
     sendSocketErrorAsync(socket, sessionInfo.error, true);
     return;
   }
 
+  /* claimed reservation already holds a session slot */
+  if(!sessionInfo.reservation && !sessionInfo.session->tryAcquirePeerSlot()) {
+    m_admission->releasePeerSlot();
+    sendSocketFrameAsync(socket, m_sessionFullFrame, true);
+    return;
+  }
+
   auto peer = std::make_shared<Peer>(
     socket,
     sessionInfo.session,
-    sessionInfo.session->generateNewPeerId()
+    sessionInfo.reservation ? *sessionInfo.reservation->peerId : sessionInfo.session->generateNewPeerId()
   );
 
   socket->setListener(peer);
 
-  OATPP_LOGD("Registry", "peer created for socket - %d", socket.get())
+  HELI_LOGD("Registry", "peer created for socket - %p", (void*) socket.get());
 
-  sessionInfo.session->addPeer(peer, sessionInfo.isHost);
+  if(sessionInfo.reservation) {
+    sessionInfo.session->resumePeer(peer, sessionInfo.reservation);
+  } else {
+    sessionInfo.session->addPeer(peer, sessionInfo.isHost);
+  }
 
 }
 
 void Registry::onBeforeDestroy_NonBlocking(const std::shared_ptr<AsyncWebSocket>& socket) {
 
-  OATPP_LOGD("Registry", "destroying socket - %d", socket.get())
-
-  auto peer = std::static_pointer_cast<Peer>(socket->getListener());
-  if(peer) {
-    peer->invalidateSocket();
-
-    auto session = peer->getGameSession();
+  HELI_LOGD("Registry", "destroying socket - %p", (void*) socket.get());
 
-    bool isEmptySession;
-    session->removePeerById(peer->getPeerId(), isEmptySession);
+  auto listener = socket->getListener();
 
-    if (isEmptySession) {
-      auto game = getGameById(session->getConfig()->gameId);
-      game->deleteSession(session->getId());
-      OATPP_LOGD("Registry", "Session deleted - %d", session.get())
-    }
+  auto relayedPeer = std::dynamic_pointer_cast<RelayedPeer>(listener);
+  if(relayedPeer) {
+    m_relay->detachPeer(relayedPeer);
+    m_admission->releasePeerSlot();
+    return;
+  }
 
+  auto peer = std::dynamic_pointer_cast<Peer>(listener);
+  if(peer) {
+    removePeer(peer);
+    m_admission->releasePeerSlot();
   } else {
     socket->getConnection().invalidate();
   }
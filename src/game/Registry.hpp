@@ -28,6 +28,9 @@
 #define Helicopter_game_Registry_hpp
 
 #include "./Game.hpp"
+#include "./AdmissionControl.hpp"
+
+#include "cluster/Relay.hpp"
 
 #include "oatpp-websocket/AsyncConnectionHandler.hpp"
 
@@ -42,25 +45,56 @@ private:
     std::shared_ptr<Session> session;
     oatpp::Object<ErrorDto> error;
     bool isHost;
+    oatpp::Object<PeerSnapshotDto> reservation; // peer resumes after handoff
   };
 
 private:
   std::unordered_map<oatpp::String, std::shared_ptr<Game>> m_games;
   std::mutex m_mutex;
+private:
+  std::shared_ptr<oatpp::async::Executor> m_asyncExecutor;
+  std::shared_ptr<ExecutorPool> m_sessionExecutors;
+  std::vector<std::weak_ptr<Registry>> m_shards;
 private:
   /* Inject application components */
   OATPP_COMPONENT(oatpp::Object<ConfigDto>, m_config);
   OATPP_COMPONENT(std::shared_ptr<GamesConfig>, m_gameConfig);
-  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, m_asyncExecutor);
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, m_admission);
+  OATPP_COMPONENT(std::shared_ptr<Cluster>, m_cluster);
+  OATPP_COMPONENT(std::shared_ptr<Relay>, m_relay);
   OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, m_objectMapper, Constants::COMPONENT_WS_API);
+private:
+  /* precomputed error frames to reject connections cheaply */
+  oatpp::String m_rateLimitedFrame;
+  oatpp::String m_serverBusyFrame;
+  oatpp::String m_sessionFullFrame;
 private:
   oatpp::String getRequiredParameter(const oatpp::String& name, const std::shared_ptr<const ParameterMap>& params, SessionInfo& sessionInfo);
 private:
+  oatpp::String serializeError(const oatpp::Object<ErrorDto>& error);
+  void sendSocketFrameAsync(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::String& frame, bool fatal);
   void sendSocketErrorAsync(const std::shared_ptr<AsyncWebSocket>& socket, const oatpp::Object<ErrorDto>& error, bool fatal = false);
   SessionInfo getSessionForPeer(const std::shared_ptr<AsyncWebSocket>& socket, const std::shared_ptr<const ParameterMap>& params);
+  std::shared_ptr<Game> getSessionOwnerGame(const oatpp::String& gameId, const oatpp::String& sessionId);
+  bool tryRelayPeer(const std::shared_ptr<AsyncWebSocket>& socket, const std::shared_ptr<const ParameterMap>& params);
+  void removePeer(const std::shared_ptr<Peer>& peer);
 public:
 
-  Registry();
+  /**
+   * Constructor.
+   * @param executor - executor for connection-level coroutines.
+   * @param sessionExecutors - executors to pin game sessions to.
+   */
+  Registry(const std::shared_ptr<oatpp::async::Executor>& executor,
+           const std::shared_ptr<ExecutorPool>& sessionExecutors);
+
+  /**
+   * Sharded mode.
+   * Set registries of all shards. Each game session is owned by the shard chosen by hash of the session ID -
+   * peers accepted by other shards join the session in the owner shard.
+   * @param shards
+   */
+  void setShards(const std::vector<std::weak_ptr<Registry>>& shards);
 
   /**
    * Get all sessions of the game.
@@ -69,6 +103,44 @@ public:
    */
   std::shared_ptr<Game> getGameById(const oatpp::String& gameId);
 
+  /**
+   * Cluster relay. Add peer connected to other node to the session owned by this node.
+   * @param link - link to the node the peer is connected to.
+   * @param ref - ID of the peer connection on that node.
+   * @param gameId
+   * @param sessionId
+   * @param isHost
+   * @param address - peer's address as seen by the edge node. Checked against connect rate of this node.
+   * @return - remote peer or `nullptr` if peer can't join. Error is sent to the peer.
+   * Remote peer holds a peer slot of this node's admission control until it's removed.
+   */
+  std::shared_ptr<Peer> addRemotePeer(const std::shared_ptr<RelayLink>& link,
+                                      v_int64 ref,
+                                      const oatpp::String& gameId,
+                                      const oatpp::String& sessionId,
+                                      bool isHost,
+                                      const oatpp::String& address);
+
+  /**
+   * Cluster relay. Remove remote peer - it disconnected from other node or the link is closed.
+   * @param peer
+   */
+  void removeRemotePeer(const std::shared_ptr<Peer>& peer);
+
+  /**
+   * Get all game sessions owned by this registry.
+   * @return
+   */
+  std::vector<std::shared_ptr<Session>> getAllSessions();
+
+  /**
+   * Handoff. Restore session exported by the predecessor process.
+   * @param snapshot
+   * @param resumeDeadline - timestamp in microseconds after which peers which didn't reconnect are dropped.
+   * @return - `false` if game is not found or session already exists.
+   */
+  bool restoreSession(const oatpp::Object<SessionSnapshotDto>& snapshot, v_int64 resumeDeadline);
+
 public:
 
   /**
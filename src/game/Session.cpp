@@ -26,27 +26,80 @@
 
 #include "Session.hpp"
 
+#include "utils/AsyncLogger.hpp"
+#include "utils/Clock.hpp"
+#include "utils/Metrics.hpp"
+
 #include "oatpp/core/utils/ConversionUtils.hpp"
 
-Session::Session(const oatpp::String& id, const oatpp::Object<GameConfigDto>& config)
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <cstdio>
+
+Session::Session(const oatpp::String& id,
+                 const oatpp::Object<GameConfigDto>& config,
+                 const std::shared_ptr<ExecutorPool>& executors)
   : m_id(id)
   , m_config(config)
+  , m_limits(GameLimits::compile(config))
+  , m_executors(executors)
+  , m_executorIndex(executors->acquire(config->gameId + "/" + id))
+  , m_executor(executors->getExecutor(m_executorIndex))
   , m_peerIdCounter(0)
+  , m_peerSlots(0)
   , m_synchronizedEventId(0)
+  , m_roster(std::make_shared<Roster>())
+  , m_handingOff(false)
+  , m_reservationsDeadline(0)
   , m_pingCurrentTimestamp(-1)
   , m_pingBestTime(-1)
+  , m_pingRoundBestPeerId(-1)
   , m_pingBestPeerId(-1)
   , m_pingBestPeerSinceTimestamp(-1)
+  , m_recording(config->record ? m_recorder->startRecording(config->gameId, id) : nullptr)
 {}
 
+Session::~Session() {
+  if(m_recording) {
+    m_recording->close();
+  }
+  m_executors->release(m_executorIndex);
+}
+
 oatpp::String Session::getId() {
   return m_id;
 }
 
+std::shared_ptr<oatpp::async::Executor> Session::getExecutor() {
+  return m_executor;
+}
+
+bool Session::isExecutorAffine() {
+  return m_executors->isAffine();
+}
+
 oatpp::Object<GameConfigDto> Session::getConfig() {
   return m_config;
 }
 
+const GameLimits& Session::getLimits() const {
+  return m_limits;
+}
+
+bool Session::tryAcquirePeerSlot() {
+  v_int64 maxPeers = m_limits.maxPeers;
+  if(m_peerSlots.fetch_add(1, std::memory_order_relaxed) >= maxPeers) {
+    m_peerSlots.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void Session::releasePeerSlot() {
+  m_peerSlots.fetch_sub(1, std::memory_order_relaxed);
+}
+
 void Session::addPeer(const std::shared_ptr<Peer>& peer, bool isHost) {
 
   {
@@ -54,10 +107,10 @@ void Session::addPeer(const std::shared_ptr<Peer>& peer, bool isHost) {
     m_peers.insert({peer->getPeerId(), peer});
     if (isHost) {
       m_host = peer;
-    } else {
-      if(m_host) {
-        m_host->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_HOST_CLIENT_JOINED, oatpp::Int64(peer->getPeerId())));
-      }
+    }
+    publishRoster();
+    if(!isHost && m_host) {
+      m_host->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_HOST_CLIENT_JOINED, oatpp::Int64(peer->getPeerId())));
     }
   }
 
@@ -67,39 +120,176 @@ void Session::addPeer(const std::shared_ptr<Peer>& peer, bool isHost) {
 
   peer->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_HELLO, hello));
 
+  if(!isHost) {
+    /* late joiner gets the current snapshot straight from the server */
+    m_stateStore.addClient(peer->getPeerId());
+    auto snapshot = m_stateStore.getDelta(0);
+    if(snapshot) {
+      peer->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_CLIENT_STATE_DELTA, snapshot));
+    }
+  }
+
+}
+
+std::shared_ptr<const Session::Roster> Session::getRoster() {
+  return std::atomic_load(&m_roster);
+}
+
+void Session::publishRoster() {
+  auto roster = std::make_shared<Roster>();
+  roster->host = m_host;
+  roster->peers = m_peers;
+  std::atomic_store(&m_roster, std::shared_ptr<const Roster>(roster));
 }
 
 void Session::setHost(const std::shared_ptr<Peer>& peer){
   std::lock_guard<std::mutex> lock(m_peersMutex);
   m_host = peer;
+  publishRoster();
 }
 
 std::shared_ptr<Peer> Session::getHost() {
-  std::lock_guard<std::mutex> lock(m_peersMutex);
-  return m_host;
+  return getRoster()->host;
 }
 
 bool Session::isHostPeer(v_int64 peerId) {
-  std::lock_guard<std::mutex> lock(m_peersMutex);
-  return m_host && m_host->getPeerId() == peerId;
+  auto roster = getRoster();
+  return roster->host && roster->host->getPeerId() == peerId;
 }
 
 void Session::removePeerById(v_int64 peerId, bool& isEmpty) {
   std::lock_guard<std::mutex> lock(m_peersMutex);
+  bool isHostLeft = false;
   if(m_host && m_host->getPeerId() == peerId) {
     m_host.reset();
+    isHostLeft = true;
   }
+  removePeerFromGrid(peerId);
+  m_stateStore.removeClient(peerId);
   m_peers.erase(peerId);
-  isEmpty = m_peers.empty();
-  if(m_host) {
+  publishRoster();
+  isEmpty = m_peers.empty() && m_reservations.empty();
+  if(isHostLeft) {
+    if(!m_peers.empty() && !m_limits.staticHost && !m_handingOff) {
+      promoteHost(chooseNewHost());
+    }
+  } else if(m_host) {
     m_host->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_HOST_CLIENT_LEFT, oatpp::Int64(peerId)));
   }
 }
 
+std::shared_ptr<Peer> Session::chooseNewHost() {
+
+  v_int64 candidates[2];
+  {
+    std::lock_guard<std::mutex> lock(m_pingMutex);
+    candidates[0] = m_pingBestPeerId;
+    candidates[1] = m_pingRoundBestPeerId;
+  }
+
+  for(v_int64 candidateId : candidates) {
+    auto it = m_peers.find(candidateId);
+    if(it != m_peers.end()) {
+      return it->second;
+    }
+  }
+
+  /* no ping data - choose the oldest peer */
+  std::shared_ptr<Peer> result;
+  for(auto& pair : m_peers) {
+    if(!result || result->getPeerId() > pair.first) {
+      result = pair.second;
+    }
+  }
+  return result;
+
+}
+
+void Session::promoteHost(const std::shared_ptr<Peer>& peer) {
+
+  auto oldHost = m_host;
+
+  m_host = peer;
+  publishRoster();
+  m_stateStore.removeClient(peer->getPeerId());
+
+  {
+    std::lock_guard<std::mutex> lock(m_pingMutex);
+    m_pingBestPeerId = -1;
+    m_pingBestPeerSinceTimestamp = -1;
+  }
+
+  HELI_LOGD("Session", "new host peer=%lld", (long long) peer->getPeerId());
+
+  auto message = MessageDto::createShared(MessageCodes::OUTGOING_NEW_HOST, oatpp::Int64(peer->getPeerId()));
+  std::vector<std::shared_ptr<Peer>> peers;
+  for(auto& pair : m_peers) {
+    peers.emplace_back(pair.second);
+  }
+  sendMessageToPeers(peers, message);
+
+  /* demoted host is still connected - it becomes a client and gets the current snapshot like a late joiner */
+  if(oldHost && oldHost != peer && m_peers.find(oldHost->getPeerId()) != m_peers.end()) {
+    m_stateStore.addClient(oldHost->getPeerId());
+    auto snapshot = m_stateStore.getDelta(0);
+    if(snapshot) {
+      oldHost->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_CLIENT_STATE_DELTA, snapshot));
+    }
+  }
+
+}
+
+void Session::checkHostCandidate(v_int64 pingSessionTimestamp) {
+
+  v_int64 candidateId;
+  v_int64 candidatePing;
+  {
+    std::lock_guard<std::mutex> lock(m_pingMutex);
+    candidateId = m_pingRoundBestPeerId;
+    candidatePing = m_pingBestTime;
+  }
+
+  std::shared_ptr<Peer> candidate;
+  if(m_host && candidateId != m_host->getPeerId()) {
+    auto it = m_peers.find(candidateId);
+    if(it != m_peers.end()) {
+      v_int64 hostPing = m_host->getPingTime(pingSessionTimestamp);
+      if(hostPing < 0 || hostPing - candidatePing >= (v_int64) m_limits.hostMigrationPingGainMicros) {
+        candidate = it->second;
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_pingMutex);
+
+    if(!candidate) {
+      m_pingBestPeerId = -1;
+      m_pingBestPeerSinceTimestamp = -1;
+      return;
+    }
+
+    if(m_pingBestPeerId != candidateId) {
+      m_pingBestPeerId = candidateId;
+      m_pingBestPeerSinceTimestamp = pingSessionTimestamp;
+      HELI_LOGD("Session", "new host candidate peer=%lld, ping=%lld", (long long) candidateId, (long long) candidatePing);
+      return;
+    }
+
+    if(pingSessionTimestamp - m_pingBestPeerSinceTimestamp < (v_int64) m_limits.hostMigrationWindowMillis * 1000) {
+      return;
+    }
+  }
+
+  promoteHost(candidate);
+
+}
+
 std::vector<std::shared_ptr<Peer>> Session::getAllPeers() {
-  std::lock_guard<std::mutex> lock(m_peersMutex);
+  auto roster = getRoster();
   std::vector<std::shared_ptr<Peer>> result;
-  for(auto& pair : m_peers) {
+  result.reserve(roster->peers.size());
+  for(auto& pair : roster->peers) {
     result.emplace_back(pair.second);
   }
   return result;
@@ -113,12 +303,12 @@ std::vector<std::shared_ptr<Peer>> Session::getPeers(const oatpp::Vector<oatpp::
 
   std::vector<std::shared_ptr<Peer>> result;
 
-  std::lock_guard<std::mutex> lock(m_peersMutex);
+  auto roster = getRoster();
 
   for(auto& id : *peerIds) {
     if(id) {
-      auto it = m_peers.find(*id);
-      if(it != m_peers.end()) {
+      auto it = roster->peers.find(*id);
+      if(it != roster->peers.end()) {
         result.emplace_back(it->second);
       }
     }
@@ -127,20 +317,216 @@ std::vector<std::shared_ptr<Peer>> Session::getPeers(const oatpp::Vector<oatpp::
   return result;
 }
 
-void Session::broadcastSynchronizedEvent(v_int64 senderId, const oatpp::String& eventData) {
+void Session::broadcastSynchronizedEvent(v_int64 senderId, const oatpp::String& eventData, const MessageOrigin& origin) {
 
   std::lock_guard<std::mutex> lock(m_peersMutex);
 
+  if(m_handingOff) {
+    return;
+  }
+
   auto event = OutgoingSynchronizedMessageDto::createShared();
   event->eventId = m_synchronizedEventId ++;
   event->peerId = senderId;
   event->data = eventData;
 
+  if(m_recording) {
+    m_recording->append(RecordingFormat::TYPE_SYNCHRONIZED_EVENT, oatpp::base::Environment::getMicroTickCount(),
+                        senderId, *event->eventId, eventData);
+  }
+
   auto message = MessageDto::createShared(MessageCodes::OUTGOING_SYNCHRONIZED_EVENT, event);
-  for(auto& peer : m_peers) {
-    peer.second->queueMessage(message);
+  std::vector<std::shared_ptr<Peer>> peers;
+  for(auto& pair : m_peers) {
+    peers.emplace_back(pair.second);
+  }
+  sendMessageToPeers(peers, message, origin);
+
+}
+
+void Session::recordInbound(v_int64 peerId, v_int64 receivedTimestamp, const oatpp::String& message) {
+  if(m_recording) {
+    m_recording->append(RecordingFormat::TYPE_INBOUND, receivedTimestamp, peerId, -1, message);
+  }
+}
+
+void Session::updateState(const oatpp::Object<StateUpdateDto>& update, const MessageOrigin& origin) {
+
+  if(m_handingOff) {
+    return;
+  }
+
+  m_stateStore.update(update->entries, update->removed);
+
+  std::vector<std::shared_ptr<Peer>> clients;
+  {
+    std::lock_guard<std::mutex> lock(m_peersMutex);
+    for(auto& pair : m_peers) {
+      if(pair.second != m_host) {
+        clients.emplace_back(pair.second);
+      }
+    }
+  }
+
+  std::unordered_map<v_int64, std::vector<std::shared_ptr<Peer>>> groups; // baseVersion --> clients
+
+  for(auto& peer : clients) {
+    auto baseVersion = m_stateStore.getAckedVersion(peer->getPeerId());
+    if(baseVersion >= 0) { // client hasn't left
+      groups[baseVersion].emplace_back(peer);
+    }
+  }
+
+  for(auto& group : groups) {
+    auto delta = m_stateStore.getDelta(group.first);
+    if(delta) {
+      sendMessageToPeers(group.second, MessageDto::createShared(MessageCodes::OUTGOING_CLIENT_STATE_DELTA, delta), origin);
+    }
+  }
+
+}
+
+bool Session::acknowledgeState(v_int64 peerId, v_int64 version) {
+  return m_stateStore.acknowledge(peerId, version);
+}
+
+void Session::sendMessageToPeers(const std::vector<std::shared_ptr<Peer>>& peers,
+                                 const oatpp::Object<MessageDto>& message,
+                                 const MessageOrigin& origin)
+{
+
+  /* remote peers get one pre-encoded copy per relay link */
+  std::unordered_map<RelayLink*, std::pair<std::shared_ptr<RelayLink>, oatpp::Vector<oatpp::Int64>>> remotePeers;
+
+  for(auto& peer : peers) {
+    auto link = peer->getRelayLink();
+    if(link) {
+      auto& entry = remotePeers[link.get()];
+      if(!entry.first) {
+        entry.first = link;
+        entry.second = oatpp::Vector<oatpp::Int64>::createShared();
+      }
+      entry.second->push_back(peer->getRelayRef());
+    } else {
+      peer->queueMessage(message, origin);
+    }
+  }
+
+  if(!remotePeers.empty()) {
+    auto data = m_objectMapper->writeToString(message);
+    for(auto& entry : remotePeers) {
+      entry.second.first->deliver(entry.second.second, data);
+      Metrics::countOutgoing(static_cast<v_int32>(*message->code), data->size(), entry.second.second->size());
+    }
+  }
+
+}
+
+v_int64 Session::getCellKey(v_int32 x, v_int32 y) {
+  return (v_int64) (((v_uint64) (v_uint32) x << 32) | (v_uint64) (v_uint32) y);
+}
+
+void Session::removePeerFromGrid(v_int64 peerId) {
+
+  auto it = m_peerCells.find(peerId);
+  if(it == m_peerCells.end()) {
+    return;
+  }
+
+  auto cellIt = m_grid.find(getCellKey(it->second.x, it->second.y));
+  if(cellIt != m_grid.end()) {
+    auto& cellPeers = cellIt->second;
+    for(size_t i = 0; i < cellPeers.size(); i ++) {
+      if(cellPeers[i]->getPeerId() == peerId) {
+        cellPeers[i] = cellPeers.back();
+        cellPeers.pop_back();
+        break;
+      }
+    }
+    if(cellPeers.empty()) {
+      m_grid.erase(cellIt);
+    }
+  }
+
+  m_peerCells.erase(it);
+
+}
+
+bool Session::setPeerCell(v_int64 peerId, v_int32 x, v_int32 y) {
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  auto peerIt = m_peers.find(peerId);
+  if(peerIt == m_peers.end()) {
+    return false;
+  }
+
+  auto it = m_peerCells.find(peerId);
+  if(it != m_peerCells.end() && it->second.x == x && it->second.y == y) {
+    return true; // peer is already in this cell
   }
 
+  removePeerFromGrid(peerId);
+
+  m_peerCells.insert({peerId, {x, y}});
+  m_grid[getCellKey(x, y)].push_back(peerIt->second);
+
+  return true;
+
+}
+
+std::vector<std::shared_ptr<Peer>> Session::getPeersInAreaOfInterest(v_int64 peerId, bool& found) {
+
+  std::vector<std::shared_ptr<Peer>> result;
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  auto it = m_peerCells.find(peerId);
+  if(it == m_peerCells.end()) {
+    found = false;
+    return result;
+  }
+
+  found = true;
+
+  /* two square areas of interest overlap if cells are at most 2 * radius apart on both axes */
+  const v_int64 range = 2 * (v_int64) m_limits.aoiRadius;
+  const v_int64 minX = std::max<v_int64>(it->second.x - range, std::numeric_limits<v_int32>::min());
+  const v_int64 maxX = std::min<v_int64>(it->second.x + range, std::numeric_limits<v_int32>::max());
+  const v_int64 minY = std::max<v_int64>(it->second.y - range, std::numeric_limits<v_int32>::min());
+  const v_int64 maxY = std::min<v_int64>(it->second.y + range, std::numeric_limits<v_int32>::max());
+
+  /* range covers more cells than there are occupied cells - check occupied cells instead */
+  if((maxX - minX + 1) * (maxY - minY + 1) > (v_int64) m_grid.size()) {
+    for(auto& cell : m_grid) {
+      const v_int64 x = (v_int32) (v_uint32) ((v_uint64) cell.first >> 32);
+      const v_int64 y = (v_int32) (v_uint32) cell.first;
+      if(x >= minX && x <= maxX && y >= minY && y <= maxY) {
+        for(auto& peer : cell.second) {
+          if(peer->getPeerId() != peerId) {
+            result.emplace_back(peer);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  for(v_int64 x = minX; x <= maxX; x ++) {
+    for(v_int64 y = minY; y <= maxY; y ++) {
+      auto cellIt = m_grid.find(getCellKey((v_int32) x, (v_int32) y));
+      if(cellIt != m_grid.end()) {
+        for(auto& peer : cellIt->second) {
+          if(peer->getPeerId() != peerId) {
+            result.emplace_back(peer);
+          }
+        }
+      }
+    }
+  }
+
+  return result;
+
 }
 
 v_int64 Session::generateNewPeerId() {
@@ -160,15 +546,21 @@ void Session::checkAllPeersPings() {
     peer.second->checkPingsRules(currentTimestamp);
   }
 
+  if(!m_limits.staticHost && currentTimestamp >= 0 && !m_handingOff) {
+    checkHostCandidate(currentTimestamp);
+  }
+
 }
 
 void Session::pingAllPeers() {
 
-  auto timestamp = oatpp::base::Environment::getMicroTickCount();
+  auto timestamp = Clock::getMicroTickCount();
 
   {
     std::lock_guard<std::mutex> lock(m_pingMutex);
     m_pingCurrentTimestamp = timestamp;
+    m_pingBestTime = -1;
+    m_pingRoundBestPeerId = -1;
   }
 
   std::lock_guard<std::mutex> lock(m_peersMutex);
@@ -178,24 +570,238 @@ void Session::pingAllPeers() {
 
 }
 
-v_int64 Session::reportPeerPong(v_int64 peerId, v_int64 timestamp) {
+v_int64 Session::reportPeerPong(v_int64 peerId, v_int64 timestamp, v_int64 pingTime) {
 
   std::lock_guard<std::mutex> lock(m_pingMutex);
-  if(timestamp != m_pingCurrentTimestamp) {
+  if(timestamp != m_pingCurrentTimestamp || pingTime < 0) {
     return -1;
   }
 
-  v_int64 pingTime = oatpp::base::Environment::getMicroTickCount() - timestamp;
-
   if(m_pingBestTime < 0 || m_pingBestTime > pingTime) {
     m_pingBestTime = pingTime;
-    if(m_pingBestPeerId != peerId) {
-      m_pingBestPeerId = peerId;
-      m_pingBestPeerSinceTimestamp = timestamp;
-      OATPP_LOGD("Session", "new best peer=%lld, ping=%lld", peerId, pingTime)
-    }
+    m_pingRoundBestPeerId = peerId;
   }
 
   return pingTime;
 
 }
+
+oatpp::String Session::generateResumeToken() {
+  /* token bytes come straight from the OS entropy source - output of a seeded PRNG is predictable */
+  std::random_device device;
+  char buffer[33];
+  std::snprintf(buffer, sizeof(buffer), "%08x%08x%08x%08x",
+                (unsigned int) device(), (unsigned int) device(), (unsigned int) device(), (unsigned int) device());
+  return oatpp::String(buffer, 32);
+}
+
+oatpp::Object<SessionSnapshotDto> Session::exportSnapshot() {
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  m_handingOff = true;
+
+  auto snapshot = SessionSnapshotDto::createShared();
+  snapshot->gameId = m_config->gameId;
+  snapshot->sessionId = m_id;
+  snapshot->peerIdCounter = m_peerIdCounter.load();
+  snapshot->synchronizedEventId = m_synchronizedEventId;
+  snapshot->stateVersion = m_stateStore.getVersion();
+  snapshot->state = m_stateStore.exportEntries();
+  snapshot->peers = oatpp::Vector<oatpp::Object<PeerSnapshotDto>>::createShared();
+
+  for(auto& pair : m_peers) {
+
+    auto peer = PeerSnapshotDto::createShared();
+    peer->peerId = pair.first;
+    peer->isHost = pair.second == m_host;
+    peer->resumeToken = generateResumeToken();
+    peer->ackedVersion = std::max<v_int64>(m_stateStore.getAckedVersion(pair.first), 0);
+
+    auto cellIt = m_peerCells.find(pair.first);
+    if(cellIt != m_peerCells.end()) {
+      peer->cell = CellDto::createShared();
+      peer->cell->x = cellIt->second.x;
+      peer->cell->y = cellIt->second.y;
+    }
+
+    auto queue = pair.second->takeQueuedMessages();
+    peer->queue = oatpp::Vector<oatpp::Object<MessageDto>>::createShared();
+    peer->queue->insert(peer->queue->end(), queue.begin(), queue.end());
+
+    snapshot->peers->push_back(peer);
+
+  }
+
+  /* peers which haven't reconnected after the previous handoff yet */
+  for(auto& pair : m_reservations) {
+    snapshot->peers->push_back(pair.second);
+  }
+
+  m_handoffSnapshot = snapshot;
+
+  return snapshot;
+
+}
+
+void Session::finishHandoff(bool success, const oatpp::String& hostAPIUrl, const oatpp::String& clientAPIUrl) {
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  if(!m_handoffSnapshot) {
+    return;
+  }
+
+  for(auto& snapshot : *m_handoffSnapshot->peers) {
+
+    auto it = m_peers.find(snapshot->peerId);
+    if(it == m_peers.end()) {
+      continue;
+    }
+
+    auto& peer = it->second;
+
+    if(!success) {
+      for(auto& message : *snapshot->queue) {
+        peer->queueMessage(message);
+      }
+      continue;
+    }
+
+    oatpp::String baseUrl = snapshot->isHost ? hostAPIUrl : clientAPIUrl;
+    oatpp::String path = snapshot->isHost ? Constants::PATH_CREATE_GAME : Constants::PATH_JOIN_GAME;
+
+    auto reconnect = ReconnectMessageDto::createShared();
+    reconnect->peerId = snapshot->peerId;
+    reconnect->resumeToken = snapshot->resumeToken;
+    reconnect->url = (baseUrl ? baseUrl : oatpp::String("")) + path
+      + "?" + Constants::PARAM_GAME_ID + "=" + m_config->gameId
+      + "&" + Constants::PARAM_GAME_SESSION_ID + "=" + m_id
+      + "&" + Constants::PARAM_PEER_ID + "=" + oatpp::utils::conversion::int64ToStr(snapshot->peerId)
+      + "&" + Constants::PARAM_RESUME_TOKEN + "=" + snapshot->resumeToken;
+
+    peer->disconnect(MessageDto::createShared(MessageCodes::OUTGOING_RECONNECT, reconnect));
+
+  }
+
+  if(!success) {
+    m_handingOff = false;
+  }
+
+  m_handoffSnapshot = nullptr;
+
+}
+
+bool Session::isHandingOff() {
+  return m_handingOff;
+}
+
+void Session::restore(const oatpp::Object<SessionSnapshotDto>& snapshot, v_int64 resumeDeadline) {
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  m_peerIdCounter = snapshot->peerIdCounter ? *snapshot->peerIdCounter : 0;
+  m_synchronizedEventId = snapshot->synchronizedEventId ? *snapshot->synchronizedEventId : 0;
+  m_stateStore.restore(snapshot->stateVersion ? *snapshot->stateVersion : 0, snapshot->state);
+
+  if(snapshot->peers) {
+    for(auto& peer : *snapshot->peers) {
+      if(peer && peer->peerId && peer->resumeToken && m_reservations.insert({*peer->peerId, peer}).second) {
+        m_peerSlots.fetch_add(1, std::memory_order_relaxed); // slot is held until the peer reconnects
+      }
+    }
+  }
+
+  m_reservationsDeadline = resumeDeadline;
+
+}
+
+oatpp::Object<PeerSnapshotDto> Session::claimReservation(v_int64 peerId, const oatpp::String& resumeToken) {
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  auto it = m_reservations.find(peerId);
+  if(it == m_reservations.end() || it->second->resumeToken != resumeToken) {
+    return nullptr;
+  }
+
+  /* slot of the reservation is passed to the reconnecting peer */
+  auto reservation = it->second;
+  m_reservations.erase(it);
+  return reservation;
+
+}
+
+void Session::resumePeer(const std::shared_ptr<Peer>& peer, const oatpp::Object<PeerSnapshotDto>& reservation) {
+
+  bool isHost;
+
+  {
+    std::lock_guard<std::mutex> lock(m_peersMutex);
+    m_peers.insert({peer->getPeerId(), peer});
+    /* host could have been promoted while the old host was reconnecting */
+    isHost = reservation->isHost && !m_host;
+    if(isHost) {
+      m_host = peer;
+    }
+    publishRoster();
+  }
+
+  auto hello = HelloMessageDto::createShared();
+  hello->peerId = peer->getPeerId();
+  hello->isHost = isHost;
+
+  peer->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_HELLO, hello));
+
+  if(reservation->cell) {
+    setPeerCell(peer->getPeerId(), reservation->cell->x, reservation->cell->y);
+  }
+
+  if(reservation->queue) {
+    for(auto& message : *reservation->queue) {
+      peer->queueMessage(message);
+    }
+  }
+
+  if(!isHost) {
+    v_int64 ackedVersion = reservation->ackedVersion ? *reservation->ackedVersion : 0;
+    m_stateStore.addClient(peer->getPeerId());
+    m_stateStore.acknowledge(peer->getPeerId(), ackedVersion);
+    auto delta = m_stateStore.getDelta(ackedVersion);
+    if(delta) {
+      peer->queueMessage(MessageDto::createShared(MessageCodes::OUTGOING_CLIENT_STATE_DELTA, delta));
+    }
+  }
+
+}
+
+bool Session::expireReservations(v_int64 timestamp) {
+
+  std::lock_guard<std::mutex> lock(m_peersMutex);
+
+  if(m_reservations.empty() || timestamp < m_reservationsDeadline) {
+    return false;
+  }
+
+  bool isHostExpired = false;
+  for(auto& pair : m_reservations) {
+    if(pair.second->isHost) {
+      isHostExpired = true;
+    }
+  }
+
+  HELI_LOGD("Session", "%d reserved peers didn't reconnect after handoff", (v_int32) m_reservations.size());
+  m_peerSlots.fetch_sub((v_int64) m_reservations.size(), std::memory_order_relaxed);
+  m_reservations.clear();
+
+  if(m_peers.empty()) {
+    return true;
+  }
+
+  if(isHostExpired && !m_host && !m_limits.staticHost) {
+    promoteHost(chooseNewHost());
+  }
+
+  return false;
+
+}
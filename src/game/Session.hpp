@@ -28,30 +28,119 @@
 #define Helicopter_game_Session_hpp
 
 #include "Peer.hpp"
+#include "StateStore.hpp"
+#include "ExecutorPool.hpp"
 #include "config/GamesConfig.hpp"
+#include "utils/Recorder.hpp"
 
 class Session {
+private:
+
+  struct Cell {
+    v_int32 x;
+    v_int32 y;
+  };
+
+  /*
+   * Immutable copy of the session peers for the message hot path.
+   */
+  struct Roster {
+    std::shared_ptr<Peer> host;
+    std::unordered_map<v_int64, std::shared_ptr<Peer>> peers;
+  };
+
 private:
   oatpp::String m_id;
   oatpp::Object<GameConfigDto> m_config;
+  const GameLimits m_limits; // compiled from m_config
+  std::shared_ptr<ExecutorPool> m_executors;
+  v_int32 m_executorIndex;
+  std::shared_ptr<oatpp::async::Executor> m_executor;
   std::atomic<v_int64> m_peerIdCounter;
+  std::atomic<v_int64> m_peerSlots;
   v_int64 m_synchronizedEventId; // synchronized by m_peersMutex
   std::unordered_map<v_int64, std::shared_ptr<Peer>> m_peers;
   std::shared_ptr<Peer> m_host;
   std::mutex m_peersMutex;
+  /* copy of m_peers and m_host - read without m_peersMutex, republished under m_peersMutex on every change */
+  std::shared_ptr<const Roster> m_roster;
+private:
+  /* spatial grid index - synchronized by m_peersMutex */
+  std::unordered_map<v_int64, std::vector<std::shared_ptr<Peer>>> m_grid;
+  std::unordered_map<v_int64, Cell> m_peerCells;
+private:
+  StateStore m_stateStore;
+private:
+  /* handoff - synchronized by m_peersMutex */
+  std::atomic<bool> m_handingOff;
+  oatpp::Object<SessionSnapshotDto> m_handoffSnapshot; // exported snapshot
+  std::unordered_map<v_int64, oatpp::Object<PeerSnapshotDto>> m_reservations; // peers of the restored session yet to reconnect
+  v_int64 m_reservationsDeadline;
 private:
   v_int64 m_pingCurrentTimestamp;
-  v_int64 m_pingBestTime;
-  v_int64 m_pingBestPeerId;
-  v_int64 m_pingBestPeerSinceTimestamp;
+  v_int64 m_pingBestTime; // best ping in the current ping session
+  v_int64 m_pingRoundBestPeerId; // peer with the best ping in the current ping session
+  v_int64 m_pingBestPeerId; // host candidate
+  v_int64 m_pingBestPeerSinceTimestamp; // since when host candidate has the best ping
   std::mutex m_pingMutex;
+private:
+  OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, m_objectMapper, Constants::COMPONENT_WS_API);
+  OATPP_COMPONENT(std::shared_ptr<Recorder>, m_recorder);
+private:
+  std::shared_ptr<Recording> m_recording; // null - session is not recorded
+private:
+  static v_int64 getCellKey(v_int32 x, v_int32 y);
+  static oatpp::String generateResumeToken();
+  void removePeerFromGrid(v_int64 peerId);
+private:
+  std::shared_ptr<const Roster> getRoster();
+private:
+  /* synchronized by m_peersMutex */
+  void publishRoster();
+  std::shared_ptr<Peer> chooseNewHost();
+  void promoteHost(const std::shared_ptr<Peer>& peer);
+  void checkHostCandidate(v_int64 pingSessionTimestamp);
 public:
 
-  Session(const oatpp::String& id, const oatpp::Object<GameConfigDto>& config);
+  Session(const oatpp::String& id,
+          const oatpp::Object<GameConfigDto>& config,
+          const std::shared_ptr<ExecutorPool>& executors);
+
+  ~Session();
 
   oatpp::String getId();
   oatpp::Object<GameConfigDto> getConfig();
 
+  /**
+   * Get limits compiled from the session config. Valid for the lifetime of the session.
+   * @return
+   */
+  const GameLimits& getLimits() const;
+
+  /**
+   * Get executor the session is pinned to.
+   * @return
+   */
+  std::shared_ptr<oatpp::async::Executor> getExecutor();
+
+  /**
+   * Check if inbound messages should be handled on the session's executor.
+   * `true` if session is pinned to a single-threaded executor or to the executor of the shard owning the session.
+   * @return
+   */
+  bool isExecutorAffine();
+
+  /**
+   * Reserve slot for a new peer. Must be called before the peer is allocated.
+   * @return - `false` if session reached `maxPeers`.
+   */
+  bool tryAcquirePeerSlot();
+
+  /**
+   * Release slot of the peer which was removed from session or which failed to join.
+   */
+  void releasePeerSlot();
+
   void addPeer(const std::shared_ptr<Peer>& peer, bool isHost = false);
   void setHost(const std::shared_ptr<Peer>& peer);
   std::shared_ptr<Peer> getHost();
@@ -63,10 +152,67 @@ public:
   std::vector<std::shared_ptr<Peer>> getAllPeers();
   std::vector<std::shared_ptr<Peer>> getPeers(const oatpp::Vector<oatpp::Int64>& peerIds);
 
-  void broadcastSynchronizedEvent(v_int64 senderId, const oatpp::String& eventData);
+  /**
+   * Record inbound message if the session is recorded. Never blocks on I/O.
+   * @param peerId
+   * @param receivedTimestamp
+   * @param message - message as received.
+   */
+  void recordInbound(v_int64 peerId, v_int64 receivedTimestamp, const oatpp::String& message);
+
+  void broadcastSynchronizedEvent(v_int64 senderId, const oatpp::String& eventData, const MessageOrigin& origin = MessageOrigin());
+
+  /**
+   * Send the same message to peers.
+   * Local peers get the message queued. Remote peers connected to the same node get one pre-encoded copy through the relay link.
+   * @param peers
+   * @param message
+   * @param origin - inbound message this message is sent for. Default - message originates on server.
+   */
+  void sendMessageToPeers(const std::vector<std::shared_ptr<Peer>>& peers,
+                          const oatpp::Object<MessageDto>& message,
+                          const MessageOrigin& origin = MessageOrigin());
+
+  /**
+   * Put peer to the cell of the spatial grid.
+   * @param peerId
+   * @param x
+   * @param y
+   * @return - `false` if there is no such peer in the session.
+   */
+  bool setPeerCell(v_int64 peerId, v_int32 x, v_int32 y);
+
+  /**
+   * Get peers whose area of interest overlaps the area of interest of the given peer.
+   * The given peer is not included in the result.
+   * @param peerId
+   * @param found - `false` if peer hasn't declared its cell yet.
+   * @return
+   */
+  std::vector<std::shared_ptr<Peer>> getPeersInAreaOfInterest(v_int64 peerId, bool& found);
+
+  /**
+   * Apply host update to the session state and send deltas to clients.
+   * Clients with the same acknowledged version share the same delta message.
+   * @param update
+   * @param origin - host's update message.
+   */
+  void updateState(const oatpp::Object<StateUpdateDto>& update, const MessageOrigin& origin = MessageOrigin());
+
+  /**
+   * Report version of the session state applied by the client.
+   * @param peerId
+   * @param version
+   * @return - `false` if version is invalid.
+   */
+  bool acknowledgeState(v_int64 peerId, v_int64 version);
 
   v_int64 generateNewPeerId();
 
+  /**
+   * Check ping rules of all peers against the latest ping session.
+   * If host is dynamic - promote the host candidate when it has the best ping long enough.
+   */
   void checkAllPeersPings();
 
   void pingAllPeers();
@@ -76,9 +222,63 @@ public:
    * @param peerId
    * @param timestamp - timestamp reported in the pong (payload). If timestamp doesn't equal to the latest ping
    * timestamp - ping considered to be failed.
+   * @param pingTime - round-trip time measured by peer - from ping frame write to pong frame read.
    * @return - peer's ping in microseconds or `-1` if ping failed.
    */
-  v_int64 reportPeerPong(v_int64 peerId, v_int64 timestamp);
+  v_int64 reportPeerPong(v_int64 peerId, v_int64 timestamp, v_int64 pingTime);
+
+  /**
+   * Handoff. Freeze the session and export its state - roster, host, state store and queued messages.
+   * Frozen session doesn't handle peers' messages.
+   * @return
+   */
+  oatpp::Object<SessionSnapshotDto> exportSnapshot();
+
+  /**
+   * Handoff. Complete handoff started with `exportSnapshot()`.
+   * @param success - if `true` - peers are told to reconnect to the successor and disconnected.
+   * Otherwise session is unfrozen and queued messages are put back.
+   * @param hostAPIUrl - successor Host API URL. null - same address.
+   * @param clientAPIUrl - successor Client API URL. null - same address.
+   */
+  void finishHandoff(bool success, const oatpp::String& hostAPIUrl, const oatpp::String& clientAPIUrl);
+
+  /**
+   * Check if session is being handed off.
+   * @return
+   */
+  bool isHandingOff();
+
+  /**
+   * Handoff. Restore session exported by the predecessor. Peers of the snapshot are reserved until they reconnect.
+   * Each reservation holds a peer slot of the session.
+   * @param snapshot
+   * @param resumeDeadline - timestamp in microseconds after which reservations expire.
+   */
+  void restore(const oatpp::Object<SessionSnapshotDto>& snapshot, v_int64 resumeDeadline);
+
+  /**
+   * Handoff. Claim reservation of the peer reconnecting after handoff.
+   * Peer slot held by the reservation is passed to the caller - don't call `tryAcquirePeerSlot()` for the claimed peer.
+   * @param peerId
+   * @param resumeToken
+   * @return - reservation or `nullptr` if there is no such reservation or token doesn't match.
+   */
+  oatpp::Object<PeerSnapshotDto> claimReservation(v_int64 peerId, const oatpp::String& resumeToken);
+
+  /**
+   * Handoff. Add reconnected peer with its restored state.
+   * @param peer
+   * @param reservation - claimed reservation.
+   */
+  void resumePeer(const std::shared_ptr<Peer>& peer, const oatpp::Object<PeerSnapshotDto>& reservation);
+
+  /**
+   * Handoff. Drop reservations of peers which didn't reconnect in time.
+   * @param timestamp - current timestamp in microseconds.
+   * @return - `true` if reservations expired and there are no peers left - session should be deleted.
+   */
+  bool expireReservations(v_int64 timestamp);
 
 };
 
@@ -0,0 +1,211 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "StateStore.hpp"
+
+StateStore::StateStore()
+  : m_version(0)
+  , m_removedCount(0)
+{}
+
+void StateStore::compact() {
+
+  /* removed keys are needed only for clients which haven't acknowledged the removal yet */
+  v_int64 minAcked = m_version;
+  for(auto& pair : m_ackedVersions) {
+    if(pair.second < minAcked) {
+      minAcked = pair.second;
+    }
+  }
+
+  auto it = m_entries.begin();
+  while (it != m_entries.end()) {
+    if(!it->second.value && it->second.version <= minAcked) {
+      it = m_entries.erase(it);
+      m_removedCount --;
+    } else {
+      it ++;
+    }
+  }
+
+}
+
+v_int64 StateStore::update(const oatpp::UnorderedFields<oatpp::String>& entries, const oatpp::Vector<oatpp::String>& removed) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_version ++;
+
+  if(entries) {
+    for(auto& pair : *entries) {
+      if(!pair.first) continue;
+      auto& entry = m_entries[pair.first];
+      if(!entry.value && entry.version > 0) {
+        m_removedCount --;
+      }
+      if(!pair.second) {
+        m_removedCount ++; // null value removes the key
+      }
+      entry.value = pair.second;
+      entry.version = m_version;
+    }
+  }
+
+  if(removed) {
+    for(auto& key : *removed) {
+      if(!key) continue;
+      auto it = m_entries.find(key);
+      if(it != m_entries.end() && it->second.value) {
+        it->second.value = nullptr;
+        it->second.version = m_version;
+        m_removedCount ++;
+      }
+    }
+  }
+
+  if(m_removedCount > 64 && m_removedCount * 2 > (v_int64) m_entries.size()) {
+    compact();
+  }
+
+  return m_version;
+
+}
+
+oatpp::Object<StateDeltaDto> StateStore::getDelta(v_int64 baseVersion) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(baseVersion >= m_version) {
+    return nullptr;
+  }
+
+  auto delta = StateDeltaDto::createShared();
+  delta->version = m_version;
+  delta->baseVersion = baseVersion;
+  delta->entries = oatpp::UnorderedFields<oatpp::String>({});
+  delta->removed = oatpp::Vector<oatpp::String>({});
+
+  for(auto& pair : m_entries) {
+    if(pair.second.version > baseVersion) {
+      if(pair.second.value) {
+        delta->entries->insert({pair.first, pair.second.value});
+      } else if(baseVersion > 0) { // full snapshot doesn't need removed keys
+        delta->removed->push_back(pair.first);
+      }
+    }
+  }
+
+  return delta;
+
+}
+
+void StateStore::addClient(v_int64 peerId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ackedVersions.insert({peerId, 0});
+}
+
+void StateStore::removeClient(v_int64 peerId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ackedVersions.erase(peerId);
+}
+
+bool StateStore::acknowledge(v_int64 peerId, v_int64 version) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(version > m_version) {
+    return false;
+  }
+
+  auto it = m_ackedVersions.find(peerId);
+  if(it == m_ackedVersions.end()) {
+    return false;
+  }
+
+  if(version > it->second) { // acks may arrive out of order
+    it->second = version;
+  }
+
+  return true;
+
+}
+
+v_int64 StateStore::getAckedVersion(v_int64 peerId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_ackedVersions.find(peerId);
+  if(it != m_ackedVersions.end()) {
+    return it->second;
+  }
+  return -1;
+}
+
+v_int64 StateStore::getVersion() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_version;
+}
+
+oatpp::Vector<oatpp::Object<StateEntryDto>> StateStore::exportEntries() {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto result = oatpp::Vector<oatpp::Object<StateEntryDto>>::createShared();
+  result->reserve(m_entries.size());
+
+  for(auto& pair : m_entries) {
+    auto entry = StateEntryDto::createShared();
+    entry->key = pair.first;
+    entry->value = pair.second.value;
+    entry->version = pair.second.version;
+    result->push_back(entry);
+  }
+
+  return result;
+
+}
+
+void StateStore::restore(v_int64 version, const oatpp::Vector<oatpp::Object<StateEntryDto>>& entries) {
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_entries.clear();
+  m_removedCount = 0;
+  m_version = version;
+
+  if(!entries) {
+    return;
+  }
+
+  for(auto& e : *entries) {
+    if(!e || !e->key || !e->version) continue;
+    auto& entry = m_entries[e->key];
+    entry.value = e->value;
+    entry.version = *e->version;
+    if(!entry.value) {
+      m_removedCount ++;
+    }
+  }
+
+}
@@ -0,0 +1,122 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_game_StateStore_hpp
+#define Helicopter_game_StateStore_hpp
+
+#include "dto/HandoffDTOs.hpp"
+
+#include <unordered_map>
+#include <mutex>
+
+/**
+ * Keyed state of the game session.
+ * Host writes keys to the store, server tracks versions acknowledged by clients and sends them only changed keys.
+ */
+class StateStore {
+private:
+
+  struct Entry {
+    oatpp::String value; // nullptr - key was removed
+    v_int64 version = 0;
+  };
+
+private:
+  std::unordered_map<oatpp::String, Entry> m_entries;
+  std::unordered_map<v_int64, v_int64> m_ackedVersions;
+  v_int64 m_version;
+  v_int64 m_removedCount;
+  std::mutex m_mutex;
+private:
+  void compact();
+public:
+
+  StateStore();
+
+  /**
+   * Apply update to the store.
+   * @param entries - keys to put.
+   * @param removed - keys to remove.
+   * @return - new version of the state.
+   */
+  v_int64 update(const oatpp::UnorderedFields<oatpp::String>& entries, const oatpp::Vector<oatpp::String>& removed);
+
+  /**
+   * Get keys changed since the base version.
+   * @param baseVersion - `0` for full snapshot.
+   * @return - `nullptr` if there are no changes since the base version.
+   */
+  oatpp::Object<StateDeltaDto> getDelta(v_int64 baseVersion);
+
+  /**
+   * Start tracking acknowledged version of the client. New client has nothing acknowledged.
+   * @param peerId
+   */
+  void addClient(v_int64 peerId);
+
+  /**
+   * Stop tracking acknowledged version of the client.
+   * @param peerId
+   */
+  void removeClient(v_int64 peerId);
+
+  /**
+   * Report version of the state applied by the client.
+   * @param peerId
+   * @param version
+   * @return - `false` if version is greater than the current version of the state or client is unknown.
+   */
+  bool acknowledge(v_int64 peerId, v_int64 version);
+
+  /**
+   * Get the latest version acknowledged by the client.
+   * @param peerId
+   * @return - acknowledged version or `-1` if client is unknown.
+   */
+  v_int64 getAckedVersion(v_int64 peerId);
+
+  /**
+   * Get current version of the state.
+   * @return
+   */
+  v_int64 getVersion();
+
+  /**
+   * Handoff. Get all keys with their versions, including removed keys.
+   * @return
+   */
+  oatpp::Vector<oatpp::Object<StateEntryDto>> exportEntries();
+
+  /**
+   * Handoff. Replace content of the store with the exported keys.
+   * @param version - version of the state.
+   * @param entries
+   */
+  void restore(v_int64 version, const oatpp::Vector<oatpp::Object<StateEntryDto>>& entries);
+
+};
+
+#endif //Helicopter_game_StateStore_hpp
@@ -0,0 +1,255 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "HandoffChannel.hpp"
+
+#include "utils/AsyncLogger.hpp"
+
+#include "oatpp/core/data/stream/BufferStream.hpp"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+  constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+  constexpr int SEND_FLAGS = 0;
+#endif
+
+  bool setAddress(struct sockaddr_un& address, const oatpp::String& socketPath) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath->size() >= sizeof(address.sun_path)) {
+      return false;
+    }
+    std::memcpy(address.sun_path, socketPath->data(), socketPath->size());
+    return true;
+  }
+
+  bool writeAll(oatpp::v_io_handle handle, const char* data, v_buff_size size) {
+    while(size > 0) {
+      auto res = ::send(handle, data, size, SEND_FLAGS);
+      if(res <= 0) {
+        return false;
+      }
+      data += res;
+      size -= res;
+    }
+    return true;
+  }
+
+  void setTimeout(oatpp::v_io_handle handle, v_int64 timeoutMillis) {
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMillis / 1000;
+    timeout.tv_usec = (timeoutMillis % 1000) * 1000;
+    setsockopt(handle, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+
+}
+
+HandoffChannel::HandoffChannel(const oatpp::String& socketPath, const Callback& callback, v_int64 timeoutMillis)
+  : m_socketPath(socketPath)
+  , m_callback(callback)
+  , m_timeoutMillis(timeoutMillis)
+  , m_closed(false)
+{
+  m_serverHandle = instantiateServer();
+  m_thread = std::thread(&HandoffChannel::run, this);
+}
+
+HandoffChannel::~HandoffChannel() {
+  stop();
+  if(m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void HandoffChannel::stop() {
+  if(!m_closed.exchange(true)) {
+    ::close(m_serverHandle);
+    ::unlink(m_socketPath->c_str());
+  }
+}
+
+oatpp::v_io_handle HandoffChannel::instantiateServer() {
+
+  struct sockaddr_un address;
+  if(!setAddress(address, m_socketPath)) {
+    throw std::runtime_error("[HandoffChannel::instantiateServer()]: Error. Socket path is too long.");
+  }
+
+  /* stale socket file of the previous run */
+  ::unlink(m_socketPath->c_str());
+
+  oatpp::v_io_handle serverHandle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(serverHandle < 0) {
+    throw std::runtime_error("[HandoffChannel::instantiateServer()]: Error. Couldn't open a socket.");
+  }
+
+  if(bind(serverHandle, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(serverHandle, 1) != 0) {
+    ::close(serverHandle);
+    throw std::runtime_error("[HandoffChannel::instantiateServer()]: Error. Can't bind to socket path.");
+  }
+
+  return serverHandle;
+
+}
+
+void HandoffChannel::run() {
+
+  while(!m_closed) {
+
+    struct pollfd pfd;
+    pfd.fd = m_serverHandle;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    /* wake up periodically to check if channel is stopped */
+    if(poll(&pfd, 1, 1000) <= 0 || m_closed) {
+      continue;
+    }
+
+    oatpp::v_io_handle handle = accept(m_serverHandle, nullptr, nullptr);
+    if(handle < 0) {
+      continue;
+    }
+
+    receive(handle);
+    ::close(handle);
+
+  }
+
+}
+
+void HandoffChannel::receive(oatpp::v_io_handle handle) {
+
+  HELI_LOGD("HandoffChannel", "Predecessor connected");
+
+  setTimeout(handle, m_timeoutMillis);
+
+  oatpp::data::stream::BufferOutputStream line;
+  std::vector<oatpp::String> snapshots;
+  char buffer[4096];
+
+  while(true) {
+
+    auto res = ::recv(handle, buffer, sizeof(buffer), 0);
+    if(res <= 0) {
+      HELI_LOGE("HandoffChannel", "Predecessor disconnected before the end of handoff. Sessions dropped - %d", (v_int32) snapshots.size());
+      return;
+    }
+
+    for(ssize_t i = 0; i < res; i ++) {
+
+      if(buffer[i] != '\n') {
+        line.writeCharSimple(buffer[i]);
+        continue;
+      }
+
+      if(line.getCurrentPosition() == 0) {
+        /* empty line - end of handoff. Sessions are restored only if the whole handoff is received -
+         * otherwise predecessor keeps serving them and peers must not find them here. */
+        for(auto& snapshot : snapshots) {
+          m_callback(snapshot);
+        }
+        HELI_LOGI("HandoffChannel", "Handoff received. Sessions - %d", (v_int32) snapshots.size());
+        writeAll(handle, "OK\n", 3);
+        return;
+      }
+
+      snapshots.push_back(line.toString());
+      line.setCurrentPosition(0);
+
+    }
+
+  }
+
+}
+
+bool HandoffChannel::send(const oatpp::String& socketPath, const std::vector<oatpp::String>& snapshots, v_int64 timeoutMillis) {
+
+  struct sockaddr_un address;
+  if(!setAddress(address, socketPath)) {
+    HELI_LOGE("HandoffChannel", "Error. Socket path is too long - '%s'", socketPath->c_str());
+    return false;
+  }
+
+  oatpp::v_io_handle handle = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(handle < 0) {
+    HELI_LOGE("HandoffChannel", "Error. Couldn't open a socket.");
+    return false;
+  }
+
+  setTimeout(handle, timeoutMillis);
+
+  if(connect(handle, (struct sockaddr*) &address, sizeof(address)) != 0) {
+    HELI_LOGE("HandoffChannel", "Error. Can't connect to successor - '%s'", socketPath->c_str());
+    ::close(handle);
+    return false;
+  }
+
+  bool success = true;
+  for(auto& snapshot : snapshots) {
+    /* JSON has no raw line breaks - line per snapshot */
+    if(!writeAll(handle, snapshot->data(), snapshot->size()) || !writeAll(handle, "\n", 1)) {
+      success = false;
+      break;
+    }
+  }
+
+  if(success) {
+    success = writeAll(handle, "\n", 1);
+  }
+
+  if(success) {
+    char response[3];
+    v_buff_size received = 0;
+    while(received < 3) {
+      auto res = ::recv(handle, response + received, 3 - received, 0);
+      if(res <= 0) {
+        break;
+      }
+      received += res;
+    }
+    success = received == 3 && std::memcmp(response, "OK\n", 3) == 0;
+  }
+
+  ::close(handle);
+
+  if(!success) {
+    HELI_LOGE("HandoffChannel", "Error. Successor didn't acknowledge handoff - '%s'", socketPath->c_str());
+  }
+
+  return success;
+
+}
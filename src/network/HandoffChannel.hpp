@@ -0,0 +1,95 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_network_HandoffChannel_hpp
+#define Helicopter_network_HandoffChannel_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * Local channel to hand off game sessions to the successor process over a unix domain socket.
+ * Snapshots are sent as newline-delimited JSON terminated by an empty line.
+ * Receiver restores snapshots once the terminating empty line is received and answers `OK` -
+ * only then the sender tells peers to reconnect. Incomplete handoff restores nothing.
+ */
+class HandoffChannel {
+public:
+
+  /**
+   * Called for each received snapshot.
+   */
+  typedef std::function<void(const oatpp::String& snapshot)> Callback;
+
+private:
+  oatpp::String m_socketPath;
+  Callback m_callback;
+  v_int64 m_timeoutMillis;
+  oatpp::v_io_handle m_serverHandle;
+  std::atomic<bool> m_closed;
+  std::thread m_thread;
+private:
+  oatpp::v_io_handle instantiateServer();
+  void run();
+  void receive(oatpp::v_io_handle handle);
+public:
+
+  /**
+   * Constructor. Successor side - start accepting snapshots.
+   * Throws `std::runtime_error` if socket can't be bound.
+   * @param socketPath - unix socket path.
+   * @param callback - called for each received snapshot on the channel thread.
+   * Snapshots are applied only after the whole handoff is received, right before `OK` is sent.
+   * @param timeoutMillis - I/O timeout of the predecessor connection.
+   */
+  HandoffChannel(const oatpp::String& socketPath, const Callback& callback, v_int64 timeoutMillis);
+
+  /**
+   * Stop and join the channel thread.
+   */
+  ~HandoffChannel();
+
+  /**
+   * Close listening socket.
+   */
+  void stop();
+
+  /**
+   * Predecessor side. Send snapshots to the successor and wait for acknowledgement.
+   * @param socketPath - unix socket path of the successor.
+   * @param snapshots - serialized snapshots.
+   * @param timeoutMillis - I/O timeout.
+   * @return - `true` if successor restored the snapshots.
+   */
+  static bool send(const oatpp::String& socketPath, const std::vector<oatpp::String>& snapshots, v_int64 timeoutMillis);
+
+};
+
+#endif //Helicopter_network_HandoffChannel_hpp
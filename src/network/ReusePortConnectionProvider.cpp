@@ -0,0 +1,156 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ReusePortConnectionProvider.hpp"
+
+#include "oatpp/network/tcp/server/ConnectionProvider.hpp"
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+
+void ReusePortConnectionProvider::ConnectionInvalidator::invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) {
+  auto c = std::static_pointer_cast<oatpp::network::tcp::Connection>(connection);
+  ::shutdown(c->getHandle(), SHUT_RDWR);
+}
+
+ReusePortConnectionProvider::ReusePortConnectionProvider(const oatpp::network::Address& address)
+  : m_invalidator(std::make_shared<ConnectionInvalidator>())
+  , m_address(address)
+  , m_closed(false)
+{
+  setProperty(PROPERTY_HOST, m_address.host);
+  setProperty(PROPERTY_PORT, oatpp::utils::conversion::int32ToStr(m_address.port));
+  m_serverHandle = instantiateServer();
+}
+
+std::shared_ptr<ReusePortConnectionProvider> ReusePortConnectionProvider::createShared(const oatpp::network::Address& address) {
+  return std::make_shared<ReusePortConnectionProvider>(address);
+}
+
+ReusePortConnectionProvider::~ReusePortConnectionProvider() {
+  stop();
+}
+
+void ReusePortConnectionProvider::stop() {
+  if(!m_closed.exchange(true)) {
+    ::close(m_serverHandle);
+  }
+}
+
+oatpp::v_io_handle ReusePortConnectionProvider::instantiateServer() {
+
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  hints.ai_flags = AI_PASSIVE;
+
+  auto portStr = oatpp::utils::conversion::int32ToStr(m_address.port);
+
+  struct addrinfo* result = nullptr;
+  if(getaddrinfo(m_address.host->c_str(), portStr->c_str(), &hints, &result) != 0 || result == nullptr) {
+    throw std::runtime_error("[ReusePortConnectionProvider::instantiateServer()]: Error. Call to getaddrinfo() failed.");
+  }
+
+  oatpp::v_io_handle serverHandle = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if(serverHandle < 0) {
+    freeaddrinfo(result);
+    throw std::runtime_error("[ReusePortConnectionProvider::instantiateServer()]: Error. Couldn't open a socket.");
+  }
+
+  int yes = 1;
+  if(setsockopt(serverHandle, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int)) != 0 ||
+     setsockopt(serverHandle, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(int)) != 0)
+  {
+    freeaddrinfo(result);
+    ::close(serverHandle);
+    throw std::runtime_error("[ReusePortConnectionProvider::instantiateServer()]: Error. Failed to set SO_REUSEPORT.");
+  }
+
+  if(bind(serverHandle, result->ai_addr, (int) result->ai_addrlen) != 0 || listen(serverHandle, 10000) != 0) {
+    freeaddrinfo(result);
+    ::close(serverHandle);
+    throw std::runtime_error("[ReusePortConnectionProvider::instantiateServer()]: Error. Can't bind to address.");
+  }
+
+  freeaddrinfo(result);
+
+  /* non-blocking accept - poll() wakes every listener of the port group but only one gets the connection */
+  fcntl(serverHandle, F_SETFL, O_NONBLOCK);
+
+  return serverHandle;
+
+}
+
+oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream> ReusePortConnectionProvider::get() {
+
+  struct pollfd pfd;
+  pfd.fd = m_serverHandle;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  /* wake up periodically to check if provider is stopped */
+  if(m_closed || poll(&pfd, 1, 1000) <= 0) {
+    return oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>();
+  }
+
+  struct sockaddr_storage clientAddress;
+  socklen_t clientAddressSize = sizeof(clientAddress);
+
+  oatpp::v_io_handle handle = accept(m_serverHandle, (struct sockaddr*) &clientAddress, &clientAddressSize);
+  if(handle < 0) {
+    return oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>();
+  }
+
+  int yes = 1;
+  setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(int));
+
+  oatpp::data::stream::Context::Properties properties;
+
+  if(clientAddress.ss_family == AF_INET) {
+    char strIp[INET_ADDRSTRLEN];
+    auto address = (struct sockaddr_in*) &clientAddress;
+    inet_ntop(AF_INET, &address->sin_addr, strIp, INET_ADDRSTRLEN);
+    properties.put(oatpp::network::tcp::server::ConnectionProvider::ExtendedConnection::PROPERTY_PEER_ADDRESS, oatpp::String(strIp));
+    properties.put(oatpp::network::tcp::server::ConnectionProvider::ExtendedConnection::PROPERTY_PEER_ADDRESS_FORMAT, "ipv4");
+    properties.put(oatpp::network::tcp::server::ConnectionProvider::ExtendedConnection::PROPERTY_PEER_PORT, oatpp::utils::conversion::int32ToStr(ntohs(address->sin_port)));
+  }
+
+  return oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>(
+    std::make_shared<oatpp::network::tcp::server::ConnectionProvider::ExtendedConnection>(handle, std::move(properties)),
+    m_invalidator
+  );
+
+}
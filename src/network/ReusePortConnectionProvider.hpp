@@ -0,0 +1,95 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_network_ReusePortConnectionProvider_hpp
+#define Helicopter_network_ReusePortConnectionProvider_hpp
+
+#include "oatpp/network/ConnectionProvider.hpp"
+#include "oatpp/network/Address.hpp"
+
+#include <atomic>
+
+/**
+ * TCP server connection provider which listens with `SO_REUSEPORT`.
+ * Several providers (one per shard) can listen on the same port - kernel balances incoming connections between them.
+ * Provides extended connections - peer address is available in connection context properties.
+ */
+class ReusePortConnectionProvider : public oatpp::network::ServerConnectionProvider {
+private:
+
+  class ConnectionInvalidator : public oatpp::provider::Invalidator<oatpp::data::stream::IOStream> {
+  public:
+    void invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) override;
+  };
+
+private:
+  std::shared_ptr<ConnectionInvalidator> m_invalidator;
+  oatpp::network::Address m_address;
+  std::atomic<bool> m_closed;
+  oatpp::v_io_handle m_serverHandle;
+private:
+  oatpp::v_io_handle instantiateServer();
+public:
+
+  /**
+   * Constructor.
+   * @param address - address to listen on.
+   */
+  ReusePortConnectionProvider(const oatpp::network::Address& address);
+
+  /**
+   * Create shared ReusePortConnectionProvider.
+   * @param address - address to listen on.
+   * @return
+   */
+  static std::shared_ptr<ReusePortConnectionProvider> createShared(const oatpp::network::Address& address);
+
+  /**
+   * Virtual destructor.
+   */
+  ~ReusePortConnectionProvider();
+
+  /**
+   * Close listening socket.
+   */
+  void stop() override;
+
+  /**
+   * Get incoming connection.
+   * @return - connection or empty handle if there is no connection yet.
+   */
+  oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream> get() override;
+
+  /**
+   * Not implemented. `oatpp::network::Server` uses blocking `get()`.
+   */
+  oatpp::async::CoroutineStarterForResult<const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>&> getAsync() override {
+    throw std::runtime_error("[ReusePortConnectionProvider::getAsync()]: Error. Not implemented.");
+  }
+
+};
+
+#endif //Helicopter_network_ReusePortConnectionProvider_hpp
@@ -0,0 +1,238 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "AsyncLogger.hpp"
+
+#include "oatpp/core/base/Environment.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+AsyncLogger::Record* AsyncLogger::s_records = nullptr;
+v_uint64 AsyncLogger::s_mask = 0;
+std::atomic<v_uint64> AsyncLogger::s_enqueuePosition(0);
+v_uint64 AsyncLogger::s_dequeuePosition = 0;
+std::atomic<v_int64> AsyncLogger::s_droppedRecords(0);
+std::atomic<v_uint32> AsyncLogger::s_rateLimit(50);
+std::atomic<bool> AsyncLogger::s_running(false);
+std::atomic<bool> AsyncLogger::s_stopping(false);
+std::thread AsyncLogger::s_thread;
+
+AsyncLogger::Site::Site(const char* tag)
+  : m_tag(tag)
+  , m_window(0)
+  , m_count(0)
+  , m_suppressed(0)
+{}
+
+bool AsyncLogger::Site::acquire() {
+
+  v_uint32 limit = AsyncLogger::getRateLimit();
+  if(limit == 0) {
+    return true;
+  }
+
+  v_int64 window = oatpp::base::Environment::getMicroTickCount() / 1000000;
+  if(m_window.load(std::memory_order_relaxed) != window) {
+    /* racy reset is fine - the limit is approximate */
+    m_window.store(window, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+  }
+
+  if(m_count.fetch_add(1, std::memory_order_relaxed) < limit) {
+    return true;
+  }
+
+  m_suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+
+}
+
+v_uint32 AsyncLogger::Site::takeSuppressed() {
+  if(m_suppressed.load(std::memory_order_relaxed) == 0) {
+    return 0;
+  }
+  return m_suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+v_buff_size AsyncLogger::format(char* buffer, Site& site, const char* format, va_list args) {
+
+  v_buff_size size = std::vsnprintf(buffer, MAX_RECORD_SIZE, format, args);
+  if(size < 0) {
+    buffer[0] = 0;
+    size = 0;
+  } else if(size >= MAX_RECORD_SIZE) {
+    size = MAX_RECORD_SIZE - 1;
+  }
+
+  v_uint32 suppressed = site.takeSuppressed();
+  if(suppressed > 0 && size < MAX_RECORD_SIZE - 1) {
+    v_buff_size tail = std::snprintf(buffer + size, MAX_RECORD_SIZE - size, " (%u similar records suppressed)", suppressed);
+    if(tail > 0) {
+      size = std::min<v_buff_size>(size + tail, MAX_RECORD_SIZE - 1);
+    }
+  }
+
+  return size;
+
+}
+
+void AsyncLogger::write(v_int32 level, const char* tag, const char* text) {
+  v_uint32 priority;
+  switch (level) {
+    case LEVEL_DEBUG: priority = oatpp::base::Logger::PRIORITY_D; break;
+    case LEVEL_INFO: priority = oatpp::base::Logger::PRIORITY_I; break;
+    case LEVEL_WARNING: priority = oatpp::base::Logger::PRIORITY_W; break;
+    default: priority = oatpp::base::Logger::PRIORITY_E;
+  }
+  oatpp::base::Environment::log(priority, tag, text);
+}
+
+bool AsyncLogger::writeNext() {
+
+  Record* record = &s_records[s_dequeuePosition & s_mask];
+  if(record->sequence.load(std::memory_order_acquire) != s_dequeuePosition + 1) {
+    return false;
+  }
+
+  write(record->level, record->tag, record->text);
+
+  /* release the slot for the producer one lap ahead */
+  record->sequence.store(s_dequeuePosition + s_mask + 1, std::memory_order_release);
+  s_dequeuePosition ++;
+  return true;
+
+}
+
+void AsyncLogger::run() {
+
+  v_int64 reportedDrops = 0;
+
+  while(true) {
+
+    bool stopping = s_stopping.load(std::memory_order_acquire);
+
+    while(writeNext()) {}
+
+    v_int64 drops = s_droppedRecords.load(std::memory_order_relaxed);
+    if(drops != reportedDrops) {
+      OATPP_LOGW("AsyncLogger", "%lld records dropped - ring buffer is full", drops - reportedDrops)
+      reportedDrops = drops;
+    }
+
+    if(stopping) {
+      break;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  }
+
+}
+
+void AsyncLogger::start(v_uint32 bufferSize, v_uint32 rateLimit) {
+
+  if(s_running.load()) {
+    return;
+  }
+
+  v_uint64 capacity = 2;
+  while(capacity < bufferSize) {
+    capacity <<= 1;
+  }
+
+  /* never freed - producers may still hold a slot when the logger is stopped */
+  s_records = new Record[capacity];
+  for(v_uint64 i = 0; i < capacity; i ++) {
+    s_records[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  s_mask = capacity - 1;
+  s_enqueuePosition.store(0, std::memory_order_relaxed);
+  s_dequeuePosition = 0;
+  s_rateLimit.store(rateLimit, std::memory_order_relaxed);
+  s_stopping.store(false, std::memory_order_relaxed);
+
+  s_thread = std::thread(&AsyncLogger::run);
+  s_running.store(true, std::memory_order_release);
+
+}
+
+void AsyncLogger::stop() {
+  if(!s_running.exchange(false)) {
+    return;
+  }
+  s_stopping.store(true, std::memory_order_release);
+  if(s_thread.joinable()) {
+    s_thread.join();
+  }
+}
+
+void AsyncLogger::log(v_int32 level, Site& site, const char* format, ...) {
+
+  va_list args;
+  va_start(args, format);
+
+  if(level >= LEVEL_ERROR || !s_running.load(std::memory_order_acquire)) {
+    char buffer[MAX_RECORD_SIZE];
+    AsyncLogger::format(buffer, site, format, args);
+    va_end(args);
+    write(level, site.getTag(), buffer);
+    return;
+  }
+
+  v_uint64 position = s_enqueuePosition.load(std::memory_order_relaxed);
+  Record* record;
+
+  while(true) {
+    record = &s_records[position & s_mask];
+    v_int64 diff = (v_int64) record->sequence.load(std::memory_order_acquire) - (v_int64) position;
+    if(diff == 0) {
+      if(s_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if(diff < 0) {
+      /* buffer is full */
+      va_end(args);
+      s_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      position = s_enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  record->level = level;
+  record->tag = site.getTag();
+  AsyncLogger::format(record->text, site, format, args);
+  va_end(args);
+
+  record->sequence.store(position + 1, std::memory_order_release);
+
+}
+
+v_int64 AsyncLogger::getDroppedRecords() {
+  return s_droppedRecords.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,208 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_AsyncLogger_hpp
+#define Helicopter_utils_AsyncLogger_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <atomic>
+#include <thread>
+#include <cstdarg>
+
+/**
+ * Minimal level compiled in: `0` - debug, `1` - info, `2` - warning, `3` - error.
+ * Debug logs are compiled out of release (NDEBUG) builds by default.
+ */
+#ifndef HELICOPTER_LOG_LEVEL
+  #ifdef NDEBUG
+    #define HELICOPTER_LOG_LEVEL 1
+  #else
+    #define HELICOPTER_LOG_LEVEL 0
+  #endif
+#endif
+
+/**
+ * Asynchronous logger.
+ * Callers format the record straight into a slot of a lock-free ring buffer,
+ * a background thread passes records to the oatpp logger.
+ * When the buffer is full records are dropped (and counted) - callers never block.
+ * Errors and records logged while the logger is not started are written synchronously.
+ */
+class AsyncLogger {
+public:
+
+  enum Level : v_int32 {
+    LEVEL_DEBUG = 0,
+    LEVEL_INFO = 1,
+    LEVEL_WARNING = 2,
+    LEVEL_ERROR = 3
+  };
+
+  /**
+   * Max size of the formatted record including the terminating zero. Longer records are truncated.
+   */
+  static constexpr v_buff_size MAX_RECORD_SIZE = 512;
+
+public:
+
+  /**
+   * Log site - tag + format. Rate limit is applied per site.
+   * Created as a function-local static by the `HELI_LOG*` macros.
+   */
+  class Site {
+  private:
+    const char* m_tag;
+    std::atomic<v_int64> m_window;
+    std::atomic<v_uint32> m_count;
+    std::atomic<v_uint32> m_suppressed;
+  public:
+
+    /**
+     * Constructor.
+     * @param tag
+     */
+    Site(const char* tag);
+
+    /**
+     * Get tag.
+     * @return
+     */
+    const char* getTag() const {
+      return m_tag;
+    }
+
+    /**
+     * Take permit to log a record within the current second.
+     * @return - `false` if the site exceeded the rate limit - record should be skipped.
+     */
+    bool acquire();
+
+    /**
+     * Get and reset the number of records skipped since the last logged record.
+     * @return
+     */
+    v_uint32 takeSuppressed();
+
+  };
+
+private:
+
+  struct Record {
+    std::atomic<v_uint64> sequence;
+    v_int32 level;
+    const char* tag;
+    char text[MAX_RECORD_SIZE];
+  };
+
+private:
+  static Record* s_records;
+  static v_uint64 s_mask;
+  static std::atomic<v_uint64> s_enqueuePosition;
+  static v_uint64 s_dequeuePosition;
+  static std::atomic<v_int64> s_droppedRecords;
+  static std::atomic<v_uint32> s_rateLimit;
+  static std::atomic<bool> s_running;
+  static std::atomic<bool> s_stopping;
+  static std::thread s_thread;
+private:
+  static v_buff_size format(char* buffer, Site& site, const char* format, va_list args);
+  static void write(v_int32 level, const char* tag, const char* text);
+  static bool writeNext();
+  static void run();
+public:
+
+  /**
+   * Allocate ring buffer and start the background thread.
+   * @param bufferSize - number of records in the ring buffer. Rounded up to the power of two.
+   * @param rateLimit - max records per second per log site. `0` - no limit.
+   */
+  static void start(v_uint32 bufferSize, v_uint32 rateLimit);
+
+  /**
+   * Write remaining records and stop the background thread.
+   * Logs after this call are written synchronously.
+   */
+  static void stop();
+
+  /**
+   * Get max records per second per log site.
+   * @return
+   */
+  static v_uint32 getRateLimit() {
+    return s_rateLimit.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Log record. Use `HELI_LOG*` macros instead.
+   * @param level
+   * @param site
+   * @param format - printf-style format.
+   * @param ...
+   */
+  static void log(v_int32 level, Site& site, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+  ;
+
+  /**
+   * Get number of records dropped because the ring buffer was full.
+   * @return
+   */
+  static v_int64 getDroppedRecords();
+
+};
+
+#define HELI_LOG(LEVEL, TAG, ...) \
+do { \
+  static AsyncLogger::Site _heliLogSite(TAG); \
+  if(_heliLogSite.acquire()) { \
+    AsyncLogger::log(LEVEL, _heliLogSite, __VA_ARGS__); \
+  } \
+} while(0)
+
+#if HELICOPTER_LOG_LEVEL <= 0
+  #define HELI_LOGD(TAG, ...) HELI_LOG(AsyncLogger::LEVEL_DEBUG, TAG, __VA_ARGS__)
+#else
+  #define HELI_LOGD(TAG, ...) do {} while(0)
+#endif
+
+#if HELICOPTER_LOG_LEVEL <= 1
+  #define HELI_LOGI(TAG, ...) HELI_LOG(AsyncLogger::LEVEL_INFO, TAG, __VA_ARGS__)
+#else
+  #define HELI_LOGI(TAG, ...) do {} while(0)
+#endif
+
+#if HELICOPTER_LOG_LEVEL <= 2
+  #define HELI_LOGW(TAG, ...) HELI_LOG(AsyncLogger::LEVEL_WARNING, TAG, __VA_ARGS__)
+#else
+  #define HELI_LOGW(TAG, ...) do {} while(0)
+#endif
+
+#define HELI_LOGE(TAG, ...) HELI_LOG(AsyncLogger::LEVEL_ERROR, TAG, __VA_ARGS__)
+
+#endif //Helicopter_utils_AsyncLogger_hpp
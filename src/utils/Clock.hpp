@@ -0,0 +1,90 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_Clock_hpp
+#define Helicopter_utils_Clock_hpp
+
+#include "oatpp/core/base/Environment.hpp"
+
+#include <atomic>
+
+/**
+ * Clock of the ping logic - ping rounds, ping times and handoff reservations.
+ * System clock by default. Tests switch it to manual time to drive ping rules deterministically -
+ * in manual mode game pingers don't run rounds by timer and the test calls `Game::runPingRound()`.
+ */
+class Clock {
+private:
+  static std::atomic<v_int64> s_manualMicros;
+public:
+
+  /**
+   * Get current timestamp in microseconds.
+   * @return
+   */
+  static v_int64 getMicroTickCount() {
+    v_int64 manual = s_manualMicros.load(std::memory_order_relaxed);
+    return manual < 0 ? oatpp::base::Environment::getMicroTickCount() : manual;
+  }
+
+  /**
+   * Convert timestamp taken from the system clock.
+   * @param systemMicros
+   * @return - `systemMicros` or current manual time.
+   */
+  static v_int64 fromSystem(v_int64 systemMicros) {
+    v_int64 manual = s_manualMicros.load(std::memory_order_relaxed);
+    return manual < 0 ? systemMicros : manual;
+  }
+
+  /**
+   * Check if clock is in manual mode.
+   * @return
+   */
+  static bool isManual() {
+    return s_manualMicros.load(std::memory_order_relaxed) >= 0;
+  }
+
+  /**
+   * Switch to manual time.
+   * @param micros - current time. Must be >= 0.
+   */
+  static void setManual(v_int64 micros);
+
+  /**
+   * Advance manual time.
+   * @param micros
+   */
+  static void advance(v_int64 micros);
+
+  /**
+   * Switch back to the system clock.
+   */
+  static void setSystem();
+
+};
+
+#endif //Helicopter_utils_Clock_hpp
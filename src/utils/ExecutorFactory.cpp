@@ -0,0 +1,317 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ExecutorFactory.hpp"
+
+#include "./AsyncLogger.hpp"
+
+#include "oatpp/core/data/stream/BufferStream.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+std::vector<v_int32> ExecutorFactory::parseCpuList(const oatpp::String& cpuList) {
+
+  std::vector<v_int32> result;
+  if(!cpuList) {
+    return result;
+  }
+
+  const std::string& list = *cpuList;
+  size_t pos = 0;
+
+  while(pos < list.size()) {
+
+    auto end = list.find(',', pos);
+    if(end == std::string::npos) {
+      end = list.size();
+    }
+
+    std::string token = list.substr(pos, end - pos);
+    token.erase(std::remove_if(token.begin(), token.end(), ::isspace), token.end());
+    pos = end + 1;
+
+    if(token.empty()) {
+      continue;
+    }
+
+    try {
+      auto dash = token.find('-');
+      if(dash == std::string::npos) {
+        result.push_back(std::stoi(token));
+      } else {
+        v_int32 from = std::stoi(token.substr(0, dash));
+        v_int32 to = std::stoi(token.substr(dash + 1));
+        for(v_int32 cpu = from; cpu <= to; cpu ++) {
+          result.push_back(cpu);
+        }
+      }
+    } catch (const std::exception&) {
+      HELI_LOGE("ExecutorFactory", "Malformed CPU list '%s'", cpuList->c_str());
+      return std::vector<v_int32>();
+    }
+
+  }
+
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+
+  return result;
+
+}
+
+std::vector<v_int32> ExecutorFactory::getNumaNodeCpus(v_int32 node) {
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string line;
+  if(file && std::getline(file, line)) {
+    return parseCpuList(line);
+  }
+  return std::vector<v_int32>();
+}
+
+std::vector<v_int32> ExecutorFactory::getCpus(const oatpp::String& cpuList, const oatpp::Int32& numaNode) {
+
+  auto cpus = parseCpuList(cpuList);
+
+  if(numaNode) {
+
+    auto nodeCpus = getNumaNodeCpus(numaNode);
+    if(nodeCpus.empty()) {
+      HELI_LOGE("ExecutorFactory", "NUMA node %d not found. Ignoring NUMA placement.", *numaNode);
+      return cpus;
+    }
+
+    if(cpus.empty()) {
+      return nodeCpus;
+    }
+
+    std::vector<v_int32> result;
+    std::set_intersection(cpus.begin(), cpus.end(), nodeCpus.begin(), nodeCpus.end(), std::back_inserter(result));
+    if(result.empty()) {
+      HELI_LOGE("ExecutorFactory", "None of CPUs '%s' belongs to NUMA node %d. Ignoring NUMA placement.", cpuList->c_str(), *numaNode);
+      return cpus;
+    }
+    return result;
+
+  }
+
+  return cpus;
+
+}
+
+oatpp::String ExecutorFactory::cpusToString(const std::vector<v_int32>& cpus) {
+  if(cpus.empty()) {
+    return "any";
+  }
+  oatpp::data::stream::BufferOutputStream stream;
+  for(size_t i = 0; i < cpus.size(); i ++) {
+    if(i > 0) {
+      stream << ",";
+    }
+    stream << cpus[i];
+  }
+  return stream.toString();
+}
+
+bool ExecutorFactory::setCurrentThreadAffinity(const std::vector<v_int32>& cpus) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for(auto cpu : cpus) {
+    if(cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+  (void) cpus;
+  return false;
+#endif
+}
+
+bool ExecutorFactory::getCurrentThreadAffinity(std::vector<v_int32>& cpus) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if(pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0) {
+    return false;
+  }
+  for(v_int32 cpu = 0; cpu < CPU_SETSIZE; cpu ++) {
+    if(CPU_ISSET(cpu, &set)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return true;
+#else
+  (void) cpus;
+  return false;
+#endif
+}
+
+v_int32 ExecutorFactory::getIoWorkerType(IoBackend backend, const oatpp::String& name) {
+
+  switch(backend) {
+
+    case IoBackend::NAIVE:
+      return oatpp::async::Executor::IO_WORKER_TYPE_NAIVE;
+
+    case IoBackend::EPOLL:
+#if !defined(__linux__)
+      HELI_LOGE("ExecutorFactory", "Executor '%s': epoll is not available on this platform. Using default event I/O worker.", name->c_str());
+#endif
+      return oatpp::async::Executor::IO_WORKER_TYPE_EVENT;
+
+    case IoBackend::KQUEUE:
+#if !defined(__APPLE__) && !defined(__FreeBSD__) && !defined(__NetBSD__) && !defined(__OpenBSD__)
+      HELI_LOGE("ExecutorFactory", "Executor '%s': kqueue is not available on this platform. Using default event I/O worker.", name->c_str());
+#endif
+      return oatpp::async::Executor::IO_WORKER_TYPE_EVENT;
+
+    case IoBackend::IO_URING:
+      HELI_LOGE("ExecutorFactory", "Executor '%s': io_uring is not supported by executor. Using default event I/O worker.", name->c_str());
+      return oatpp::async::Executor::IO_WORKER_TYPE_EVENT;
+
+    default:
+      return oatpp::async::Executor::VALUE_SUGGESTED;
+
+  }
+
+}
+
+void ExecutorFactory::pinProcessorWorkers(const std::shared_ptr<oatpp::async::Executor>& executor,
+                                          v_int32 workersCount,
+                                          const std::vector<v_int32>& cpus)
+{
+
+  class PinCoroutine : public oatpp::async::Coroutine<PinCoroutine> {
+  private:
+    v_int32 m_cpu;
+  public:
+
+    PinCoroutine(v_int32 cpu)
+      : m_cpu(cpu)
+    {}
+
+    Action act() override {
+      if(!setCurrentThreadAffinity({m_cpu})) {
+        HELI_LOGE("ExecutorFactory", "Can't pin processor worker to CPU %d", m_cpu);
+      }
+      return finish();
+    }
+
+  };
+
+  /* executor spreads coroutines between processor workers round-robin - one coroutine lands on each worker */
+  for(v_int32 i = 0; i < workersCount; i ++) {
+    executor->execute<PinCoroutine>(cpus[i % cpus.size()]);
+  }
+
+  executor->waitTasksFinished();
+
+}
+
+oatpp::Object<ExecutorConfigDto> ExecutorFactory::getConfigOrSingleWorker(const oatpp::Object<ExecutorConfigDto>& config) {
+  if(!config) {
+    return ExecutorConfigDto::createShared(); // field defaults - one worker of each kind
+  }
+  return config;
+}
+
+v_int32 ExecutorFactory::getProcessorWorkersCount(const oatpp::Object<ExecutorConfigDto>& config) {
+  if(!config) {
+    /* oatpp defaults - VALUE_SUGGESTED resolves to the number of hardware threads */
+    return std::max<v_int32>(1, (v_int32) std::thread::hardware_concurrency());
+  }
+  return std::max<v_int32>(1, config->processorWorkers);
+}
+
+std::shared_ptr<oatpp::async::Executor> ExecutorFactory::createExecutor(const oatpp::Object<ExecutorConfigDto>& config,
+                                                                        const oatpp::String& name)
+{
+
+  if(!config) {
+    HELI_LOGI("ExecutorFactory", "Executor '%s': default topology", name->c_str());
+    return std::make_shared<oatpp::async::Executor>();
+  }
+
+  v_int32 processorWorkers = getProcessorWorkersCount(config);
+  v_int32 ioWorkers = std::max<v_int32>(1, config->ioWorkers);
+  v_int32 timerWorkers = std::max<v_int32>(1, config->timerWorkers);
+  v_int32 ioWorkerType = getIoWorkerType(config->ioBackend ? *config->ioBackend : IoBackend::AUTO, name);
+
+  auto processorCpus = getCpus(config->processorCpus, config->processorNumaNode);
+  auto ioCpus = getCpus(config->ioCpus, config->ioNumaNode);
+
+#if !defined(__linux__)
+  if(!processorCpus.empty() || !ioCpus.empty()) {
+    HELI_LOGE("ExecutorFactory", "Executor '%s': CPU pinning is not supported on this platform. Ignoring.", name->c_str());
+    processorCpus.clear();
+    ioCpus.clear();
+  }
+#endif
+
+  /* I/O and timer worker threads inherit affinity of this thread */
+  std::vector<v_int32> originalCpus;
+  bool restoreAffinity = false;
+  if(!ioCpus.empty()) {
+    restoreAffinity = getCurrentThreadAffinity(originalCpus);
+    if(!setCurrentThreadAffinity(ioCpus)) {
+      HELI_LOGE("ExecutorFactory", "Executor '%s': can't pin I/O workers to CPUs %s", name->c_str(), cpusToString(ioCpus)->c_str());
+    }
+  }
+
+  auto executor = std::make_shared<oatpp::async::Executor>(processorWorkers, ioWorkers, timerWorkers, ioWorkerType);
+
+  if(restoreAffinity) {
+    setCurrentThreadAffinity(originalCpus);
+  }
+
+  if(!processorCpus.empty()) {
+    pinProcessorWorkers(executor, processorWorkers, processorCpus);
+  }
+
+  HELI_LOGI("ExecutorFactory", "Executor '%s': processor workers=%d, CPUs=%s",
+             name->c_str(), processorWorkers, cpusToString(processorCpus)->c_str());
+  const char* ioWorkerTypeName = "auto";
+  if(ioWorkerType == oatpp::async::Executor::IO_WORKER_TYPE_NAIVE) {
+    ioWorkerTypeName = "naive";
+  } else if(ioWorkerType == oatpp::async::Executor::IO_WORKER_TYPE_EVENT) {
+    ioWorkerTypeName = "event";
+  }
+
+  HELI_LOGI("ExecutorFactory", "Executor '%s': I/O workers=%d (%s), timer workers=%d, CPUs=%s",
+             name->c_str(), ioWorkers, ioWorkerTypeName, timerWorkers, cpusToString(ioCpus)->c_str());
+
+  return executor;
+
+}
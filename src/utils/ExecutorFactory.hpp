@@ -0,0 +1,92 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_ExecutorFactory_hpp
+#define Helicopter_utils_ExecutorFactory_hpp
+
+#include "config/Config.hpp"
+
+#include "oatpp/core/async/Executor.hpp"
+
+#include <vector>
+
+/**
+ * Creates executors with the configured threads topology and reports it at startup.
+ */
+class ExecutorFactory {
+private:
+  static std::vector<v_int32> getCpus(const oatpp::String& cpuList, const oatpp::Int32& numaNode);
+  static oatpp::String cpusToString(const std::vector<v_int32>& cpus);
+  static bool setCurrentThreadAffinity(const std::vector<v_int32>& cpus);
+  static bool getCurrentThreadAffinity(std::vector<v_int32>& cpus);
+  static v_int32 getIoWorkerType(IoBackend backend, const oatpp::String& name);
+  static void pinProcessorWorkers(const std::shared_ptr<oatpp::async::Executor>& executor,
+                                  v_int32 workersCount,
+                                  const std::vector<v_int32>& cpus);
+public:
+
+  /**
+   * Parse CPU list in the Linux cpulist format - ex.: `"0-3,8,10-11"`.
+   * @param cpuList
+   * @return - CPU numbers. Empty if list is null or malformed.
+   */
+  static std::vector<v_int32> parseCpuList(const oatpp::String& cpuList);
+
+  /**
+   * Get CPUs of NUMA node. Linux only.
+   * @param node
+   * @return - CPU numbers. Empty if node is not found.
+   */
+  static std::vector<v_int32> getNumaNodeCpus(v_int32 node);
+
+  /**
+   * Get config of executor which defaults to one processor, I/O and timer worker instead of oatpp defaults.
+   * @param config - threads topology.
+   * @return - `config` or, if it's null, config with one worker of each kind and no pinning.
+   */
+  static oatpp::Object<ExecutorConfigDto> getConfigOrSingleWorker(const oatpp::Object<ExecutorConfigDto>& config);
+
+  /**
+   * Get number of processor workers of executor created with the config.
+   * @param config - threads topology. null - oatpp defaults, one worker per hardware thread.
+   * @return
+   */
+  static v_int32 getProcessorWorkersCount(const oatpp::Object<ExecutorConfigDto>& config);
+
+  /**
+   * Create executor.
+   * I/O and timer workers inherit CPU affinity of the creating thread - they are created with the affinity of I/O CPUs.
+   * Processor workers are pinned afterwards from within the coroutine running on them.
+   * @param config - threads topology. null - oatpp defaults.
+   * @param name - executor name for the startup report.
+   * @return
+   */
+  static std::shared_ptr<oatpp::async::Executor> createExecutor(const oatpp::Object<ExecutorConfigDto>& config,
+                                                                const oatpp::String& name);
+
+};
+
+#endif //Helicopter_utils_ExecutorFactory_hpp
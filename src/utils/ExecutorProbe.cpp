@@ -0,0 +1,157 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "ExecutorProbe.hpp"
+
+#include <algorithm>
+
+namespace {
+
+  /* weight of the new sample in moving averages */
+  constexpr v_float64 AVERAGE_WEIGHT = 0.2;
+
+}
+
+ExecutorProbe::ExecutorProbe(const oatpp::String& name,
+                             const std::shared_ptr<oatpp::async::Executor>& executor,
+                             v_int32 workersCount,
+                             v_int64 intervalMillis)
+  : m_name(name)
+  , m_executor(executor)
+  , m_state(std::make_shared<State>())
+{
+  m_state->running = false;
+  m_state->intervalMicros = intervalMillis * 1000;
+  for(v_int32 i = 0; i < std::max<v_int32>(1, workersCount); i ++) {
+    auto worker = new Worker();
+    worker->queueDelayAverage = 0;
+    worker->busyRatio = 0;
+    m_state->workers.emplace_back(worker);
+  }
+}
+
+ExecutorProbe::~ExecutorProbe() {
+  stop();
+}
+
+void ExecutorProbe::start() {
+
+  class ProbeCoroutine : public oatpp::async::Coroutine<ProbeCoroutine> {
+  private:
+    std::shared_ptr<State> m_state;
+    Worker* m_worker;
+    v_int64 m_deadline;
+    v_int64 m_yieldTimestamp;
+    bool m_waiting;
+  public:
+
+    ProbeCoroutine(const std::shared_ptr<State>& state, Worker* worker)
+      : m_state(state)
+      , m_worker(worker)
+      , m_deadline(0)
+      , m_yieldTimestamp(0)
+      , m_waiting(false)
+    {}
+
+    Action act() override {
+
+      if(!m_state->running.load(std::memory_order_relaxed)) {
+        return finish();
+      }
+
+      auto timestamp = oatpp::base::Environment::getMicroTickCount();
+
+      if(m_waiting) {
+        /* woken up by timer - measure how late, then go through the worker's queue once */
+        m_waiting = false;
+        m_worker->timerLag.record(timestamp - m_deadline);
+        m_yieldTimestamp = timestamp;
+        return yieldTo(&ProbeCoroutine::onYield);
+      }
+
+      m_deadline = timestamp + m_state->intervalMicros;
+      m_waiting = true;
+      return waitRepeat(std::chrono::microseconds(m_state->intervalMicros));
+
+    }
+
+    Action onYield() {
+
+      v_int64 delay = oatpp::base::Environment::getMicroTickCount() - m_yieldTimestamp;
+      m_worker->queueDelay.record(delay);
+
+      v_float64 average = m_worker->queueDelayAverage.load(std::memory_order_relaxed);
+      m_worker->queueDelayAverage.store(average + (delay - average) * AVERAGE_WEIGHT, std::memory_order_relaxed);
+
+      v_float64 busy = delay >= BUSY_THRESHOLD_MICROS ? 1.0 : 0.0;
+      v_float64 ratio = m_worker->busyRatio.load(std::memory_order_relaxed);
+      m_worker->busyRatio.store(ratio + (busy - ratio) * AVERAGE_WEIGHT, std::memory_order_relaxed);
+
+      return yieldTo(&ProbeCoroutine::act);
+
+    }
+
+  };
+
+  if(m_state->intervalMicros <= 0 || m_state->running.exchange(true)) {
+    return;
+  }
+
+  /* executor assigns coroutines to processor workers by a round-robin counter shared with all other execute() calls -
+   * probes started while other coroutines are being scheduled may share a worker. Per-probe stats are approximately per worker. */
+  for(auto& worker : m_state->workers) {
+    m_executor->execute<ProbeCoroutine>(m_state, worker.get());
+  }
+
+}
+
+void ExecutorProbe::stop() {
+  m_state->running = false;
+}
+
+oatpp::String ExecutorProbe::getName() {
+  return m_name;
+}
+
+std::shared_ptr<oatpp::async::Executor> ExecutorProbe::getExecutor() {
+  return m_executor;
+}
+
+v_int32 ExecutorProbe::getWorkersCount() {
+  return (v_int32) m_state->workers.size();
+}
+
+const ExecutorProbe::Worker& ExecutorProbe::getWorker(v_int32 index) {
+  return *m_state->workers[index];
+}
+
+v_int64 ExecutorProbe::getMaxQueueDelay() {
+  v_float64 result = 0;
+  for(auto& worker : m_state->workers) {
+    result = std::max(result, worker->queueDelayAverage.load(std::memory_order_relaxed));
+  }
+  return (v_int64) result;
+}
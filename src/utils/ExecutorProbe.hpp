@@ -0,0 +1,124 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_ExecutorProbe_hpp
+#define Helicopter_utils_ExecutorProbe_hpp
+
+#include "./LatencyHistogram.hpp"
+
+#include "oatpp/core/async/Executor.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * Executor scheduling probe.
+ * Runs as many probe coroutines as the executor has processor workers. Executor places them round-robin,
+ * so usually - but not necessarily - there is one probe per worker and per-probe stats approximate per-worker stats.
+ * Each tick the probe measures:
+ * - timer lag - how late the timer-based coroutine (like `Pinger`) is woken up comparing to its deadline;
+ * - queue delay - how long a ready coroutine waits in the worker's queue before it runs.
+ * Worker busy ratio is estimated as the share of ticks the probe found other coroutines queued ahead of it.
+ */
+class ExecutorProbe {
+public:
+
+  /**
+   * Coroutines with queue delay above this are considered queued behind other work.
+   */
+  static constexpr v_int64 BUSY_THRESHOLD_MICROS = 50;
+
+  struct Worker {
+    LatencyHistogram timerLag;
+    LatencyHistogram queueDelay;
+    std::atomic<v_float64> queueDelayAverage; // moving average, microseconds
+    std::atomic<v_float64> busyRatio; // moving average
+  };
+
+private:
+
+  struct State {
+    std::atomic<bool> running;
+    v_int64 intervalMicros;
+    std::vector<std::unique_ptr<Worker>> workers;
+  };
+
+private:
+  oatpp::String m_name;
+  std::shared_ptr<oatpp::async::Executor> m_executor;
+  std::shared_ptr<State> m_state;
+public:
+
+  /**
+   * Constructor.
+   * @param name - executor name.
+   * @param executor
+   * @param workersCount - number of processor workers of the executor.
+   * @param intervalMillis - probe interval.
+   */
+  ExecutorProbe(const oatpp::String& name,
+                const std::shared_ptr<oatpp::async::Executor>& executor,
+                v_int32 workersCount,
+                v_int64 intervalMillis);
+
+  /**
+   * Stop probe coroutines.
+   */
+  ~ExecutorProbe();
+
+  /**
+   * Start probe coroutines - as many as processor workers.
+   */
+  void start();
+
+  /**
+   * Stop probe coroutines. They finish on the next tick.
+   */
+  void stop();
+
+  oatpp::String getName();
+
+  std::shared_ptr<oatpp::async::Executor> getExecutor();
+
+  v_int32 getWorkersCount();
+
+  /**
+   * Get stats of the probe. Approximately stats of the processor worker - see class description.
+   * @param index
+   * @return
+   */
+  const Worker& getWorker(v_int32 index);
+
+  /**
+   * Get the highest queue delay moving average across workers.
+   * @return - microseconds.
+   */
+  v_int64 getMaxQueueDelay();
+
+};
+
+#endif //Helicopter_utils_ExecutorProbe_hpp
@@ -0,0 +1,113 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "LatencyHistogram.hpp"
+
+LatencyHistogram::LatencyHistogram() {
+  for(v_int32 i = 0; i < BUCKETS_COUNT; i ++) {
+    m_buckets[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+v_int32 LatencyHistogram::getBucket(v_uint64 value) {
+
+  if(value < (v_uint64) SUB_BUCKETS_COUNT) {
+    return (v_int32) value;
+  }
+
+  if(value >> MAX_VALUE_BITS) {
+    value = (((v_uint64) 1) << MAX_VALUE_BITS) - 1;
+  }
+
+  /* index of the highest set bit - power of two the value falls into */
+  v_int32 magnitude = 63 - __builtin_clzll(value);
+  v_int32 shift = magnitude - SUB_BUCKET_BITS;
+  v_int32 subBucket = (v_int32) ((value >> shift) & (SUB_BUCKETS_COUNT - 1));
+
+  return (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS_COUNT + subBucket;
+
+}
+
+v_int64 LatencyHistogram::getBucketHighestValue(v_int32 bucket) {
+
+  if(bucket < SUB_BUCKETS_COUNT) {
+    return bucket;
+  }
+
+  v_int32 magnitude = bucket / SUB_BUCKETS_COUNT + SUB_BUCKET_BITS - 1;
+  v_int32 subBucket = bucket % SUB_BUCKETS_COUNT;
+  v_int32 shift = magnitude - SUB_BUCKET_BITS;
+
+  return ((v_int64) (SUB_BUCKETS_COUNT + subBucket) << shift) + ((v_int64) 1 << shift) - 1;
+
+}
+
+void LatencyHistogram::record(v_int64 value) {
+  if(value >= 0) {
+    m_buckets[getBucket((v_uint64) value)].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram::Percentiles LatencyHistogram::getPercentiles() const {
+
+  v_uint64 counts[BUCKETS_COUNT];
+  Percentiles result = {0, 0, 0, 0, 0};
+
+  for(v_int32 i = 0; i < BUCKETS_COUNT; i ++) {
+    counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+    result.count += counts[i];
+  }
+
+  if(result.count == 0) {
+    return result;
+  }
+
+  /* rank of the value at percentile - at least the first value */
+  const v_uint64 rank50 = (result.count * 500 + 999) / 1000;
+  const v_uint64 rank99 = (result.count * 990 + 999) / 1000;
+  const v_uint64 rank999 = (result.count * 999 + 999) / 1000;
+
+  v_uint64 cumulative = 0;
+  for(v_int32 i = 0; i < BUCKETS_COUNT; i ++) {
+
+    if(counts[i] == 0) {
+      continue;
+    }
+
+    v_uint64 previous = cumulative;
+    cumulative += counts[i];
+    v_int64 value = getBucketHighestValue(i);
+
+    if(previous < rank50 && cumulative >= rank50) result.p50 = value;
+    if(previous < rank99 && cumulative >= rank99) result.p99 = value;
+    if(previous < rank999 && cumulative >= rank999) result.p999 = value;
+    result.max = value;
+
+  }
+
+  return result;
+
+}
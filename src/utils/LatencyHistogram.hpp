@@ -0,0 +1,84 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_LatencyHistogram_hpp
+#define Helicopter_utils_LatencyHistogram_hpp
+
+#include "oatpp/core/base/Environment.hpp"
+
+#include <atomic>
+
+/**
+ * HDR-style latency histogram.
+ * Log-linear buckets - each power of two is split into 16 sub-buckets, so values are recorded with ~6% precision
+ * from 1 microsecond up to ~12 days. Lock-free, values may be recorded from any thread.
+ */
+class LatencyHistogram {
+public:
+  static constexpr v_int32 SUB_BUCKET_BITS = 4;
+  static constexpr v_int32 SUB_BUCKETS_COUNT = 1 << SUB_BUCKET_BITS;
+  static constexpr v_int32 MAX_VALUE_BITS = 40;
+  static constexpr v_int32 BUCKETS_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS_COUNT;
+public:
+
+  /**
+   * Percentiles. Values are the highest values equivalent to the bucket the percentile falls into.
+   */
+  struct Percentiles {
+    v_uint64 count;
+    v_int64 p50;
+    v_int64 p99;
+    v_int64 p999;
+    v_int64 max;
+  };
+
+private:
+  std::atomic<v_uint64> m_buckets[BUCKETS_COUNT];
+private:
+  static v_int32 getBucket(v_uint64 value);
+  static v_int64 getBucketHighestValue(v_int32 bucket);
+public:
+
+  /**
+   * Constructor. Histogram is created empty.
+   */
+  LatencyHistogram();
+
+  /**
+   * Record value.
+   * @param value - negative values are ignored.
+   */
+  void record(v_int64 value);
+
+  /**
+   * Compute percentiles of the values recorded so far.
+   * @return
+   */
+  Percentiles getPercentiles() const;
+
+};
+
+#endif //Helicopter_utils_LatencyHistogram_hpp
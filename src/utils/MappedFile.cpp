@@ -0,0 +1,139 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "MappedFile.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MappedFile::MappedFile()
+  : m_fd(-1)
+  , m_data(nullptr)
+  , m_capacity(0)
+  , m_size(0)
+  , m_growBytes(0)
+{}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string& path, v_buff_size growBytes) {
+
+  close();
+
+  m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(m_fd < 0) {
+    return false;
+  }
+
+  m_growBytes = growBytes > 0 ? growBytes : 1;
+  m_size = 0;
+  m_capacity = 0;
+
+  if(!reserve(m_growBytes)) {
+    close();
+    return false;
+  }
+
+  return true;
+
+}
+
+bool MappedFile::reserve(v_buff_size size) {
+
+  if(size <= m_capacity) {
+    return true;
+  }
+
+  v_buff_size capacity = ((size + m_growBytes - 1) / m_growBytes) * m_growBytes;
+
+  if(ftruncate(m_fd, capacity) != 0) {
+    return false;
+  }
+
+  /* remap whole file - mremap is not portable */
+  if(m_data != nullptr) {
+    munmap(m_data, m_capacity);
+    m_data = nullptr;
+  }
+
+  void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if(data == MAP_FAILED) {
+    m_capacity = 0;
+    return false;
+  }
+
+  m_data = (p_char8) data;
+  m_capacity = capacity;
+  return true;
+
+}
+
+bool MappedFile::append(const void* data, v_buff_size size) {
+  if(m_fd < 0 || !reserve(m_size + size)) {
+    return false;
+  }
+  std::memcpy(m_data + m_size, data, size);
+  m_size += size;
+  return true;
+}
+
+void MappedFile::write(v_buff_size offset, const void* data, v_buff_size size) {
+  if(m_data != nullptr && offset + size <= m_size) {
+    std::memcpy(m_data + offset, data, size);
+  }
+}
+
+void MappedFile::sync() {
+  if(m_data != nullptr) {
+    msync(m_data, m_capacity, MS_ASYNC);
+  }
+}
+
+void MappedFile::close() {
+
+  if(m_fd < 0) {
+    return;
+  }
+
+  if(m_data != nullptr) {
+    msync(m_data, m_capacity, MS_SYNC);
+    munmap(m_data, m_capacity);
+    m_data = nullptr;
+  }
+
+  if(ftruncate(m_fd, m_size) != 0) {
+    /* file keeps zero tail - readers rely on the size in the header */
+  }
+
+  ::close(m_fd);
+  m_fd = -1;
+  m_capacity = 0;
+
+}
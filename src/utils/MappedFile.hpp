@@ -0,0 +1,118 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_MappedFile_hpp
+#define Helicopter_utils_MappedFile_hpp
+
+#include "oatpp/core/Types.hpp"
+
+#include <string>
+
+/**
+ * Append-only memory-mapped file.
+ * File is grown by `growBytes` chunks and mapped whole. On `close()` it is truncated to the written size.
+ * Not thread-safe - owned by one writer.
+ */
+class MappedFile {
+private:
+  int m_fd;
+  p_char8 m_data;
+  v_buff_size m_capacity;
+  v_buff_size m_size;
+  v_buff_size m_growBytes;
+private:
+  bool reserve(v_buff_size size);
+public:
+
+  /**
+   * Constructor. File is not opened.
+   */
+  MappedFile();
+
+  /**
+   * Non-copyable.
+   */
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Close file if opened.
+   */
+  ~MappedFile();
+
+  /**
+   * Create or truncate file and map it.
+   * @param path
+   * @param growBytes - file is grown by this number of bytes at once.
+   * @return - `false` on error.
+   */
+  bool open(const std::string& path, v_buff_size growBytes);
+
+  /**
+   * Append bytes.
+   * @param data
+   * @param size
+   * @return - `false` if file can't be grown.
+   */
+  bool append(const void* data, v_buff_size size);
+
+  /**
+   * Overwrite already written bytes. Used to update headers.
+   * @param offset
+   * @param data
+   * @param size
+   */
+  void write(v_buff_size offset, const void* data, v_buff_size size);
+
+  /**
+   * Schedule write-back of the mapped pages. Doesn't wait for the disk.
+   */
+  void sync();
+
+  /**
+   * Write back, unmap and truncate file to the written size.
+   */
+  void close();
+
+  /**
+   * Check if file is opened.
+   * @return
+   */
+  bool isOpen() const {
+    return m_fd >= 0;
+  }
+
+  /**
+   * Get number of bytes written.
+   * @return
+   */
+  v_buff_size getSize() const {
+    return m_size;
+  }
+
+};
+
+#endif //Helicopter_utils_MappedFile_hpp
@@ -0,0 +1,173 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Metrics.hpp"
+
+namespace {
+
+  const v_int32 SLOT_CODES[Metrics::CODE_SLOTS_COUNT] = {
+    static_cast<v_int32>(MessageCodes::OUTGOING_HELLO),
+    static_cast<v_int32>(MessageCodes::OUTGOING_PING),
+    static_cast<v_int32>(MessageCodes::INCOMING_PONG),
+    static_cast<v_int32>(MessageCodes::OUTGOING_ERROR),
+    static_cast<v_int32>(MessageCodes::OUTGOING_NEW_HOST),
+    static_cast<v_int32>(MessageCodes::OUTGOING_MESSAGE),
+    static_cast<v_int32>(MessageCodes::INCOMING_BROADCAST),
+    static_cast<v_int32>(MessageCodes::INCOMING_DIRECT_MESSAGE),
+    static_cast<v_int32>(MessageCodes::INCOMING_SYNCHRONIZED_EVENT),
+    static_cast<v_int32>(MessageCodes::OUTGOING_SYNCHRONIZED_EVENT),
+    static_cast<v_int32>(MessageCodes::INCOMING_AREA_OF_INTEREST),
+    static_cast<v_int32>(MessageCodes::INCOMING_SPATIAL_BROADCAST),
+    static_cast<v_int32>(MessageCodes::OUTGOING_RECONNECT),
+    static_cast<v_int32>(MessageCodes::OUTGOING_HOST_CLIENT_JOINED),
+    static_cast<v_int32>(MessageCodes::OUTGOING_HOST_CLIENT_LEFT),
+    static_cast<v_int32>(MessageCodes::INCOMING_HOST_KICK_CLIENTS),
+    static_cast<v_int32>(MessageCodes::INCOMING_HOST_STATE_UPDATE),
+    static_cast<v_int32>(MessageCodes::OUTGOING_CLIENT_KICKED),
+    static_cast<v_int32>(MessageCodes::OUTGOING_CLIENT_STATE_DELTA),
+    static_cast<v_int32>(MessageCodes::INCOMING_CLIENT_MESSAGE),
+    static_cast<v_int32>(MessageCodes::INCOMING_CLIENT_STATE_ACK),
+    -1 // unknown
+  };
+
+  const char* const COUNTER_NAMES[Metrics::COUNTERS_COUNT] = {
+    "helicopter_queue_overflow_drops_total",
+    "helicopter_kicks_total",
+    "helicopter_failed_pings_total",
+    "helicopter_relay_overflows_total"
+  };
+
+  void writePerCode(oatpp::data::stream::ConsistentOutputStream* stream,
+                    const char* name,
+                    const char* help,
+                    const v_uint64* values)
+  {
+    *stream << "# HELP " << name << " " << help << "\n";
+    *stream << "# TYPE " << name << " counter\n";
+    for(v_int32 slot = 0; slot < Metrics::CODE_SLOTS_COUNT; slot ++) {
+      if(values[slot] > 0) {
+        *stream << name << "{code=\"" << Metrics::getSlotCode(slot) << "\"} " << values[slot] << "\n";
+      }
+    }
+  }
+
+}
+
+LatencyHistogram& Metrics::getHistogram(Latency kind, v_int32 slot) {
+  static LatencyHistogram histograms[LATENCY_KINDS_COUNT][CODE_SLOTS_COUNT];
+  return histograms[kind][slot];
+}
+
+LatencyHistogram::Percentiles Metrics::getLatency(Latency kind, v_int32 slot) {
+  return getHistogram(kind, slot).getPercentiles();
+}
+
+std::mutex& Metrics::getBlocksMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<Metrics::Block*>& Metrics::getBlocks() {
+  static std::vector<Block*> blocks;
+  return blocks;
+}
+
+Metrics::Block* Metrics::registerBlock() {
+  /* blocks are never freed - counts of finished threads stay in totals */
+  auto block = new Block();
+  std::lock_guard<std::mutex> lock(getBlocksMutex());
+  getBlocks().push_back(block);
+  return block;
+}
+
+v_int32 Metrics::getCodeSlot(v_int32 code) {
+  switch(static_cast<MessageCodes>(code)) {
+    case MessageCodes::OUTGOING_HELLO: return 0;
+    case MessageCodes::OUTGOING_PING: return 1;
+    case MessageCodes::INCOMING_PONG: return 2;
+    case MessageCodes::OUTGOING_ERROR: return 3;
+    case MessageCodes::OUTGOING_NEW_HOST: return 4;
+    case MessageCodes::OUTGOING_MESSAGE: return 5;
+    case MessageCodes::INCOMING_BROADCAST: return 6;
+    case MessageCodes::INCOMING_DIRECT_MESSAGE: return 7;
+    case MessageCodes::INCOMING_SYNCHRONIZED_EVENT: return 8;
+    case MessageCodes::OUTGOING_SYNCHRONIZED_EVENT: return 9;
+    case MessageCodes::INCOMING_AREA_OF_INTEREST: return 10;
+    case MessageCodes::INCOMING_SPATIAL_BROADCAST: return 11;
+    case MessageCodes::OUTGOING_RECONNECT: return 12;
+    case MessageCodes::OUTGOING_HOST_CLIENT_JOINED: return 13;
+    case MessageCodes::OUTGOING_HOST_CLIENT_LEFT: return 14;
+    case MessageCodes::INCOMING_HOST_KICK_CLIENTS: return 15;
+    case MessageCodes::INCOMING_HOST_STATE_UPDATE: return 16;
+    case MessageCodes::OUTGOING_CLIENT_KICKED: return 17;
+    case MessageCodes::OUTGOING_CLIENT_STATE_DELTA: return 18;
+    case MessageCodes::INCOMING_CLIENT_MESSAGE: return 19;
+    case MessageCodes::INCOMING_CLIENT_STATE_ACK: return 20;
+    default:
+      return CODE_SLOTS_COUNT - 1;
+  }
+}
+
+v_int32 Metrics::getSlotCode(v_int32 slot) {
+  return SLOT_CODES[slot];
+}
+
+Metrics::Totals Metrics::collect() {
+
+  Totals totals = {};
+
+  std::lock_guard<std::mutex> lock(getBlocksMutex());
+  for(auto block : getBlocks()) {
+    for(v_int32 i = 0; i < COUNTERS_COUNT; i ++) {
+      totals.counters[i] += block->counters[i].load(std::memory_order_relaxed);
+    }
+    for(v_int32 i = 0; i < CODE_SLOTS_COUNT; i ++) {
+      totals.messagesIn[i] += block->messagesIn[i].load(std::memory_order_relaxed);
+      totals.bytesIn[i] += block->bytesIn[i].load(std::memory_order_relaxed);
+      totals.messagesOut[i] += block->messagesOut[i].load(std::memory_order_relaxed);
+      totals.bytesOut[i] += block->bytesOut[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  return totals;
+
+}
+
+void Metrics::writeCounters(oatpp::data::stream::ConsistentOutputStream* stream) {
+
+  auto totals = collect();
+
+  writePerCode(stream, "helicopter_messages_in_total", "Messages received from peers.", totals.messagesIn);
+  writePerCode(stream, "helicopter_bytes_in_total", "Bytes received from peers.", totals.bytesIn);
+  writePerCode(stream, "helicopter_messages_out_total", "Messages sent to peers.", totals.messagesOut);
+  writePerCode(stream, "helicopter_bytes_out_total", "Bytes sent to peers.", totals.bytesOut);
+
+  for(v_int32 i = 0; i < COUNTERS_COUNT; i ++) {
+    *stream << "# TYPE " << COUNTER_NAMES[i] << " counter\n";
+    *stream << COUNTER_NAMES[i] << " " << totals.counters[i] << "\n";
+  }
+
+}
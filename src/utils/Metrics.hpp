@@ -0,0 +1,223 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_Metrics_hpp
+#define Helicopter_utils_Metrics_hpp
+
+#include "./LatencyHistogram.hpp"
+
+#include "dto/DTOs.hpp"
+
+#include "oatpp/core/data/stream/Stream.hpp"
+
+#include <atomic>
+#include <vector>
+#include <mutex>
+
+/**
+ * Server counters.
+ * Each thread increments its own block of counters - no shared cache lines, no read-modify-write atomics.
+ * Blocks are merged only when metrics are scraped.
+ */
+class Metrics {
+public:
+
+  enum Counter : v_int32 {
+
+    /**
+     * Messages dropped because peer's outgoing queue is full.
+     */
+    QUEUE_OVERFLOW_DROPS = 0,
+
+    /**
+     * Peers kicked - by host or for exceeding rate limits.
+     */
+    KICKS = 1,
+
+    /**
+     * Pings not answered in time.
+     */
+    FAILED_PINGS = 2,
+
+    /**
+     * Relay links closed because their outbox is full.
+     */
+    RELAY_OVERFLOWS = 3,
+
+    COUNTERS_COUNT = 4
+
+  };
+
+  enum Latency : v_int32 {
+
+    /**
+     * From the moment the inbound message is read till the write of the outgoing message is complete.
+     */
+    LATENCY_END_TO_END = 0,
+
+    /**
+     * Time outgoing message spent in peer's queue.
+     */
+    LATENCY_QUEUE_WAIT = 1,
+
+    /**
+     * From dequeue till the write is complete (including wait for the peer's write lock).
+     */
+    LATENCY_WRITE = 2,
+
+    LATENCY_KINDS_COUNT = 3
+
+  };
+
+  /**
+   * Number of `MessageCodes` values + one slot for unknown codes.
+   */
+  static constexpr v_int32 CODE_SLOTS_COUNT = 22;
+
+public:
+
+  /**
+   * Counters merged from all threads.
+   */
+  struct Totals {
+    v_uint64 counters[COUNTERS_COUNT];
+    v_uint64 messagesIn[CODE_SLOTS_COUNT];
+    v_uint64 bytesIn[CODE_SLOTS_COUNT];
+    v_uint64 messagesOut[CODE_SLOTS_COUNT];
+    v_uint64 bytesOut[CODE_SLOTS_COUNT];
+  };
+
+private:
+
+  /* written by the owner thread only, read by scraper */
+  struct Block {
+    std::atomic<v_uint64> counters[COUNTERS_COUNT];
+    std::atomic<v_uint64> messagesIn[CODE_SLOTS_COUNT];
+    std::atomic<v_uint64> bytesIn[CODE_SLOTS_COUNT];
+    std::atomic<v_uint64> messagesOut[CODE_SLOTS_COUNT];
+    std::atomic<v_uint64> bytesOut[CODE_SLOTS_COUNT];
+  };
+
+private:
+
+  static LatencyHistogram& getHistogram(Latency kind, v_int32 slot);
+  static std::mutex& getBlocksMutex();
+  static std::vector<Block*>& getBlocks();
+  static Block* registerBlock();
+
+  static Block& getBlock() {
+    static thread_local Block* block = registerBlock();
+    return *block;
+  }
+
+  static void add(std::atomic<v_uint64>& counter, v_uint64 value) {
+    /* single writer - plain load/store is enough */
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+public:
+
+  /**
+   * Map message code to counter slot.
+   * @param code - `MessageCodes` value.
+   * @return - slot. `CODE_SLOTS_COUNT - 1` for unknown codes.
+   */
+  static v_int32 getCodeSlot(v_int32 code);
+
+  /**
+   * Get message code of the counter slot.
+   * @param slot
+   * @return - `MessageCodes` value. `-1` for the unknown codes slot.
+   */
+  static v_int32 getSlotCode(v_int32 slot);
+
+  /**
+   * Increment counter of the calling thread.
+   * @param counter
+   * @param value
+   */
+  static void increment(Counter counter, v_uint64 value = 1) {
+    add(getBlock().counters[counter], value);
+  }
+
+  /**
+   * Count message received from peer.
+   * @param code - `MessageCodes` value.
+   * @param bytes - serialized message size.
+   */
+  static void countIncoming(v_int32 code, v_uint64 bytes) {
+    auto& block = getBlock();
+    auto slot = getCodeSlot(code);
+    add(block.messagesIn[slot], 1);
+    add(block.bytesIn[slot], bytes);
+  }
+
+  /**
+   * Count message sent to peers.
+   * @param code - `MessageCodes` value.
+   * @param bytes - serialized message size.
+   * @param recipients - number of peers the same message is sent to.
+   */
+  static void countOutgoing(v_int32 code, v_uint64 bytes, v_uint64 recipients = 1) {
+    auto& block = getBlock();
+    auto slot = getCodeSlot(code);
+    add(block.messagesOut[slot], recipients);
+    add(block.bytesOut[slot], bytes * recipients);
+  }
+
+  /**
+   * Record latency of outgoing message.
+   * @param kind
+   * @param code - `MessageCodes` value of the outgoing message.
+   * @param micros
+   */
+  static void recordLatency(Latency kind, v_int32 code, v_int64 micros) {
+    getHistogram(kind, getCodeSlot(code)).record(micros);
+  }
+
+  /**
+   * Get latency percentiles.
+   * @param kind
+   * @param slot - code slot.
+   * @return
+   */
+  static LatencyHistogram::Percentiles getLatency(Latency kind, v_int32 slot);
+
+  /**
+   * Merge counters of all threads.
+   * @return
+   */
+  static Totals collect();
+
+  /**
+   * Write merged counters in Prometheus text exposition format.
+   * @param stream
+   */
+  static void writeCounters(oatpp::data::stream::ConsistentOutputStream* stream);
+
+};
+
+#endif //Helicopter_utils_Metrics_hpp
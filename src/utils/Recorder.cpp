@@ -0,0 +1,348 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Recorder.hpp"
+
+#include "./AsyncLogger.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+constexpr const char* RecordingFormat::DATA_MAGIC;
+constexpr const char* RecordingFormat::INDEX_MAGIC;
+constexpr v_uint32 RecordingFormat::VERSION;
+constexpr v_uint16 RecordingFormat::TYPE_INBOUND;
+constexpr v_uint16 RecordingFormat::TYPE_SYNCHRONIZED_EVENT;
+
+Recording::Recording(const oatpp::String& gameId, const oatpp::String& sessionId, v_buff_size maxBufferedBytes)
+  : m_gameId(gameId ? *gameId : std::string())
+  , m_sessionId(sessionId ? *sessionId : std::string())
+  , m_maxBufferedBytes(maxBufferedBytes)
+  , m_lastTimestamp(0)
+  , m_closed(false)
+  , m_droppedRecords(0)
+{}
+
+bool Recording::append(v_uint16 type, v_int64 timestampMicros, v_int64 peerId, v_int64 eventId, const oatpp::String& data) {
+
+  v_buff_size dataSize = data ? data->size() : 0;
+  v_buff_size recordSize = sizeof(RecordingFormat::RecordHeader) + RecordingFormat::align(dataSize);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if(m_closed) {
+    return false;
+  }
+
+  if((v_buff_size) m_buffer.size() + recordSize > m_maxBufferedBytes) {
+    m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /* records of different threads may come slightly out of order - keep timestamps non-decreasing for the index */
+  if(timestampMicros < m_lastTimestamp) {
+    timestampMicros = m_lastTimestamp;
+  }
+  m_lastTimestamp = timestampMicros;
+
+  RecordingFormat::RecordHeader header;
+  header.size = (v_uint32) dataSize;
+  header.type = type;
+  header.reserved = 0;
+  header.timestampMicros = timestampMicros;
+  header.peerId = peerId;
+  header.eventId = eventId;
+
+  m_buffer.append((const char*) &header, sizeof(header));
+  if(dataSize > 0) {
+    m_buffer.append(data->data(), dataSize);
+  }
+  m_buffer.append(RecordingFormat::align(dataSize) - dataSize, '\0');
+
+  return true;
+
+}
+
+void Recording::close() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_closed = true;
+}
+
+v_int64 Recording::getDroppedRecords() {
+  return m_droppedRecords.load(std::memory_order_relaxed);
+}
+
+Recorder::Recorder(const oatpp::Object<RecordingConfigDto>& config)
+  : m_maxBufferedBytes(0)
+  , m_flushMillis(0)
+  , m_fileGrowBytes(0)
+  , m_indexIntervalBytes(0)
+  , m_running(false)
+{
+
+  if(!config || !config->directory) {
+    return;
+  }
+
+  m_directory = config->directory;
+  m_maxBufferedBytes = config->maxBufferedBytes;
+  m_flushMillis = config->flushMillis;
+  m_fileGrowBytes = config->fileGrowBytes;
+  m_indexIntervalBytes = config->indexIntervalBytes;
+  m_running = true;
+
+  m_thread = std::thread(&Recorder::run, this);
+
+  HELI_LOGI("Recorder", "Recording sessions to '%s'", m_directory->c_str());
+
+}
+
+Recorder::~Recorder() {
+  if(m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running = false;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+  }
+}
+
+std::string Recorder::sanitize(const std::string& name) {
+  std::string result = name;
+  for(auto& c : result) {
+    if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.')) {
+      c = '_';
+    }
+  }
+  return result;
+}
+
+std::shared_ptr<Recording> Recorder::startRecording(const oatpp::String& gameId, const oatpp::String& sessionId) {
+
+  if(!m_directory) {
+    return nullptr;
+  }
+
+  /* files are created by the writer thread - session creation doesn't wait for the disk */
+  auto writer = std::make_shared<Writer>();
+  writer->recording = std::make_shared<Recording>(gameId, sessionId, m_maxBufferedBytes);
+  writer->startMicros = oatpp::base::Environment::getMicroTickCount();
+  writer->headerSize = 0;
+  writer->nextIndexOffset = 0;
+  writer->indexEntries = 0;
+  writer->nextEventId = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_writers.push_back(writer);
+  }
+
+  return writer->recording;
+
+}
+
+bool Recorder::open(Writer& writer, v_int64 startMicros) {
+
+  auto& recording = *writer.recording;
+  std::string path = std::string(m_directory->c_str()) + "/" + sanitize(recording.m_gameId) + "-" +
+                     sanitize(recording.m_sessionId) + "-" + std::to_string(startMicros);
+
+  if(!writer.data.open(path + ".hrec", m_fileGrowBytes) ||
+     !writer.index.open(path + ".hidx", std::max<v_buff_size>(4096, m_fileGrowBytes / 64)))
+  {
+    HELI_LOGE("Recorder", "Can't create recording '%s'. Session is not recorded.", path.c_str());
+    return false;
+  }
+
+  RecordingFormat::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, RecordingFormat::DATA_MAGIC, sizeof(header.magic));
+  header.version = RecordingFormat::VERSION;
+  header.startMicros = startMicros;
+  header.gameIdSize = (v_uint32) recording.m_gameId.size();
+  header.sessionIdSize = (v_uint32) recording.m_sessionId.size();
+  header.headerSize = (v_uint32) (sizeof(header) +
+                                  RecordingFormat::align(header.gameIdSize) +
+                                  RecordingFormat::align(header.sessionIdSize));
+
+  std::string names = recording.m_gameId;
+  names.append(RecordingFormat::align(header.gameIdSize) - header.gameIdSize, '\0');
+  names.append(recording.m_sessionId);
+  names.append(RecordingFormat::align(header.sessionIdSize) - header.sessionIdSize, '\0');
+
+  RecordingFormat::IndexHeader indexHeader;
+  std::memset(&indexHeader, 0, sizeof(indexHeader));
+  std::memcpy(indexHeader.magic, RecordingFormat::INDEX_MAGIC, sizeof(indexHeader.magic));
+  indexHeader.version = RecordingFormat::VERSION;
+  indexHeader.entrySize = sizeof(RecordingFormat::IndexEntry);
+
+  if(!writer.data.append(&header, sizeof(header)) ||
+     !writer.data.append(names.data(), names.size()) ||
+     !writer.index.append(&indexHeader, sizeof(indexHeader)))
+  {
+    HELI_LOGE("Recorder", "Can't write recording '%s'. Session is not recorded.", path.c_str());
+    return false;
+  }
+
+  writer.headerSize = header.headerSize;
+  writer.nextIndexOffset = header.headerSize;
+
+  return true;
+
+}
+
+bool Recorder::flush(Writer& writer) {
+
+  {
+    std::lock_guard<std::mutex> lock(writer.recording->m_mutex);
+    writer.batch.swap(writer.recording->m_buffer);
+  }
+
+  if(writer.batch.empty()) {
+    return true;
+  }
+
+  v_buff_size base = writer.data.getSize();
+  if(!writer.data.append(writer.batch.data(), writer.batch.size())) {
+    writer.batch.clear();
+    return false;
+  }
+
+  /* commit - readers trust only `dataSize` bytes of records */
+  v_uint64 dataSize = writer.data.getSize() - writer.headerSize;
+  writer.data.write(offsetof(RecordingFormat::FileHeader, dataSize), &dataSize, sizeof(dataSize));
+
+  /* index the first record after each `indexIntervalBytes` */
+  v_uint64 indexEntries = writer.indexEntries;
+  v_buff_size position = 0;
+  while(position < (v_buff_size) writer.batch.size()) {
+
+    RecordingFormat::RecordHeader header;
+    std::memcpy(&header, writer.batch.data() + position, sizeof(header));
+
+    v_buff_size offset = base + position;
+    if(offset >= writer.nextIndexOffset) {
+      RecordingFormat::IndexEntry entry;
+      entry.timestampMicros = header.timestampMicros;
+      entry.nextEventId = writer.nextEventId;
+      entry.offset = offset;
+      if(writer.index.append(&entry, sizeof(entry))) {
+        writer.indexEntries ++;
+      }
+      writer.nextIndexOffset = offset + m_indexIntervalBytes;
+    }
+
+    if(header.type == RecordingFormat::TYPE_SYNCHRONIZED_EVENT) {
+      writer.nextEventId = header.eventId + 1;
+    }
+
+    position += sizeof(header) + RecordingFormat::align(header.size);
+
+  }
+
+  /* commit - readers trust only `entriesCount` entries. Unwritten tail of the mapped file is zero-filled */
+  if(writer.indexEntries != indexEntries) {
+    writer.index.write(offsetof(RecordingFormat::IndexHeader, entriesCount), &writer.indexEntries, sizeof(writer.indexEntries));
+  }
+
+  writer.batch.clear();
+
+  writer.data.sync();
+  writer.index.sync();
+
+  return true;
+
+}
+
+void Recorder::finish(Writer& writer) {
+
+  writer.recording->close();
+
+  if(writer.headerSize > 0 && !flush(writer)) {
+    HELI_LOGE("Recorder", "Can't write recording of session '%s'. Recording stopped.", writer.recording->m_sessionId.c_str());
+  }
+
+  writer.data.close();
+  writer.index.close();
+
+  v_int64 dropped = writer.recording->getDroppedRecords();
+  if(dropped > 0) {
+    HELI_LOGW("Recorder", "Recording of session '%s' - %lld records dropped.", writer.recording->m_sessionId.c_str(), (long long) dropped);
+  }
+
+}
+
+void Recorder::run() {
+
+  std::vector<std::shared_ptr<Writer>> writers;
+  std::vector<std::shared_ptr<Writer>> finished;
+  bool running = true;
+
+  while(running) {
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait_for(lock, std::chrono::milliseconds(m_flushMillis), [this] { return !m_running; });
+      running = m_running;
+      writers.assign(m_writers.begin(), m_writers.end());
+    }
+
+    for(auto& writer : writers) {
+
+      /* read before flush - nothing is appended after close */
+      bool closed = writer->recording->m_closed;
+
+      if(writer->headerSize == 0) {
+        if(!open(*writer, writer->startMicros)) {
+          finish(*writer);
+          finished.push_back(writer);
+          continue;
+        }
+      }
+
+      if(closed || !running || !flush(*writer)) {
+        finish(*writer);
+        finished.push_back(writer);
+      }
+
+    }
+
+    if(!finished.empty()) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for(auto& writer : finished) {
+        m_writers.remove(writer);
+      }
+    }
+
+    writers.clear();
+    finished.clear();
+
+  }
+
+}
@@ -0,0 +1,226 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_Recorder_hpp
+#define Helicopter_utils_Recorder_hpp
+
+#include "./MappedFile.hpp"
+
+#include "config/Config.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Binary format of session recordings.
+ * All integers are little-endian, records are 8-byte aligned.
+ *
+ * Data file (`.hrec`): `FileHeader`, game ID and session ID strings padded to 8 bytes, then records.
+ * Each record is `RecordHeader` followed by `size` bytes of data padded to 8 bytes.
+ * Only first `FileHeader::dataSize` bytes of records are valid - it's updated after records are flushed.
+ *
+ * Index file (`.hidx`): `IndexHeader`, then `IndexEntry` for the first record after every `indexIntervalBytes`
+ * of records. Both timestamps and `nextEventId` of entries are non-decreasing - entries are binary-searched.
+ * Only first `IndexHeader::entriesCount` entries are valid - it's updated after entries are flushed.
+ */
+class RecordingFormat {
+public:
+
+  static constexpr const char* DATA_MAGIC = "HELIREC";
+  static constexpr const char* INDEX_MAGIC = "HELIIDX";
+  static constexpr v_uint32 VERSION = 1;
+
+  /**
+   * Inbound message as received from the peer.
+   */
+  static constexpr v_uint16 TYPE_INBOUND = 0;
+
+  /**
+   * Synchronized event as broadcasted by the session.
+   */
+  static constexpr v_uint16 TYPE_SYNCHRONIZED_EVENT = 1;
+
+  struct FileHeader {
+    char magic[8];
+    v_uint32 version;
+    v_uint32 headerSize; // including padded game ID and session ID
+    v_int64 startMicros;
+    v_uint64 dataSize;
+    v_uint32 gameIdSize;
+    v_uint32 sessionIdSize;
+  };
+
+  struct RecordHeader {
+    v_uint32 size;
+    v_uint16 type;
+    v_uint16 reserved;
+    v_int64 timestampMicros;
+    v_int64 peerId;
+    v_int64 eventId; // -1 for inbound messages
+  };
+
+  struct IndexHeader {
+    char magic[8];
+    v_uint32 version;
+    v_uint32 entrySize;
+    v_uint64 entriesCount;
+  };
+
+  struct IndexEntry {
+    v_int64 timestampMicros; // timestamp of the record at offset
+    v_int64 nextEventId;     // all synchronized events at or after offset have eventId >= nextEventId
+    v_uint64 offset;         // offset of the record from the beginning of the data file
+  };
+
+  static v_buff_size align(v_buff_size size) {
+    return (size + 7) & ~((v_buff_size) 7);
+  }
+
+};
+
+/**
+ * Recording of one session.
+ * Records are appended to the in-memory buffer under a short lock and written to file by `Recorder` thread.
+ */
+class Recording {
+  friend class Recorder;
+private:
+  std::string m_gameId;
+  std::string m_sessionId;
+  v_buff_size m_maxBufferedBytes;
+  std::string m_buffer;
+  v_int64 m_lastTimestamp;
+  std::mutex m_mutex;
+  std::atomic<bool> m_closed;
+  std::atomic<v_int64> m_droppedRecords;
+public:
+
+  /**
+   * Constructor.
+   * @param gameId
+   * @param sessionId
+   * @param maxBufferedBytes - records over the limit are dropped.
+   */
+  Recording(const oatpp::String& gameId, const oatpp::String& sessionId, v_buff_size maxBufferedBytes);
+
+  /**
+   * Append record. Never blocks on I/O.
+   * @param type - `RecordingFormat::TYPE_*`.
+   * @param timestampMicros
+   * @param peerId
+   * @param eventId - `-1` for inbound messages.
+   * @param data
+   * @return - `false` if record is dropped because buffer is full.
+   */
+  bool append(v_uint16 type, v_int64 timestampMicros, v_int64 peerId, v_int64 eventId, const oatpp::String& data);
+
+  /**
+   * Finish recording. Buffered records are written and files are closed by `Recorder`.
+   */
+  void close();
+
+  /**
+   * Get number of records dropped because the writer couldn't keep up.
+   * @return
+   */
+  v_int64 getDroppedRecords();
+
+};
+
+/**
+ * Session recorder.
+ * One background thread flushes buffers of all recordings to memory-mapped append-only files.
+ */
+class Recorder {
+private:
+
+  struct Writer {
+    std::shared_ptr<Recording> recording;
+    MappedFile data;
+    MappedFile index;
+    std::string batch;
+    v_int64 startMicros;
+    v_buff_size headerSize; // 0 - files are not created yet
+    v_buff_size nextIndexOffset;
+    v_uint64 indexEntries;
+    v_int64 nextEventId;
+  };
+
+private:
+  oatpp::String m_directory;
+  v_buff_size m_maxBufferedBytes;
+  v_uint32 m_flushMillis;
+  v_buff_size m_fileGrowBytes;
+  v_buff_size m_indexIntervalBytes;
+private:
+  std::list<std::shared_ptr<Writer>> m_writers;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_running;
+  std::thread m_thread;
+private:
+  static std::string sanitize(const std::string& name);
+  bool open(Writer& writer, v_int64 startMicros);
+  bool flush(Writer& writer);
+  void finish(Writer& writer);
+  void run();
+public:
+
+  /**
+   * Constructor.
+   * @param config - null - recording is disabled.
+   */
+  Recorder(const oatpp::Object<RecordingConfigDto>& config);
+
+  /**
+   * Flush and close all recordings and stop the background thread.
+   */
+  ~Recorder();
+
+  /**
+   * Check if recording is enabled.
+   * @return
+   */
+  bool isEnabled() const {
+    return m_directory != nullptr;
+  }
+
+  /**
+   * Start recording of the session.
+   * @param gameId
+   * @param sessionId
+   * @return - recording or `nullptr` if recording is disabled or files can't be created.
+   */
+  std::shared_ptr<Recording> startRecording(const oatpp::String& gameId, const oatpp::String& sessionId);
+
+};
+
+#endif //Helicopter_utils_Recorder_hpp
@@ -0,0 +1,233 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "RecordingReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+RecordingReader::RecordingReader()
+  : m_endOffset(0)
+  , m_indexEntries(0)
+{
+  std::memset(&m_header, 0, sizeof(m_header));
+}
+
+RecordingReader::~RecordingReader() {
+  close();
+}
+
+bool RecordingReader::map(const std::string& path, Mapping& mapping) {
+
+  mapping.fd = ::open(path.c_str(), O_RDONLY);
+  if(mapping.fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if(fstat(mapping.fd, &info) != 0 || info.st_size == 0) {
+    unmap(mapping);
+    return false;
+  }
+
+  void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, mapping.fd, 0);
+  if(data == MAP_FAILED) {
+    unmap(mapping);
+    return false;
+  }
+
+  mapping.data = (p_char8) data;
+  mapping.size = info.st_size;
+  return true;
+
+}
+
+void RecordingReader::unmap(Mapping& mapping) {
+  if(mapping.data != nullptr) {
+    munmap(mapping.data, mapping.size);
+    mapping.data = nullptr;
+  }
+  if(mapping.fd >= 0) {
+    ::close(mapping.fd);
+    mapping.fd = -1;
+  }
+  mapping.size = 0;
+}
+
+bool RecordingReader::open(const std::string& path) {
+
+  close();
+
+  if(!map(path, m_data) || m_data.size < (v_buff_size) sizeof(m_header)) {
+    close();
+    return false;
+  }
+
+  std::memcpy(&m_header, m_data.data, sizeof(m_header));
+
+  if(std::memcmp(m_header.magic, RecordingFormat::DATA_MAGIC, sizeof(m_header.magic)) != 0 ||
+     m_header.version != RecordingFormat::VERSION ||
+     (v_buff_size) m_header.headerSize > m_data.size)
+  {
+    close();
+    return false;
+  }
+
+  const char* names = (const char*) m_data.data + sizeof(m_header);
+  m_gameId.assign(names, m_header.gameIdSize);
+  m_sessionId.assign(names + RecordingFormat::align(m_header.gameIdSize), m_header.sessionIdSize);
+
+  /* records past the committed size may be partially written */
+  m_endOffset = std::min<v_buff_size>(m_header.headerSize + m_header.dataSize, m_data.size);
+
+  /* index is optional */
+  std::string indexPath = path;
+  if(indexPath.size() > 5 && indexPath.compare(indexPath.size() - 5, 5, ".hrec") == 0) {
+    indexPath.replace(indexPath.size() - 5, 5, ".hidx");
+    if(map(indexPath, m_index) && m_index.size >= (v_buff_size) sizeof(RecordingFormat::IndexHeader)) {
+      RecordingFormat::IndexHeader indexHeader;
+      std::memcpy(&indexHeader, m_index.data, sizeof(indexHeader));
+      if(std::memcmp(indexHeader.magic, RecordingFormat::INDEX_MAGIC, sizeof(indexHeader.magic)) == 0 &&
+         indexHeader.entrySize == sizeof(RecordingFormat::IndexEntry))
+      {
+        m_indexEntries = std::min<v_buff_size>((v_buff_size) indexHeader.entriesCount,
+                                               (m_index.size - sizeof(indexHeader)) / sizeof(RecordingFormat::IndexEntry));
+        /* entries pointing past the committed records are not valid yet */
+        while(m_indexEntries > 0 && (v_buff_size) getIndexEntry(m_indexEntries - 1).offset >= m_endOffset) {
+          m_indexEntries --;
+        }
+      }
+    }
+  }
+
+  return true;
+
+}
+
+void RecordingReader::close() {
+  unmap(m_data);
+  unmap(m_index);
+  m_gameId.clear();
+  m_sessionId.clear();
+  m_endOffset = 0;
+  m_indexEntries = 0;
+}
+
+RecordingFormat::IndexEntry RecordingReader::getIndexEntry(v_buff_size index) const {
+  RecordingFormat::IndexEntry entry;
+  std::memcpy(&entry, m_index.data + sizeof(RecordingFormat::IndexHeader) + index * sizeof(entry), sizeof(entry));
+  return entry;
+}
+
+bool RecordingReader::read(v_buff_size& offset, Record& record) const {
+
+  if(offset + (v_buff_size) sizeof(RecordingFormat::RecordHeader) > m_endOffset) {
+    return false;
+  }
+
+  RecordingFormat::RecordHeader header;
+  std::memcpy(&header, m_data.data + offset, sizeof(header));
+
+  v_buff_size next = offset + sizeof(header) + RecordingFormat::align(header.size);
+  if(next > m_endOffset) {
+    return false;
+  }
+
+  record.type = header.type;
+  record.timestampMicros = header.timestampMicros;
+  record.peerId = header.peerId;
+  record.eventId = header.eventId;
+  record.data = (const char*) m_data.data + offset + sizeof(header);
+  record.size = header.size;
+
+  offset = next;
+  return true;
+
+}
+
+v_buff_size RecordingReader::seekTime(v_int64 timestampMicros) const {
+
+  /* last index entry with timestamp before the target - the record is at or after it */
+  v_buff_size offset = getBeginOffset();
+  v_buff_size low = 0;
+  v_buff_size high = m_indexEntries;
+  while(low < high) {
+    v_buff_size middle = (low + high) / 2;
+    auto entry = getIndexEntry(middle);
+    if(entry.timestampMicros < timestampMicros) {
+      offset = entry.offset;
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  Record record;
+  v_buff_size current = offset;
+  while(read(current, record)) {
+    if(record.timestampMicros >= timestampMicros) {
+      return offset;
+    }
+    offset = current;
+  }
+
+  return m_endOffset;
+
+}
+
+v_buff_size RecordingReader::seekEventId(v_int64 eventId) const {
+
+  /* last index entry before which no event >= eventId could be recorded */
+  v_buff_size offset = getBeginOffset();
+  v_buff_size low = 0;
+  v_buff_size high = m_indexEntries;
+  while(low < high) {
+    v_buff_size middle = (low + high) / 2;
+    auto entry = getIndexEntry(middle);
+    if(entry.nextEventId <= eventId) {
+      offset = entry.offset;
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  Record record;
+  v_buff_size current = offset;
+  while(read(current, record)) {
+    if(record.type == RecordingFormat::TYPE_SYNCHRONIZED_EVENT && record.eventId >= eventId) {
+      return offset;
+    }
+    offset = current;
+  }
+
+  return m_endOffset;
+
+}
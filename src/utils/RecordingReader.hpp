@@ -0,0 +1,143 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_RecordingReader_hpp
+#define Helicopter_utils_RecordingReader_hpp
+
+#include "./Recorder.hpp"
+
+/**
+ * Read-only memory-mapped view of a session recording written by `Recorder`.
+ * Records are read by offset - `read()` advances the offset to the next record.
+ */
+class RecordingReader {
+public:
+
+  struct Record {
+    v_uint16 type;
+    v_int64 timestampMicros;
+    v_int64 peerId;
+    v_int64 eventId;
+    const char* data;
+    v_uint32 size;
+  };
+
+private:
+
+  struct Mapping {
+    int fd = -1;
+    p_char8 data = nullptr;
+    v_buff_size size = 0;
+  };
+
+private:
+  Mapping m_data;
+  Mapping m_index;
+  RecordingFormat::FileHeader m_header;
+  std::string m_gameId;
+  std::string m_sessionId;
+  v_buff_size m_endOffset;
+  v_buff_size m_indexEntries;
+private:
+  static bool map(const std::string& path, Mapping& mapping);
+  static void unmap(Mapping& mapping);
+  RecordingFormat::IndexEntry getIndexEntry(v_buff_size index) const;
+public:
+
+  /**
+   * Constructor. Nothing is opened.
+   */
+  RecordingReader();
+
+  /**
+   * Non-copyable.
+   */
+  RecordingReader(const RecordingReader&) = delete;
+  RecordingReader& operator=(const RecordingReader&) = delete;
+
+  /**
+   * Unmap files.
+   */
+  ~RecordingReader();
+
+  /**
+   * Open recording. The `.hidx` index next to it is optional - without it seeks scan records from the beginning.
+   * @param path - path to `.hrec` file.
+   * @return - `false` if file can't be read or has wrong format.
+   */
+  bool open(const std::string& path);
+
+  /**
+   * Unmap files.
+   */
+  void close();
+
+  const std::string& getGameId() const {
+    return m_gameId;
+  }
+
+  const std::string& getSessionId() const {
+    return m_sessionId;
+  }
+
+  v_int64 getStartMicros() const {
+    return m_header.startMicros;
+  }
+
+  /**
+   * Offset of the first record.
+   * @return
+   */
+  v_buff_size getBeginOffset() const {
+    return m_header.headerSize;
+  }
+
+  /**
+   * Read record at offset and advance offset to the next record.
+   * `record.data` points into the mapped file and is valid till the reader is closed.
+   * @param offset
+   * @param record
+   * @return - `false` if there are no more records.
+   */
+  bool read(v_buff_size& offset, Record& record) const;
+
+  /**
+   * Find the first record with timestamp not less than `timestampMicros`.
+   * @param timestampMicros
+   * @return - offset of the record. End offset if there is no such record.
+   */
+  v_buff_size seekTime(v_int64 timestampMicros) const;
+
+  /**
+   * Find the first synchronized event with eventId not less than `eventId`.
+   * @param eventId
+   * @return - offset of the record. End offset if there is no such record.
+   */
+  v_buff_size seekEventId(v_int64 eventId) const;
+
+};
+
+#endif //Helicopter_utils_RecordingReader_hpp
@@ -0,0 +1,43 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Secret.hpp"
+
+bool Secret::equals(const oatpp::String& secret, const oatpp::String& expected) {
+
+  if(!secret || !expected || secret->size() != expected->size()) {
+    return false;
+  }
+
+  /* constant time compare */
+  v_uint8 diff = 0;
+  for(v_buff_size i = 0; i < (v_buff_size) secret->size(); i ++) {
+    diff |= (v_uint8) (secret->data()[i] ^ expected->data()[i]);
+  }
+
+  return diff == 0;
+
+}
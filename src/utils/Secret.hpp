@@ -0,0 +1,48 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_Secret_hpp
+#define Helicopter_utils_Secret_hpp
+
+#include "oatpp/core/Types.hpp"
+
+/**
+ * Shared secrets - relay secret, admin token.
+ */
+class Secret {
+public:
+
+  /**
+   * Compare secrets in time independent of the position of the first mismatch.
+   * @param secret - secret received from the client.
+   * @param expected - configured secret.
+   * @return - `false` if either of secrets is null or they don't match.
+   */
+  static bool equals(const oatpp::String& secret, const oatpp::String& expected);
+
+};
+
+#endif //Helicopter_utils_Secret_hpp
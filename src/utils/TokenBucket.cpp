@@ -0,0 +1,67 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "TokenBucket.hpp"
+
+TokenBucket::TokenBucket(v_float64 rate, v_float64 capacity, v_int64 timestamp)
+  : m_rate(rate)
+  , m_capacity(capacity)
+  , m_tokens(capacity)
+  , m_timestamp(timestamp)
+{}
+
+void TokenBucket::refill(v_int64 timestamp) {
+  if(timestamp > m_timestamp) {
+    m_tokens += (timestamp - m_timestamp) * m_rate / 1000000.0;
+    if(m_tokens > m_capacity) {
+      m_tokens = m_capacity;
+    }
+    m_timestamp = timestamp;
+  }
+}
+
+bool TokenBucket::tryConsume(v_float64 amount, v_int64 timestamp) {
+  refill(timestamp);
+  if(m_tokens >= amount) {
+    m_tokens -= amount;
+    return true;
+  }
+  return false;
+}
+
+v_int64 TokenBucket::consume(v_float64 amount, v_int64 timestamp) {
+  refill(timestamp);
+  m_tokens -= amount;
+  if(m_tokens >= 0 || m_rate <= 0) {
+    return 0;
+  }
+  return (v_int64) (-m_tokens * 1000000.0 / m_rate);
+}
+
+bool TokenBucket::isFull(v_int64 timestamp) {
+  refill(timestamp);
+  return m_tokens >= m_capacity;
+}
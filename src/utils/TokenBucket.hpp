@@ -0,0 +1,79 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_TokenBucket_hpp
+#define Helicopter_utils_TokenBucket_hpp
+
+#include "oatpp/core/base/Environment.hpp"
+
+/**
+ * Token bucket rate limiter.
+ * Not thread-safe. Timestamps are in microseconds.
+ */
+class TokenBucket {
+private:
+  v_float64 m_rate;
+  v_float64 m_capacity;
+  v_float64 m_tokens;
+  v_int64 m_timestamp;
+private:
+  void refill(v_int64 timestamp);
+public:
+
+  /**
+   * Constructor. Bucket is created full.
+   * @param rate - tokens per second.
+   * @param capacity - max tokens in the bucket (burst).
+   * @param timestamp - current timestamp in microseconds.
+   */
+  TokenBucket(v_float64 rate, v_float64 capacity, v_int64 timestamp);
+
+  /**
+   * Consume tokens if there are enough tokens in the bucket.
+   * @param amount
+   * @param timestamp - current timestamp in microseconds.
+   * @return - `true` if tokens were consumed.
+   */
+  bool tryConsume(v_float64 amount, v_int64 timestamp);
+
+  /**
+   * Consume tokens even if there are not enough tokens in the bucket.
+   * @param amount
+   * @param timestamp - current timestamp in microseconds.
+   * @return - microseconds to wait until the bucket is out of debt. `0` if there was enough tokens.
+   */
+  v_int64 consume(v_float64 amount, v_int64 timestamp);
+
+  /**
+   * Check if bucket is full - it's in the same state as a newly created bucket.
+   * @param timestamp - current timestamp in microseconds.
+   * @return
+   */
+  bool isFull(v_int64 timestamp);
+
+};
+
+#endif //Helicopter_utils_TokenBucket_hpp
@@ -0,0 +1,153 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#include "Tracer.hpp"
+
+#include "./AsyncLogger.hpp"
+
+#include "oatpp/parser/json/Utils.hpp"
+
+#include <chrono>
+#include <random>
+
+Tracer::Tracer(const oatpp::Object<TracingConfigDto>& config)
+  : m_traceOcid(false)
+  , m_sampleRate(0)
+  , m_maxQueuedSpans(0)
+  , m_traceIdCounter(1)
+  , m_droppedSpans(0)
+  , m_running(false)
+{
+
+  if(!config || !config->file) {
+    return;
+  }
+
+  m_file = config->file;
+  m_traceOcid = config->traceOcid;
+  m_sampleRate = config->sampleRate;
+  m_maxQueuedSpans = config->maxQueuedSpans;
+  m_running = true;
+
+  m_thread = std::thread(&Tracer::run, this);
+
+  HELI_LOGI("Tracer", "Tracing to '%s'. Sample rate=%f", m_file->c_str(), m_sampleRate);
+
+}
+
+Tracer::~Tracer() {
+  if(m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running = false;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+  }
+}
+
+bool Tracer::sample(v_float64 rate) {
+  static thread_local std::minstd_rand generator(
+    (std::minstd_rand::result_type) std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  return std::uniform_real_distribution<v_float64>(0.0, 1.0)(generator) < rate;
+}
+
+v_int64 Tracer::startTrace(const oatpp::String& ocid) {
+
+  if(!m_file) {
+    return 0;
+  }
+
+  if((ocid && m_traceOcid) || (m_sampleRate > 0 && sample(m_sampleRate))) {
+    return m_traceIdCounter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return 0;
+
+}
+
+void Tracer::record(Span&& span) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(m_spans.size() >= m_maxQueuedSpans) {
+    m_droppedSpans.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  m_spans.push_back(std::move(span));
+}
+
+v_int64 Tracer::getDroppedSpans() {
+  return m_droppedSpans.load(std::memory_order_relaxed);
+}
+
+void Tracer::writeSpan(std::ofstream& stream, const Span& span) {
+  stream << "{\"name\":\"" << span.name << "\",\"cat\":\"helicopter\",\"ph\":\"X\""
+         << ",\"ts\":" << span.startMicros << ",\"dur\":" << span.durationMicros
+         << ",\"pid\":1,\"tid\":" << span.peerId
+         << ",\"args\":{\"trace\":" << span.traceId << ",\"code\":" << span.code;
+  if(span.ocid) {
+    auto ocid = oatpp::parser::json::Utils::escapeString(span.ocid->data(), span.ocid->size());
+    stream << ",\"ocid\":\"" << ocid->c_str() << "\"";
+  }
+  stream << "}},\n";
+}
+
+void Tracer::run() {
+
+  std::ofstream stream(m_file->c_str(), std::ios::out | std::ios::app);
+  if(!stream.is_open()) {
+    HELI_LOGE("Tracer", "Can't open trace file '%s'. Tracing is disabled.", m_file->c_str());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxQueuedSpans = 0;
+    return;
+  }
+
+  /* JSON array format - closing bracket is optional, so the file stays valid while appended */
+  stream.seekp(0, std::ios::end);
+  if(stream.tellp() == 0) {
+    stream << "[\n";
+  }
+
+  std::vector<Span> batch;
+  bool running = true;
+
+  while(running) {
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait_for(lock, std::chrono::milliseconds(200), [this] { return !m_running; });
+      running = m_running;
+      batch.swap(m_spans);
+    }
+
+    for(auto& span : batch) {
+      writeSpan(stream, span);
+    }
+    batch.clear();
+    stream.flush();
+
+  }
+
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *
+ * Project:               _ _                 _
+ *              /\  /\___| (_) ___ ___  _ __ | |_ ___ _ __
+ *             / /_/ / _ \ | |/ __/ _ \| '_ \| __/ _ \ '__|
+ *            / __  /  __/ | | (_| (_) | |_) | ||  __/ |
+ *            \/ /_/ \___|_|_|\___\___/| .__/ \__\___|_|
+ *                                     |_|
+ *
+ *
+ * Copyright 2022-present, Leonid Stryzhevskyi <lganzzzo@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************************/
+
+#ifndef Helicopter_utils_Tracer_hpp
+#define Helicopter_utils_Tracer_hpp
+
+#include "config/Config.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Sampled per-message tracer.
+ * Spans are buffered in memory and appended to the trace file by the background thread
+ * in Chrome trace JSON format - one complete ("X") event per span, spans of each peer on its own row.
+ */
+class Tracer {
+public:
+
+  struct Span {
+    const char* name;
+    v_int64 traceId;
+    oatpp::String ocid;
+    v_int64 peerId;
+    v_int32 code;
+    v_int64 startMicros;
+    v_int64 durationMicros;
+  };
+
+private:
+  oatpp::String m_file;
+  bool m_traceOcid;
+  v_float64 m_sampleRate;
+  v_uint32 m_maxQueuedSpans;
+  std::atomic<v_int64> m_traceIdCounter;
+  std::atomic<v_int64> m_droppedSpans;
+private:
+  std::vector<Span> m_spans;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_running;
+  std::thread m_thread;
+private:
+  static bool sample(v_float64 rate);
+  static void writeSpan(std::ofstream& stream, const Span& span);
+  void run();
+public:
+
+  /**
+   * Constructor.
+   * @param config - null - tracing is disabled.
+   */
+  Tracer(const oatpp::Object<TracingConfigDto>& config);
+
+  /**
+   * Write remaining spans and stop the background thread.
+   */
+  ~Tracer();
+
+  /**
+   * Check if tracing is enabled.
+   * @return
+   */
+  bool isEnabled() const {
+    return m_file != nullptr;
+  }
+
+  /**
+   * Decide if inbound message is traced.
+   * @param ocid - operation correlation ID of the message.
+   * @return - ID of the new trace. `0` - message is not traced.
+   */
+  v_int64 startTrace(const oatpp::String& ocid);
+
+  /**
+   * Record span. Non-blocking for the caller except for a short lock of the spans buffer.
+   * @param span
+   */
+  void record(Span&& span);
+
+  /**
+   * Get number of spans dropped because the writer couldn't keep up.
+   * @return
+   */
+  v_int64 getDroppedSpans();
+
+};
+
+#endif //Helicopter_utils_Tracer_hpp
@@ -0,0 +1,85 @@
+
+#include "GameLimitsBenchmark.hpp"
+
+#include "config/GameLimits.hpp"
+
+namespace {
+
+constexpr v_int64 ITERATIONS = 10 * 1000 * 1000;
+
+/* Mimics how Peer used to reach the config - a by-value getter on the session */
+class ConfigHolder {
+private:
+  oatpp::Object<GameConfigDto> m_config;
+public:
+
+  ConfigHolder(const oatpp::Object<GameConfigDto>& config)
+    : m_config(config)
+  {}
+
+  oatpp::Object<GameConfigDto> getConfig() {
+    return m_config;
+  }
+
+};
+
+/* Same checks Peer does per message: queue size, message size, failed pings, rate limit policy */
+
+v_int64 runDto(ConfigHolder* holder) {
+  v_int64 passed = 0;
+  for(v_int64 i = 0; i < ITERATIONS; i ++) {
+    if((v_uint32) (i & 127) < holder->getConfig()->maxQueuedMessages) passed ++;
+    if((v_uint64) (i & 8191) <= holder->getConfig()->maxMessageSizeBytes) passed ++;
+    if((v_uint64) (i & 255) >= holder->getConfig()->maxFailedPings) passed ++;
+    if(*holder->getConfig()->rateLimitPolicy == RateLimitPolicy::THROTTLE) passed ++;
+  }
+  return passed;
+}
+
+v_int64 runLimits(const GameLimits* limits) {
+  v_int64 passed = 0;
+  for(v_int64 i = 0; i < ITERATIONS; i ++) {
+    if((v_uint32) (i & 127) < limits->maxQueuedMessages) passed ++;
+    if((v_uint64) (i & 8191) <= limits->maxMessageSizeBytes) passed ++;
+    if((v_uint64) (i & 255) >= limits->maxFailedPings) passed ++;
+    if(limits->rateLimitPolicy == RateLimitPolicy::THROTTLE) passed ++;
+  }
+  return passed;
+}
+
+}
+
+void GameLimitsBenchmark::onRun() {
+
+  auto config = GameConfigDto::createShared();
+  config->gameId = "bench";
+
+  ConfigHolder holder(config);
+  const GameLimits limits = GameLimits::compile(config);
+
+  v_int64 dtoPassed;
+  v_int64 limitsPassed;
+
+  {
+    auto start = oatpp::base::Environment::getMicroTickCount();
+    dtoPassed = runDto(&holder);
+    auto elapsed = oatpp::base::Environment::getMicroTickCount() - start;
+    OATPP_LOGD(TAG, "DTO config:  %lld ns/message", (long long) (elapsed * 1000 / ITERATIONS));
+  }
+
+  {
+    auto start = oatpp::base::Environment::getMicroTickCount();
+    limitsPassed = runLimits(&limits);
+    auto elapsed = oatpp::base::Environment::getMicroTickCount() - start;
+    OATPP_LOGD(TAG, "GameLimits:  %lld ns/message", (long long) (elapsed * 1000 / ITERATIONS));
+  }
+
+  /* both paths must take the same decisions */
+  OATPP_ASSERT(dtoPassed == limitsPassed);
+
+  /* null fields fall back to DTO defaults */
+  config->maxQueuedMessages = nullptr;
+  auto compiled = GameLimits::compile(config);
+  OATPP_ASSERT(compiled.maxQueuedMessages == *GameConfigDto().maxQueuedMessages);
+
+}
@@ -0,0 +1,19 @@
+
+#ifndef Helicopter_test_GameLimitsBenchmark_hpp
+#define Helicopter_test_GameLimitsBenchmark_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ * Per-message overhead of reading game limits:
+ * `Session::getConfig()->field` (refcounted DTO copy + nullable wrapper) vs. compiled `GameLimits`.
+ */
+class GameLimitsBenchmark : public oatpp::test::UnitTest {
+public:
+
+  GameLimitsBenchmark():UnitTest("TEST[GameLimitsBenchmark]"){}
+  void onRun() override;
+
+};
+
+#endif //Helicopter_test_GameLimitsBenchmark_hpp
@@ -0,0 +1,99 @@
+#include "HashRingTest.hpp"
+
+#include "cluster/HashRing.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+
+namespace {
+
+  const v_int32 NODES = 5;
+  const v_int32 VIRTUAL_NODES = 128;
+  const v_int32 KEYS = 20000;
+
+  std::vector<oatpp::String> createNodeIds() {
+    std::vector<oatpp::String> result;
+    for(v_int32 i = 0; i < NODES; i ++) {
+      result.push_back("node-" + oatpp::utils::conversion::int32ToStr(i + 1));
+    }
+    return result;
+  }
+
+  std::vector<oatpp::String> createKeys() {
+    std::vector<oatpp::String> result;
+    result.reserve(KEYS);
+    for(v_int32 i = 0; i < KEYS; i ++) {
+      result.push_back("game/session-" + oatpp::utils::conversion::int32ToStr(i));
+    }
+    return result;
+  }
+
+  /* owner node ID of each key */
+  std::vector<oatpp::String> place(const std::vector<oatpp::String>& nodeIds, const std::vector<oatpp::String>& keys) {
+    HashRing ring(nodeIds, VIRTUAL_NODES);
+    std::vector<oatpp::String> result;
+    result.reserve(keys.size());
+    for(auto& key : keys) {
+      v_int32 node = ring.getNode(key);
+      OATPP_ASSERT(node >= 0 && node < (v_int32) nodeIds.size());
+      result.push_back(nodeIds[node]);
+    }
+    return result;
+  }
+
+}
+
+void HashRingTest::onRun() {
+
+  auto nodeIds = createNodeIds();
+  auto keys = createKeys();
+  auto owners = place(nodeIds, keys);
+
+  /* every node owns a fair share of keys */
+  for(auto& nodeId : nodeIds) {
+    v_int32 count = (v_int32) std::count(owners.begin(), owners.end(), nodeId);
+    OATPP_LOGD(TAG, "'%s' owns %d keys", nodeId->c_str(), count);
+    OATPP_ASSERT(count > KEYS / NODES / 2);
+    OATPP_ASSERT(count < KEYS / NODES * 2);
+  }
+
+  /* placement doesn't depend on the order of members */
+  {
+    auto reversed = nodeIds;
+    std::reverse(reversed.begin(), reversed.end());
+    OATPP_ASSERT(place(reversed, keys) == owners);
+
+    auto rotated = nodeIds;
+    std::rotate(rotated.begin(), rotated.begin() + 2, rotated.end());
+    OATPP_ASSERT(place(rotated, keys) == owners);
+  }
+
+  /* removing a node moves only its keys - about 1/N of all keys */
+  {
+    auto removedId = nodeIds[2];
+    auto remaining = nodeIds;
+    remaining.erase(remaining.begin() + 2);
+
+    auto newOwners = place(remaining, keys);
+
+    v_int32 moved = 0;
+    for(v_int32 i = 0; i < KEYS; i ++) {
+      if(newOwners[i] != owners[i]) {
+        OATPP_ASSERT(owners[i] == removedId);
+        moved ++;
+      } else {
+        OATPP_ASSERT(owners[i] != removedId);
+      }
+    }
+
+    OATPP_LOGD(TAG, "removed '%s' - %d of %d keys moved", removedId->c_str(), moved, KEYS);
+    OATPP_ASSERT(moved > KEYS / NODES * 2 / 3);
+    OATPP_ASSERT(moved < KEYS / NODES * 4 / 3);
+  }
+
+  /* empty ring owns nothing */
+  HashRing empty({}, VIRTUAL_NODES);
+  OATPP_ASSERT(empty.getNode("game/session-0") == -1);
+
+}
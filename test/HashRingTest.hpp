@@ -0,0 +1,18 @@
+#ifndef Helicopter_test_HashRingTest_hpp
+#define Helicopter_test_HashRingTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ * Consistent hash ring placement - stable regardless of the order of members,
+ * removal of a node moves only the keys of that node (about 1/N of all keys).
+ */
+class HashRingTest : public oatpp::test::UnitTest {
+public:
+
+  HashRingTest():UnitTest("TEST[HashRingTest]"){}
+  void onRun() override;
+
+};
+
+#endif //Helicopter_test_HashRingTest_hpp
@@ -0,0 +1,279 @@
+#include "SoakTest.hpp"
+
+#include "harness/VirtualHarness.hpp"
+
+#include "utils/Metrics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+  const v_int32 SESSIONS = 50;
+  const v_int32 PEERS_PER_SESSION = 10;
+  const v_int32 BURST_MESSAGES = 20;
+  const v_int32 THREADS = 4;
+  const v_int64 TIMEOUT_MILLIS = 60 * 1000;
+
+  const v_int32 WARMUP_CYCLES = 2;
+  const v_int32 MIN_MEASURED_CYCLES = 3;
+
+  /* allowed growth of RSS and heap from the baseline to the end of the run */
+  const v_int64 MAX_GROWTH_BYTES = 16 * 1024 * 1024;
+  const v_int64 MAX_GROWTH_PERCENT = 10;
+
+  struct MemorySample {
+    v_int64 rssBytes;
+    v_int64 objectsCount;
+    v_int64 heapInUseBytes;
+    v_int64 heapMappedBytes;
+  };
+
+  v_int64 getEnvInt(const char* name, v_int64 defaultValue) {
+    const char* value = std::getenv(name);
+    return value ? std::atoll(value) : defaultValue;
+  }
+
+  v_int64 readRssBytes() {
+    std::ifstream file("/proc/self/status");
+    std::string line;
+    while(std::getline(file, line)) {
+      if(line.compare(0, 6, "VmRSS:") == 0) {
+        return std::stoll(line.substr(6)) * 1024;
+      }
+    }
+    return -1;
+  }
+
+  MemorySample takeSample() {
+    MemorySample sample;
+    sample.rssBytes = readRssBytes();
+    sample.objectsCount = oatpp::base::Environment::getObjectsCount();
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    sample.heapInUseBytes = info.uordblks + info.hblkhd;
+    sample.heapMappedBytes = info.arena + info.hblkhd;
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();
+    sample.heapInUseBytes = (v_uint32) info.uordblks + (v_uint32) info.hblkhd;
+    sample.heapMappedBytes = (v_uint32) info.arena + (v_uint32) info.hblkhd;
+#else
+    sample.heapInUseBytes = -1;
+    sample.heapMappedBytes = -1;
+#endif
+    return sample;
+  }
+
+  bool isFlat(v_int64 baseline, v_int64 current) {
+    if(baseline < 0 || current < 0) {
+      return true; // not available on this platform
+    }
+    return current - baseline <= std::max(MAX_GROWTH_BYTES, baseline * MAX_GROWTH_PERCENT / 100);
+  }
+
+  void logSample(const char* tag, const char* name, v_int32 cycle, const MemorySample& sample) {
+    OATPP_LOGD(tag, "%s cycle=%d: rss=%lld kB, objects=%lld, heap in use=%lld kB, heap mapped=%lld kB",
+               name, cycle,
+               (long long) (sample.rssBytes / 1024), (long long) sample.objectsCount,
+               (long long) (sample.heapInUseBytes / 1024), (long long) (sample.heapMappedBytes / 1024));
+  }
+
+  class Soak {
+  private:
+    const char* m_tag;
+    VirtualHarness m_harness;
+    BenchConfig m_config;
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> m_objectMapper;
+    std::shared_ptr<BenchStats> m_stats;
+    v_uint64 m_dropsBefore;
+    v_int64 m_maxSessionQueued;
+    v_int64 m_maxTotalQueued;
+  private:
+
+    static oatpp::Object<GameConfigDto> createGameConfig() {
+      auto config = GameConfigDto::createShared();
+      config->gameId = "soak";
+      config->staticHost = false; // host disconnects migrate host
+      config->maxPeers = PEERS_PER_SESSION;
+      config->maxMessagesPerSecond = 0;
+      config->maxBytesPerSecond = 0;
+      config->maxQueuedMessages = 8; // bursts overflow queues
+      return config;
+    }
+
+    v_uint64 getQueueDrops() {
+      return Metrics::collect().counters[Metrics::QUEUE_OVERFLOW_DROPS] - m_dropsBefore;
+    }
+
+    void sampleQueues() {
+      v_int64 total = 0;
+      for(auto& session : m_harness.getRegistry()->getAllSessions()) {
+        v_int64 queued = 0;
+        for(auto& peer : session->getAllPeers()) {
+          queued += peer->getQueuedMessagesCount();
+        }
+        m_maxSessionQueued = std::max(m_maxSessionQueued, queued);
+        total += queued;
+      }
+      m_maxTotalQueued = std::max(m_maxTotalQueued, total);
+    }
+
+    /* wait till number of connected simulated peers drops to `expected` */
+    void expectConnected(v_int64 expected) {
+      auto stats = m_stats;
+      OATPP_ASSERT(m_harness.waitFor([stats, expected]{
+        return stats->getConnectedPeers() == expected;
+      }, TIMEOUT_MILLIS));
+    }
+
+    void kick(const std::shared_ptr<BenchPeer>& host, const std::vector<std::shared_ptr<BenchPeer>>& peers) {
+      auto ids = oatpp::Vector<oatpp::Int64>::createShared();
+      for(auto& peer : peers) {
+        ids->push_back(peer->getPeerId());
+      }
+      OATPP_ASSERT(host->send(m_objectMapper->writeToString(
+        MessageDto::createShared(MessageCodes::INCOMING_HOST_KICK_CLIENTS, ids))));
+    }
+
+  public:
+
+    Soak(const char* tag)
+      : m_tag(tag)
+      , m_harness(createGameConfig(), THREADS, true)
+      , m_stats(m_harness.getStats())
+      , m_dropsBefore(Metrics::collect().counters[Metrics::QUEUE_OVERFLOW_DROPS])
+      , m_maxSessionQueued(0)
+      , m_maxTotalQueued(0)
+    {
+      OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper, Constants::COMPONENT_WS_API);
+      m_objectMapper = objectMapper;
+      m_config.sessions = SESSIONS;
+      m_config.peers = PEERS_PER_SESSION;
+      m_config.maxQueuedMessages = 1 << 20;
+      m_config.mix[BenchConfig::KIND_BROADCAST] = 100;
+      m_config.mix[BenchConfig::KIND_DIRECT] = 0;
+      m_config.mix[BenchConfig::KIND_TO_HOST] = 0;
+      m_config.mix[BenchConfig::KIND_SYNCHRONIZED] = 0;
+    }
+
+    /**
+     * Join all peers, overflow queues, kick two clients, two clients leave, host disconnects, rest leave.
+     * Every server side session is destroyed by the end of the cycle.
+     */
+    void runCycle() {
+
+      OATPP_ASSERT(m_harness.connectSessions(&m_config, TIMEOUT_MILLIS));
+
+      /* queue overflows */
+      std::minstd_rand random(1);
+      for(v_int32 i = 0; i < BURST_MESSAGES; i ++) {
+        for(auto& session : m_harness.getSessions()) {
+          for(auto& peer : session->getPeers()) {
+            session->sendNext(peer, random);
+          }
+        }
+      }
+      sampleQueues();
+
+      auto stats = m_stats;
+      OATPP_ASSERT(m_harness.waitFor([this, stats]{
+        return stats->getDeliveredMessages() + (v_int64) getQueueDrops() >= stats->getExpectedDeliveries();
+      }, TIMEOUT_MILLIS));
+
+      v_int64 connected = m_stats->getConnectedPeers();
+
+      /* kicks */
+      for(auto& session : m_harness.getSessions()) {
+        auto peers = session->getPeers();
+        kick(peers[0], {peers[1], peers[2]});
+      }
+      connected -= 2 * SESSIONS;
+      expectConnected(connected);
+
+      /* leaves */
+      for(auto& session : m_harness.getSessions()) {
+        auto peers = session->getPeers();
+        peers[3]->close();
+        peers[4]->close();
+      }
+      connected -= 2 * SESSIONS;
+      expectConnected(connected);
+
+      /* host disconnects */
+      for(auto& session : m_harness.getSessions()) {
+        session->getPeers()[0]->close();
+      }
+      connected -= SESSIONS;
+      expectConnected(connected);
+
+      /* the rest leave - sessions are destroyed via Registry::onBeforeDestroy_NonBlocking */
+      OATPP_ASSERT(m_harness.closeSessions(TIMEOUT_MILLIS));
+
+    }
+
+    void logTotals() {
+      OATPP_LOGD(m_tag, "deliveries: %lld expected, %lld delivered, %lld dropped on queue overflow",
+                 (long long) m_stats->getExpectedDeliveries(), (long long) m_stats->getDeliveredMessages(),
+                 (long long) getQueueDrops());
+      OATPP_LOGD(m_tag, "queues: max %lld messages per session, max %lld messages total",
+                 (long long) m_maxSessionQueued, (long long) m_maxTotalQueued);
+    }
+
+  };
+
+}
+
+void SoakTest::onRun() {
+
+  v_int64 durationMicros = getEnvInt("HELICOPTER_SOAK_MINUTES", 0) * 60 * 1000 * 1000;
+  v_int64 sampleMicros = getEnvInt("HELICOPTER_SOAK_SAMPLE_SECONDS", 60) * 1000 * 1000;
+
+  Soak soak(TAG);
+
+  for(v_int32 i = 0; i < WARMUP_CYCLES; i ++) {
+    soak.runCycle();
+  }
+
+  MemorySample baseline = takeSample();
+  logSample(TAG, "baseline", WARMUP_CYCLES, baseline);
+
+  auto start = oatpp::base::Environment::getMicroTickCount();
+  auto lastSample = start;
+  v_int32 cycle = 0;
+  MemorySample current = baseline;
+
+  while(cycle < MIN_MEASURED_CYCLES || oatpp::base::Environment::getMicroTickCount() - start < durationMicros) {
+
+    soak.runCycle();
+    cycle ++;
+
+    /* coroutines of the closed peers may still be finishing */
+    v_int64 baselineObjects = baseline.objectsCount;
+    VirtualHarness::waitFor([baselineObjects]{
+      return oatpp::base::Environment::getObjectsCount() <= baselineObjects;
+    }, TIMEOUT_MILLIS);
+
+    current = takeSample();
+    OATPP_ASSERT(current.objectsCount <= baseline.objectsCount);
+
+    auto now = oatpp::base::Environment::getMicroTickCount();
+    if(durationMicros == 0 || now - lastSample >= sampleMicros) {
+      logSample(TAG, "sample", WARMUP_CYCLES + cycle, current);
+      lastSample = now;
+    }
+
+  }
+
+  soak.logTotals();
+  logSample(TAG, "final", WARMUP_CYCLES + cycle, current);
+
+  OATPP_ASSERT(isFlat(baseline.rssBytes, current.rssBytes));
+  OATPP_ASSERT(isFlat(baseline.heapInUseBytes, current.heapInUseBytes));
+
+}
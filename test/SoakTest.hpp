@@ -0,0 +1,21 @@
+#ifndef Helicopter_test_SoakTest_hpp
+#define Helicopter_test_SoakTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ * Churn soak on the in-process virtual transport harness.
+ * Cycles of joins, queue overflows, kicks, leaves, host disconnects and session destruction.
+ * Memory - RSS, object count, heap - is sampled periodically and must stay flat.
+ * Duration - `HELICOPTER_SOAK_MINUTES` environment variable. Default - a few cycles only.
+ * Sample interval - `HELICOPTER_SOAK_SAMPLE_SECONDS`, default - 60.
+ */
+class SoakTest : public oatpp::test::UnitTest {
+public:
+
+  SoakTest():UnitTest("TEST[SoakTest]"){}
+  void onRun() override;
+
+};
+
+#endif //Helicopter_test_SoakTest_hpp
@@ -0,0 +1,138 @@
+#include "SpatialGridTest.hpp"
+
+#include "harness/VirtualHarness.hpp"
+
+#include "config/GameLimits.hpp"
+
+#include <algorithm>
+
+namespace {
+
+  const v_int32 THREADS = 2;
+  const v_int64 TIMEOUT_MILLIS = 30 * 1000;
+
+  oatpp::Object<GameConfigDto> createGameConfig(v_int32 peers) {
+    auto config = GameConfigDto::createShared();
+    config->gameId = "spatial";
+    config->maxPeers = peers;
+    config->maxMessagesPerSecond = 0;
+    config->maxBytesPerSecond = 0;
+    config->aoiRadius = 1;
+    return config;
+  }
+
+  /* connect one session of `peers` peers and return ids of its server side peers */
+  std::shared_ptr<Session> connect(VirtualHarness& harness, v_int32 peers, std::vector<v_int64>& peerIds) {
+    BenchConfig config;
+    config.sessions = 1;
+    config.peers = peers;
+    OATPP_ASSERT(harness.connectSessions(&config, TIMEOUT_MILLIS));
+    auto sessions = harness.getRegistry()->getAllSessions();
+    OATPP_ASSERT(sessions.size() == 1);
+    for(auto& peer : sessions[0]->getAllPeers()) {
+      peerIds.push_back(peer->getPeerId());
+    }
+    OATPP_ASSERT((v_int32) peerIds.size() == peers);
+    return sessions[0];
+  }
+
+  std::vector<v_int64> query(const std::shared_ptr<Session>& session, v_int64 peerId) {
+    bool found;
+    std::vector<v_int64> result;
+    for(auto& peer : session->getPeersInAreaOfInterest(peerId, found)) {
+      result.push_back(peer->getPeerId());
+    }
+    OATPP_ASSERT(found);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  void testCells() {
+
+    VirtualHarness harness(createGameConfig(4), THREADS, true);
+    std::vector<v_int64> ids;
+    auto session = connect(harness, 4, ids);
+    std::sort(ids.begin(), ids.end());
+    v_int64 a = ids[0], b = ids[1], c = ids[2], d = ids[3];
+
+    /* peer without a cell has no area of interest */
+    bool found = true;
+    OATPP_ASSERT(session->getPeersInAreaOfInterest(a, found).empty());
+    OATPP_ASSERT(!found);
+
+    /* unknown peer */
+    OATPP_ASSERT(!session->setPeerCell(-1, 0, 0));
+
+    OATPP_ASSERT(session->setPeerCell(a, 0, 0));
+    OATPP_ASSERT(session->setPeerCell(b, 2, 2));  // areas overlap on the corner cell
+    OATPP_ASSERT(session->setPeerCell(c, 3, 0));  // 3 cells from a - no overlap
+    OATPP_ASSERT(session->setPeerCell(d, 0, 0));  // same cell as a
+    OATPP_ASSERT(session->setPeerCell(d, 0, 0));  // same cell again is a no-op
+
+    /* sender is never in its own area of interest */
+    OATPP_ASSERT(query(session, a) == std::vector<v_int64>({b, d}));
+    OATPP_ASSERT(query(session, c) == std::vector<v_int64>({b}));
+    OATPP_ASSERT(query(session, b) == std::vector<v_int64>({a, c, d}));
+
+    /* moving between cells updates both the old and the new neighbourhood */
+    OATPP_ASSERT(session->setPeerCell(b, 10, 10));
+    OATPP_ASSERT(query(session, a) == std::vector<v_int64>({d}));
+    OATPP_ASSERT(query(session, c).empty());
+    OATPP_ASSERT(query(session, b).empty());
+
+    OATPP_ASSERT(session->setPeerCell(b, -1, -2));
+    OATPP_ASSERT(query(session, a) == std::vector<v_int64>({b, d}));
+    OATPP_ASSERT(query(session, c).empty());
+
+    OATPP_ASSERT(harness.closeSessions(TIMEOUT_MILLIS));
+
+  }
+
+  /* more occupied cells than cells in the range - query scans the range instead of the occupied cells */
+  void testDenseGrid() {
+
+    const v_int32 peers = 32;
+
+    VirtualHarness harness(createGameConfig(peers), THREADS, true);
+    std::vector<v_int64> ids;
+    auto session = connect(harness, peers, ids);
+    std::sort(ids.begin(), ids.end());
+
+    for(v_int32 i = 0; i < peers; i ++) {
+      OATPP_ASSERT(session->setPeerCell(ids[i], i * 5, 0));
+    }
+
+    OATPP_ASSERT(query(session, ids[0]).empty());
+
+    OATPP_ASSERT(session->setPeerCell(ids[1], 2, -2));
+    OATPP_ASSERT(session->setPeerCell(ids[2], 4, 0)); // overlaps ids[1] only
+    OATPP_ASSERT(query(session, ids[0]) == std::vector<v_int64>({ids[1]}));
+    OATPP_ASSERT(query(session, ids[1]) == std::vector<v_int64>({ids[0], ids[2]}));
+    OATPP_ASSERT(query(session, ids[2]) == std::vector<v_int64>({ids[1]}));
+
+    OATPP_ASSERT(harness.closeSessions(TIMEOUT_MILLIS));
+
+  }
+
+  void testRadiusClamp() {
+    auto config = createGameConfig(4);
+    config->aoiRadius = 1000000;
+    OATPP_ASSERT(GameLimits::compile(config).aoiRadius == GameLimits::MAX_AOI_RADIUS);
+    config->aoiRadius = nullptr;
+    OATPP_ASSERT(GameLimits::compile(config).aoiRadius == 1);
+  }
+
+}
+
+void SpatialGridTest::onRun() {
+
+  OATPP_LOGD(TAG, "cells...");
+  testCells();
+
+  OATPP_LOGD(TAG, "dense grid...");
+  testDenseGrid();
+
+  OATPP_LOGD(TAG, "radius clamp...");
+  testRadiusClamp();
+
+}
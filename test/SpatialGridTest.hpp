@@ -0,0 +1,17 @@
+#ifndef Helicopter_test_SpatialGridTest_hpp
+#define Helicopter_test_SpatialGridTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ * Spatial grid of the session - peer cells and area of interest queries.
+ */
+class SpatialGridTest : public oatpp::test::UnitTest {
+public:
+
+  SpatialGridTest():UnitTest("TEST[SpatialGridTest]"){}
+  void onRun() override;
+
+};
+
+#endif //Helicopter_test_SpatialGridTest_hpp
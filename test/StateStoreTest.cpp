@@ -0,0 +1,194 @@
+#include "StateStoreTest.hpp"
+
+#include "game/StateStore.hpp"
+
+#include "oatpp/core/utils/ConversionUtils.hpp"
+
+#include <algorithm>
+
+namespace {
+
+  typedef oatpp::UnorderedFields<oatpp::String> Entries;
+  typedef oatpp::Vector<oatpp::String> Keys;
+
+  oatpp::String getValue(const oatpp::Object<StateDeltaDto>& delta, const oatpp::String& key) {
+    auto it = delta->entries->find(key);
+    if(it == delta->entries->end()) {
+      return nullptr;
+    }
+    return it->second;
+  }
+
+  bool isRemoved(const oatpp::Object<StateDeltaDto>& delta, const oatpp::String& key) {
+    return std::find(delta->removed->begin(), delta->removed->end(), key) != delta->removed->end();
+  }
+
+  bool hasTombstone(StateStore& store, const oatpp::String& key) {
+    auto entries = store.exportEntries();
+    for(auto& entry : *entries) {
+      if(entry->key == key) {
+        return entry->value == nullptr;
+      }
+    }
+    return false;
+  }
+
+  void testDeltaFromAckedVersion() {
+
+    StateStore store;
+    store.addClient(1);
+
+    v_int64 v1 = store.update(Entries({{"a", "1"}, {"b", "2"}}), nullptr);
+    OATPP_ASSERT(v1 == 1);
+    OATPP_ASSERT(store.acknowledge(1, v1));
+    OATPP_ASSERT(store.getAckedVersion(1) == v1);
+
+    v_int64 v2 = store.update(Entries({{"b", "3"}}), nullptr);
+    v_int64 v3 = store.update(Entries({{"c", "4"}}), nullptr);
+    OATPP_ASSERT(v3 == 3);
+
+    /* only keys changed after the acked version */
+    auto delta = store.getDelta(store.getAckedVersion(1));
+    OATPP_ASSERT(delta);
+    OATPP_ASSERT(delta->version == v3);
+    OATPP_ASSERT(delta->baseVersion == v1);
+    OATPP_ASSERT(delta->entries->size() == 2);
+    OATPP_ASSERT(getValue(delta, "b") == "3");
+    OATPP_ASSERT(getValue(delta, "c") == "4");
+    OATPP_ASSERT(delta->removed->empty());
+
+    /* out of order ack doesn't move the acked version back */
+    OATPP_ASSERT(store.acknowledge(1, v3));
+    OATPP_ASSERT(store.acknowledge(1, v2));
+    OATPP_ASSERT(store.getAckedVersion(1) == v3);
+
+    /* up to date client gets nothing */
+    OATPP_ASSERT(store.getDelta(v3) == nullptr);
+
+    /* acks of versions from the future and of unknown clients are rejected */
+    OATPP_ASSERT(!store.acknowledge(1, v3 + 1));
+    OATPP_ASSERT(!store.acknowledge(2, v1));
+    OATPP_ASSERT(store.getAckedVersion(2) == -1);
+
+  }
+
+  void testTombstones() {
+
+    StateStore store;
+    store.addClient(1);
+
+    v_int64 v1 = store.update(Entries({{"a", "1"}, {"b", "2"}}), nullptr);
+    OATPP_ASSERT(store.acknowledge(1, v1));
+
+    /* removal by the removed list and by null value */
+    v_int64 v2 = store.update(nullptr, Keys({"a"}));
+    v_int64 v3 = store.update(Entries({{"b", nullptr}}), nullptr);
+
+    auto delta = store.getDelta(v1);
+    OATPP_ASSERT(delta);
+    OATPP_ASSERT(delta->version == v3);
+    OATPP_ASSERT(delta->entries->empty());
+    OATPP_ASSERT(delta->removed->size() == 2);
+    OATPP_ASSERT(isRemoved(delta, "a"));
+    OATPP_ASSERT(isRemoved(delta, "b"));
+
+    /* client which acked the first removal is told only about the second one */
+    delta = store.getDelta(v2);
+    OATPP_ASSERT(delta->removed->size() == 1);
+    OATPP_ASSERT(isRemoved(delta, "b"));
+
+    /* removing a removed key is not a change */
+    v_int64 v4 = store.update(nullptr, Keys({"a"}));
+    delta = store.getDelta(v3);
+    OATPP_ASSERT(delta->version == v4);
+    OATPP_ASSERT(delta->removed->empty());
+
+    /* re-added key is a regular entry again */
+    v_int64 v5 = store.update(Entries({{"a", "5"}}), nullptr);
+    delta = store.getDelta(v1);
+    OATPP_ASSERT(delta->version == v5);
+    OATPP_ASSERT(getValue(delta, "a") == "5");
+    OATPP_ASSERT(!isRemoved(delta, "a"));
+    OATPP_ASSERT(isRemoved(delta, "b"));
+
+  }
+
+  void testTombstonesCompaction() {
+
+    const v_int32 keysCount = 100;
+
+    StateStore store;
+    store.addClient(1);
+
+    auto entries = Entries({});
+    auto keys = Keys({});
+    for(v_int32 i = 0; i < keysCount; i ++) {
+      auto key = "key-" + oatpp::utils::conversion::int32ToStr(i);
+      entries->insert({key, "value"});
+      keys->push_back(key);
+    }
+
+    v_int64 v1 = store.update(entries, nullptr);
+    OATPP_ASSERT(store.acknowledge(1, v1));
+
+    /* client hasn't acked the removal - tombstones are kept */
+    v_int64 v2 = store.update(nullptr, keys);
+    OATPP_ASSERT(hasTombstone(store, "key-0"));
+    OATPP_ASSERT((v_int32) store.getDelta(v1)->removed->size() == keysCount);
+
+    /* removal acked by every client - tombstones are dropped on the next update */
+    OATPP_ASSERT(store.acknowledge(1, v2));
+    store.update(Entries({{"x", "1"}}), nullptr);
+    OATPP_ASSERT(store.exportEntries()->size() == 1);
+    OATPP_ASSERT(!hasTombstone(store, "key-0"));
+
+  }
+
+  void testLateJoinerSnapshot() {
+
+    StateStore store;
+    store.addClient(1);
+
+    store.update(Entries({{"a", "1"}, {"b", "2"}, {"c", "3"}}), nullptr);
+    store.update(Entries({{"a", "4"}}), Keys({"b"}));
+    v_int64 version = store.update(Entries({{"d", "5"}}), nullptr);
+
+    /* late joiner has nothing acked */
+    store.addClient(2);
+    OATPP_ASSERT(store.getAckedVersion(2) == 0);
+
+    /* full snapshot - the latest values of the live keys, no removed keys */
+    auto snapshot = store.getDelta(store.getAckedVersion(2));
+    OATPP_ASSERT(snapshot);
+    OATPP_ASSERT(snapshot->version == version);
+    OATPP_ASSERT(snapshot->baseVersion == 0);
+    OATPP_ASSERT(snapshot->entries->size() == 3);
+    OATPP_ASSERT(getValue(snapshot, "a") == "4");
+    OATPP_ASSERT(getValue(snapshot, "c") == "3");
+    OATPP_ASSERT(getValue(snapshot, "d") == "5");
+    OATPP_ASSERT(!getValue(snapshot, "b"));
+    OATPP_ASSERT(snapshot->removed->empty());
+
+    /* empty store has no snapshot */
+    StateStore empty;
+    OATPP_ASSERT(empty.getDelta(0) == nullptr);
+
+  }
+
+}
+
+void StateStoreTest::onRun() {
+
+  OATPP_LOGD(TAG, "delta from acked version...");
+  testDeltaFromAckedVersion();
+
+  OATPP_LOGD(TAG, "tombstones...");
+  testTombstones();
+
+  OATPP_LOGD(TAG, "tombstones compaction...");
+  testTombstonesCompaction();
+
+  OATPP_LOGD(TAG, "late joiner snapshot...");
+  testLateJoinerSnapshot();
+
+}
@@ -0,0 +1,18 @@
+#ifndef Helicopter_test_StateStoreTest_hpp
+#define Helicopter_test_StateStoreTest_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ * StateStore versioning - deltas from the acknowledged version, tombstones of removed keys and
+ * full snapshots for late joiners.
+ */
+class StateStoreTest : public oatpp::test::UnitTest {
+public:
+
+  StateStoreTest():UnitTest("TEST[StateStoreTest]"){}
+  void onRun() override;
+
+};
+
+#endif //Helicopter_test_StateStoreTest_hpp
@@ -0,0 +1,201 @@
+#include "VirtualTransportBenchmark.hpp"
+
+#include "harness/VirtualHarness.hpp"
+
+#include "utils/Metrics.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+  const v_int32 PEERS_PER_SESSION = 100;
+  const v_int32 THREADS = 4;
+  const v_int64 TIMEOUT_MILLIS = 120 * 1000;
+
+  v_int32 getPeersCount() {
+    const char* value = std::getenv("HELICOPTER_HARNESS_PEERS");
+    v_int32 peers = value ? std::atoi(value) : 10000;
+    return std::max(peers, PEERS_PER_SESSION);
+  }
+
+  oatpp::Object<GameConfigDto> createGameConfig() {
+    auto config = GameConfigDto::createShared();
+    config->gameId = "harness";
+    config->maxPeers = PEERS_PER_SESSION;
+    config->maxMessagesPerSecond = 0;
+    config->maxBytesPerSecond = 0;
+    return config;
+  }
+
+  BenchConfig createBenchConfig(v_int32 peers) {
+    BenchConfig config;
+    config.sessions = peers / PEERS_PER_SESSION;
+    config.peers = PEERS_PER_SESSION;
+    config.maxQueuedMessages = 1 << 20;
+    config.mix[BenchConfig::KIND_BROADCAST] = 100;
+    config.mix[BenchConfig::KIND_DIRECT] = 0;
+    config.mix[BenchConfig::KIND_TO_HOST] = 0;
+    config.mix[BenchConfig::KIND_SYNCHRONIZED] = 0;
+    return config;
+  }
+
+  v_uint64 getQueueDrops() {
+    return Metrics::collect().counters[Metrics::QUEUE_OVERFLOW_DROPS];
+  }
+
+  /* each of `senders` first peers of each session sends `messages` broadcasts */
+  void broadcast(VirtualHarness& harness, v_int32 senders, v_int32 messages) {
+    std::minstd_rand random(1);
+    for(v_int32 i = 0; i < messages; i ++) {
+      for(auto& session : harness.getSessions()) {
+        auto peers = session->getPeers();
+        for(v_int32 p = 0; p < senders && p < (v_int32) peers.size(); p ++) {
+          session->sendNext(peers[p], random);
+        }
+      }
+    }
+  }
+
+  void logDeliveries(const char* tag, const char* name, const std::shared_ptr<BenchStats>& stats, v_int64 elapsedMicros) {
+    auto latency = stats->getLatency();
+    OATPP_LOGD(tag, "%s: %lld deliveries in %lld ms - %lld deliveries/s, latency p50=%lldus, p99=%lldus, max=%lldus",
+               name,
+               (long long) stats->getDeliveredMessages(),
+               (long long) (elapsedMicros / 1000),
+               (long long) (elapsedMicros > 0 ? stats->getDeliveredMessages() * 1000000 / elapsedMicros : 0),
+               (long long) latency.p50, (long long) latency.p99, (long long) latency.max);
+  }
+
+  /* host of each session broadcasts to all other peers */
+  void runFanOut(const char* tag, v_int32 peers) {
+
+    VirtualHarness harness(createGameConfig(), THREADS, true);
+    auto benchConfig = createBenchConfig(peers);
+    OATPP_ASSERT(harness.connectSessions(&benchConfig, TIMEOUT_MILLIS));
+
+    auto stats = harness.getStats();
+    auto start = oatpp::base::Environment::getMicroTickCount();
+
+    broadcast(harness, 1, 10);
+
+    bool delivered = harness.waitFor([stats]{
+      return stats->getDeliveredMessages() >= stats->getExpectedDeliveries();
+    }, TIMEOUT_MILLIS);
+
+    logDeliveries(tag, "fan-out", stats, oatpp::base::Environment::getMicroTickCount() - start);
+    OATPP_ASSERT(delivered);
+    OATPP_ASSERT(stats->getExpectedDeliveries() == (v_int64) benchConfig.sessions * 10 * (PEERS_PER_SESSION - 1));
+
+  }
+
+  /* all peers broadcast at once into short queues - every expected delivery is either delivered or counted as dropped */
+  void runQueueing(const char* tag, v_int32 peers) {
+
+    auto gameConfig = createGameConfig();
+    gameConfig->maxQueuedMessages = 16;
+
+    VirtualHarness harness(gameConfig, THREADS, true);
+    auto benchConfig = createBenchConfig(peers);
+    OATPP_ASSERT(harness.connectSessions(&benchConfig, TIMEOUT_MILLIS));
+
+    auto stats = harness.getStats();
+    auto dropsBefore = getQueueDrops();
+    auto start = oatpp::base::Environment::getMicroTickCount();
+
+    broadcast(harness, PEERS_PER_SESSION, 5);
+
+    bool settled = harness.waitFor([stats, dropsBefore]{
+      return stats->getDeliveredMessages() + (v_int64) (getQueueDrops() - dropsBefore) >= stats->getExpectedDeliveries();
+    }, TIMEOUT_MILLIS);
+
+    v_int64 drops = getQueueDrops() - dropsBefore;
+    logDeliveries(tag, "queueing", stats, oatpp::base::Environment::getMicroTickCount() - start);
+    OATPP_LOGD(tag, "queueing: %lld of %lld deliveries dropped on queue overflow",
+               (long long) drops, (long long) stats->getExpectedDeliveries());
+
+    OATPP_ASSERT(settled);
+    OATPP_ASSERT(stats->getDeliveredMessages() + drops == stats->getExpectedDeliveries());
+
+  }
+
+  /* 10% of clients don't answer pings - exactly those are dropped after maxFailedPings rounds */
+  void runPingRules(const char* tag, v_int32 peers) {
+
+    const v_int32 maxFailedPings = 3;
+    const v_int32 silentPerSession = PEERS_PER_SESSION / 10;
+
+    auto gameConfig = createGameConfig();
+    gameConfig->maxFailedPings = maxFailedPings;
+
+    VirtualHarness harness(gameConfig, THREADS, true);
+    auto benchConfig = createBenchConfig(peers);
+    OATPP_ASSERT(harness.connectSessions(&benchConfig, TIMEOUT_MILLIS));
+
+    v_int64 total = (v_int64) benchConfig.sessions * PEERS_PER_SESSION;
+    v_int64 silent = (v_int64) benchConfig.sessions * silentPerSession;
+
+    for(auto& session : harness.getSessions()) {
+      auto sessionPeers = session->getPeers();
+      for(v_int32 i = 1; i <= silentPerSession; i ++) { // host always answers
+        sessionPeers[i]->setAnswerPings(false);
+      }
+    }
+
+    auto registry = harness.getRegistry();
+    auto failedPingsBefore = Metrics::collect().counters[Metrics::FAILED_PINGS];
+
+    for(v_int32 round = 0; round <= maxFailedPings; round ++) {
+
+      auto start = oatpp::base::Environment::getMicroTickCount();
+      v_int64 timestamp = harness.runPingRound((v_int64) gameConfig->pingIntervalMillis * 1000);
+
+      /* wait for pongs of this round before the next round checks them */
+      bool answered = harness.waitFor([registry, timestamp, total, silent]{
+        v_int64 count = 0;
+        for(auto& session : registry->getAllSessions()) {
+          for(auto& peer : session->getAllPeers()) {
+            if(peer->getPingTime(timestamp) >= 0) {
+              count ++;
+            }
+          }
+        }
+        return count >= total - silent;
+      }, TIMEOUT_MILLIS);
+
+      OATPP_LOGD(tag, "ping round %d: %lld peers answered in %lld ms", round, (long long) (total - silent),
+                 (long long) ((oatpp::base::Environment::getMicroTickCount() - start) / 1000));
+      OATPP_ASSERT(answered);
+
+    }
+
+    auto stats = harness.getStats();
+    bool dropped = harness.waitFor([stats, total, silent]{
+      return stats->getConnectedPeers() == total - silent;
+    }, TIMEOUT_MILLIS);
+
+    OATPP_ASSERT(dropped);
+    OATPP_ASSERT(stats->getFailedPeers() == silent);
+    OATPP_ASSERT(Metrics::collect().counters[Metrics::FAILED_PINGS] - failedPingsBefore == (v_uint64) silent * maxFailedPings);
+
+    for(auto& session : harness.getSessions()) {
+      auto sessionPeers = session->getPeers();
+      for(v_int32 i = 0; i < (v_int32) sessionPeers.size(); i ++) {
+        OATPP_ASSERT(sessionPeers[i]->isClosed() == (i >= 1 && i <= silentPerSession));
+      }
+    }
+
+  }
+
+}
+
+void VirtualTransportBenchmark::onRun() {
+
+  v_int32 peers = getPeersCount();
+  OATPP_LOGD(TAG, "%d peers, %d peers per session", peers, PEERS_PER_SESSION);
+
+  runFanOut(TAG, peers);
+  runQueueing(TAG, peers);
+  runPingRules(TAG, peers);
+
+}
@@ -0,0 +1,18 @@
+#ifndef Helicopter_test_VirtualTransportBenchmark_hpp
+#define Helicopter_test_VirtualTransportBenchmark_hpp
+
+#include "oatpp-test/UnitTest.hpp"
+
+/**
+ * Fan-out, queueing and ping rules at scale on the in-process virtual transport harness.
+ * Number of peers - `HELICOPTER_HARNESS_PEERS` environment variable, default - 10000.
+ */
+class VirtualTransportBenchmark : public oatpp::test::UnitTest {
+public:
+
+  VirtualTransportBenchmark():UnitTest("TEST[VirtualTransportBenchmark]"){}
+  void onRun() override;
+
+};
+
+#endif //Helicopter_test_VirtualTransportBenchmark_hpp
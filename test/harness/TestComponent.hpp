@@ -0,0 +1,121 @@
+#ifndef Helicopter_test_harness_TestComponent_hpp
+#define Helicopter_test_harness_TestComponent_hpp
+
+#include "config/Config.hpp"
+#include "config/GamesConfig.hpp"
+
+#include "cluster/Cluster.hpp"
+#include "game/Registry.hpp"
+
+#include "utils/Tracer.hpp"
+#include "utils/Recorder.hpp"
+
+#include "oatpp-websocket/AsyncConnectionHandler.hpp"
+
+#include "oatpp/network/virtual_/Interface.hpp"
+
+#include "oatpp/parser/json/mapping/ObjectMapper.hpp"
+
+#include "oatpp/core/macro/component.hpp"
+
+/**
+ * Components of the in-process server. Same as AppComponent but
+ * without TCP/TLS, cluster and tracing, and with the virtual network interface.
+ */
+class TestComponent {
+private:
+  oatpp::Object<GameConfigDto> m_gameConfig;
+  v_int32 m_threads;
+public:
+
+  TestComponent(const oatpp::Object<GameConfigDto>& gameConfig, v_int32 threads)
+    : m_gameConfig(gameConfig)
+    , m_threads(threads)
+  {}
+
+public:
+
+  /**
+   * In-memory network interface - server and clients connect through pipes instead of sockets.
+   */
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::network::virtual_::Interface>, virtualInterface)([] {
+    return oatpp::network::virtual_::Interface::obtainShared("helicopter-test");
+  }());
+
+  OATPP_CREATE_COMPONENT(oatpp::Object<ConfigDto>, appConfig)([] {
+    auto config = ConfigDto::createShared();
+    config->executorProbeMillis = 0;
+    config->maxPeers = 0;
+    config->maxConnectsPerSecondPerIp = 0;
+    return config;
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Cluster>, cluster)([] {
+    return std::make_shared<Cluster>(nullptr);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<GamesConfig>, gameConfig)([this] {
+    auto config = std::make_shared<GamesConfig>(nullptr);
+    config->putGameConfig(m_gameConfig);
+    return config;
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor)([this] {
+    return std::make_shared<oatpp::async::Executor>(m_threads, 1, 1);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::async::Executor>, controlExecutor)(Constants::COMPONENT_CONTROL, [] {
+    return std::make_shared<oatpp::async::Executor>(1, 1, 1);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<ExecutorPool>, sessionExecutors)([] {
+    OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+    return std::make_shared<ExecutorPool>(executor);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, apiObjectMapper)(Constants::COMPONENT_REST_API, [] {
+    auto mapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    mapper->getSerializer()->getConfig()->includeNullFields = false;
+    return mapper;
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, wsApiObjectMapper)(Constants::COMPONENT_WS_API, [] {
+    auto mapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    mapper->getSerializer()->getConfig()->includeNullFields = false;
+    return mapper;
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<AdmissionControl>, admissionControl)([] {
+    OATPP_COMPONENT(oatpp::Object<ConfigDto>, config);
+    return std::make_shared<AdmissionControl>(config);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Tracer>, tracer)([] {
+    return std::make_shared<Tracer>(nullptr);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Recorder>, recorder)([] {
+    return std::make_shared<Recorder>(nullptr);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Relay>, relay)([] {
+    return Relay::createShared();
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<Registry>, gamesSessionsRegistry)([] {
+    OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+    OATPP_COMPONENT(std::shared_ptr<ExecutorPool>, sessionExecutors);
+    return std::make_shared<Registry>(executor, sessionExecutors);
+  }());
+
+  OATPP_CREATE_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, websocketConnectionHandler)(Constants::COMPONENT_WS_API, [] {
+    OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+    OATPP_COMPONENT(std::shared_ptr<Registry>, registry);
+    auto connectionHandler = oatpp::websocket::AsyncConnectionHandler::createShared(executor);
+    connectionHandler->setSocketInstanceListener(registry);
+    return connectionHandler;
+  }());
+
+};
+
+#endif //Helicopter_test_harness_TestComponent_hpp
@@ -0,0 +1,142 @@
+#include "VirtualHarness.hpp"
+
+#include "utils/Clock.hpp"
+
+#include "controller/HostController.hpp"
+#include "controller/ClientController.hpp"
+
+#include "oatpp/network/virtual_/server/ConnectionProvider.hpp"
+#include "oatpp/network/virtual_/client/ConnectionProvider.hpp"
+
+#include "oatpp/web/server/AsyncHttpConnectionHandler.hpp"
+
+#include <chrono>
+
+VirtualHarness::VirtualHarness(const oatpp::Object<GameConfigDto>& gameConfig, v_int32 threads, bool manualClock)
+  : m_components(gameConfig, threads)
+  , m_gameId(gameConfig->gameId)
+  , m_manualClock(manualClock)
+  , m_stats(std::make_shared<BenchStats>())
+{
+
+  if(m_manualClock) {
+    Clock::setManual(0);
+  }
+
+  OATPP_COMPONENT(std::shared_ptr<oatpp::network::virtual_::Interface>, virtualInterface);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, websocketConnectionHandler, Constants::COMPONENT_WS_API);
+
+  /* host and client APIs on one server - as Runner does when both are configured on the same port */
+  auto router = oatpp::web::server::HttpRouter::createShared();
+  router->addController(std::make_shared<HostController>(websocketConnectionHandler));
+  router->addController(std::make_shared<ClientController>(websocketConnectionHandler));
+
+  m_server = oatpp::network::Server::createShared(
+    oatpp::network::virtual_::server::ConnectionProvider::createShared(virtualInterface),
+    oatpp::web::server::AsyncHttpConnectionHandler::createShared(router, executor)
+  );
+
+  m_serverThread = std::thread([this]{
+    m_server->run();
+  });
+
+  m_connector = oatpp::websocket::Connector::createShared(
+    oatpp::network::virtual_::client::ConnectionProvider::createShared(virtualInterface));
+
+  m_stats->startWindow();
+
+}
+
+VirtualHarness::~VirtualHarness() {
+
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, controlExecutor, Constants::COMPONENT_CONTROL);
+
+  closeSessions(10000);
+
+  m_server->stop();
+  m_serverThread.join();
+
+  executor->waitTasksFinished(std::chrono::seconds(5));
+  executor->stop();
+  controlExecutor->stop();
+  executor->join();
+  controlExecutor->join();
+
+  if(m_manualClock) {
+    Clock::setSystem();
+  }
+
+}
+
+bool VirtualHarness::connectSessions(const BenchConfig* config, v_int64 timeoutMillis) {
+
+  OATPP_COMPONENT(std::shared_ptr<oatpp::async::Executor>, executor);
+  OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper, Constants::COMPONENT_WS_API);
+
+  v_int64 expectedPeers = m_stats->getConnectedPeers();
+  v_int64 failedBefore = m_stats->getFailedPeers();
+  for(v_int32 i = 0; i < config->sessions; i ++) {
+    auto sessionId = oatpp::String("session-" + std::to_string(m_sessions.size()));
+    auto session = std::make_shared<BenchSession>(config, m_gameId, sessionId, executor, objectMapper, m_connector, m_stats);
+    m_sessions.push_back(session);
+    session->connect(m_connector);
+    expectedPeers += config->peers;
+  }
+
+  auto stats = m_stats;
+  return waitFor([stats, expectedPeers, failedBefore]{
+    return stats->getConnectedPeers() + stats->getFailedPeers() - failedBefore >= expectedPeers;
+  }, timeoutMillis) && m_stats->getConnectedPeers() == expectedPeers;
+
+}
+
+bool VirtualHarness::closeSessions(v_int64 timeoutMillis) {
+
+  OATPP_COMPONENT(std::shared_ptr<AdmissionControl>, admission);
+  auto registry = getRegistry();
+
+  for(auto& session : m_sessions) {
+    session->close();
+  }
+  m_sessions.clear();
+
+  return waitFor([&admission, &registry]{
+    return admission->getPeersCount() == 0 && registry->getAllSessions().empty();
+  }, timeoutMillis);
+
+}
+
+bool VirtualHarness::waitFor(const std::function<bool()>& condition, v_int64 timeoutMillis) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+  while(!condition()) {
+    if(std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+v_int64 VirtualHarness::runPingRound(v_int64 advanceMicros) {
+  Clock::advance(advanceMicros);
+  auto game = getRegistry()->getGameById(m_gameId);
+  if(game) {
+    game->runPingRound();
+  }
+  return Clock::getMicroTickCount();
+}
+
+const std::vector<std::shared_ptr<BenchSession>>& VirtualHarness::getSessions() {
+  return m_sessions;
+}
+
+std::shared_ptr<BenchStats> VirtualHarness::getStats() {
+  return m_stats;
+}
+
+std::shared_ptr<Registry> VirtualHarness::getRegistry() {
+  OATPP_COMPONENT(std::shared_ptr<Registry>, registry);
+  return registry;
+}
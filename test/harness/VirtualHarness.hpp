@@ -0,0 +1,95 @@
+#ifndef Helicopter_test_harness_VirtualHarness_hpp
+#define Helicopter_test_harness_VirtualHarness_hpp
+
+#include "./TestComponent.hpp"
+
+#include "BenchSession.hpp"
+
+#include "oatpp/web/server/HttpRouter.hpp"
+#include "oatpp/network/Server.hpp"
+
+#include <functional>
+#include <thread>
+
+/**
+ * In-process test harness.
+ * Full server stack - HTTP, WebSocket handshake, Registry, Sessions, Peers - and simulated peers of the load generator
+ * run in one process connected through oatpp's virtual network interface.
+ * With `manualClock` the ping logic runs on manual `Clock` and ping rounds are run by the test - `runPingRound()`.
+ */
+class VirtualHarness {
+private:
+  TestComponent m_components;
+  oatpp::String m_gameId;
+  bool m_manualClock;
+  std::shared_ptr<BenchStats> m_stats;
+  std::shared_ptr<oatpp::network::Server> m_server;
+  std::thread m_serverThread;
+  std::shared_ptr<oatpp::websocket::Connector> m_connector;
+  std::vector<std::shared_ptr<BenchSession>> m_sessions;
+public:
+
+  /**
+   * Constructor. Starts the server.
+   * @param gameConfig - config of the only game served.
+   * @param threads - processor threads of the server's executor. Simulated peers run on the same executor.
+   * @param manualClock - drive ping logic by manual clock.
+   */
+  VirtualHarness(const oatpp::Object<GameConfigDto>& gameConfig, v_int32 threads, bool manualClock);
+
+  /**
+   * Close all peers, stop the server and executors.
+   */
+  ~VirtualHarness();
+
+  /**
+   * Create sessions and wait till all peers are connected.
+   * @param config - `sessions` and `peers` of the load generator config are used. `gameIds` are ignored.
+   * @param timeoutMillis
+   * @return - `true` if all peers connected.
+   */
+  bool connectSessions(const BenchConfig* config, v_int64 timeoutMillis);
+
+  /**
+   * Close all simulated peers and wait till server side sessions are destroyed.
+   * @param timeoutMillis
+   * @return - `false` on timeout.
+   */
+  bool closeSessions(v_int64 timeoutMillis);
+
+  /**
+   * Wait till condition is true.
+   * @param condition
+   * @param timeoutMillis
+   * @return - `false` on timeout.
+   */
+  static bool waitFor(const std::function<bool()>& condition, v_int64 timeoutMillis);
+
+  /**
+   * Advance manual clock and run ping round of the game.
+   * @param advanceMicros
+   * @return - timestamp of the ping round.
+   */
+  v_int64 runPingRound(v_int64 advanceMicros);
+
+  /**
+   * Get all simulated sessions.
+   * @return
+   */
+  const std::vector<std::shared_ptr<BenchSession>>& getSessions();
+
+  /**
+   * Get counters of simulated peers.
+   * @return
+   */
+  std::shared_ptr<BenchStats> getStats();
+
+  /**
+   * Get server side registry.
+   * @return
+   */
+  std::shared_ptr<Registry> getRegistry();
+
+};
+
+#endif //Helicopter_test_harness_VirtualHarness_hpp
@@ -1,12 +1,24 @@
 
 #include "WSTest.hpp"
+#include "GameLimitsBenchmark.hpp"
+#include "VirtualTransportBenchmark.hpp"
+#include "SoakTest.hpp"
+#include "StateStoreTest.hpp"
+#include "HashRingTest.hpp"
+#include "SpatialGridTest.hpp"
 
 #include "oatpp-test/UnitTest.hpp"
 #include <iostream>
 
 
 void runTests() {
+  OATPP_RUN_TEST(StateStoreTest);
+  OATPP_RUN_TEST(HashRingTest);
+  OATPP_RUN_TEST(SpatialGridTest);
   OATPP_RUN_TEST(WSTest);
+  OATPP_RUN_TEST(GameLimitsBenchmark);
+  OATPP_RUN_TEST(VirtualTransportBenchmark);
+  OATPP_RUN_TEST(SoakTest);
 }
 
 int main() {